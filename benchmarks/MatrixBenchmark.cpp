@@ -0,0 +1,270 @@
+#include "NickSV/Tools/Matrix.h"
+
+
+#include <random>
+
+#include <benchmark/benchmark.h>
+
+
+// Square matrix product assigned to MatrixT: Gemm() dispatch against
+// element by element evaluation of MatrixMultOp (the path every product
+// took before). FLOPS counter is 2*n^3 per iteration.
+// Element-wise series stops at 1024, 2048 takes minutes there.
+// Parallel series splits Gemm() rows between caller and
+// ThreadPool::Global() workers (hardware_concurrency() - 1).
+//
+// 3 * A + B assigned to MatrixT by AtLinear() loop against the flat
+// index loop calling AtUnsafe(index / cols, index % cols) it replaced.
+//
+// 4x4 transform chain A * B * v + v by fixed-size MatrixT<T, 4, 4>
+// (inline storage, unrolled assignment) against dynamic MatrixT.
+//
+// Transpose of power of 2 sized matrix reads source column-wise:
+// dense rows map to the same cache sets, MatrixAlignedLayout pads them.
+// Transpose of row-major matrix into MatrixColMajorLayout is a flat copy.
+//
+// Transpose(A) * B by storage order of A: GEMM packing reads
+// operands in their storage order.
+//
+// C + A * B accumulated into C: operator= (product evaluated into
+// temporary, sum into buffer swapped with C) against
+// NoAlias(C) += A * B (Gemm() accumulates into rows of C).
+
+using namespace NickSV::Tools;
+
+
+template<typename ValueT>
+static MatrixT<ValueT> random_matrix(MatrixSizeType size, unsigned seed)
+{
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<double> dist(-1.0, 1.0);
+  MatrixT<ValueT> mat(size, size);
+  for (MatrixSizeType y = 0; y < size; ++y)
+    for (MatrixSizeType x = 0; x < size; ++x)
+      mat.AtUnsafe(y, x) = static_cast<ValueT>(dist(gen));
+  return mat;
+}
+
+static void set_flops(benchmark::State& state, MatrixSizeType size)
+{
+  const double n = static_cast<double>(size);
+  state.counters["FLOPS"] = benchmark::Counter(2 * n * n * n,
+    benchmark::Counter::kIsIterationInvariantRate, benchmark::Counter::OneK::kIs1000);
+}
+
+
+template<typename ValueT>
+static void BM_MatrixMultGemm(benchmark::State& state)
+{
+  const auto size = static_cast<MatrixSizeType>(state.range(0));
+  auto matA = random_matrix<ValueT>(size, 1);
+  auto matB = random_matrix<ValueT>(size, 2);
+  for (auto _ : state)
+  {
+    MatrixT<ValueT> matC = matA * matB;
+    benchmark::DoNotOptimize(matC.AtUnsafe(0, 0));
+  }
+  set_flops(state, size);
+}
+
+template<typename ValueT>
+static void BM_MatrixMultElementwise(benchmark::State& state)
+{
+  const auto size = static_cast<MatrixSizeType>(state.range(0));
+  auto matA = random_matrix<ValueT>(size, 1);
+  auto matB = random_matrix<ValueT>(size, 2);
+  MatrixT<ValueT> matC(size, size);
+  for (auto _ : state)
+  {
+    auto product = matA * matB;
+    for (MatrixSizeType y = 0; y < size; ++y)
+      for (MatrixSizeType x = 0; x < size; ++x)
+        matC.AtUnsafe(y, x) = product.AtUnsafe(y, x);
+    benchmark::DoNotOptimize(matC.AtUnsafe(0, 0));
+  }
+  set_flops(state, size);
+}
+
+template<typename ValueT>
+static void BM_MatrixMultParallel(benchmark::State& state)
+{
+  const auto size = static_cast<MatrixSizeType>(state.range(0));
+  auto matA = random_matrix<ValueT>(size, 1);
+  auto matB = random_matrix<ValueT>(size, 2);
+  const MatrixParallelism parallelism(0);
+  for (auto _ : state)
+  {
+    MatrixT<ValueT> matC(matA * matB, parallelism);
+    benchmark::DoNotOptimize(matC.AtUnsafe(0, 0));
+  }
+  set_flops(state, size);
+}
+
+
+BENCHMARK_TEMPLATE(BM_MatrixMultGemm, double)->RangeMultiplier(2)->Range(64, 2048)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_MatrixMultGemm, float)->RangeMultiplier(2)->Range(64, 2048)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_MatrixMultParallel, double)->RangeMultiplier(2)->Range(64, 2048)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_MatrixMultParallel, float)->RangeMultiplier(2)->Range(64, 2048)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_MatrixMultElementwise, double)->RangeMultiplier(2)->Range(64, 1024)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_MatrixMultElementwise, float)->RangeMultiplier(2)->Range(64, 1024)->Unit(benchmark::kMillisecond);
+
+
+template<typename ValueT>
+static void BM_MatrixAssignLinear(benchmark::State& state)
+{
+  const auto size = static_cast<MatrixSizeType>(state.range(0));
+  auto matA = random_matrix<ValueT>(size, 1);
+  auto matB = random_matrix<ValueT>(size, 2);
+  MatrixT<ValueT> matC(size, size);
+  for (auto _ : state)
+  {
+    matC = ValueT(3) * matA + matB;
+    benchmark::DoNotOptimize(matC.AtUnsafe(0, 0));
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(size * size));
+}
+
+template<typename ValueT>
+static void BM_MatrixAssignIndexed(benchmark::State& state)
+{
+  const auto size = static_cast<MatrixSizeType>(state.range(0));
+  auto matA = random_matrix<ValueT>(size, 1);
+  auto matB = random_matrix<ValueT>(size, 2);
+  MatrixT<ValueT> matC(size, size);
+  for (auto _ : state)
+  {
+    auto matEx = ValueT(3) * matA + matB;
+    MatrixT<ValueT> matBuff(size, size);
+    for (MatrixSizeType index = 0; index < size * size; ++index)
+      matBuff.AtUnsafe(index / size, index % size) = matEx.AtUnsafe(index / size, index % size);
+    std::swap(matC, matBuff);
+    benchmark::DoNotOptimize(matC.AtUnsafe(0, 0));
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(size * size));
+}
+
+
+BENCHMARK_TEMPLATE(BM_MatrixAssignLinear, double)->RangeMultiplier(4)->Range(64, 2048);
+BENCHMARK_TEMPLATE(BM_MatrixAssignIndexed, double)->RangeMultiplier(4)->Range(64, 2048);
+BENCHMARK_TEMPLATE(BM_MatrixAssignLinear, float)->RangeMultiplier(4)->Range(64, 2048);
+BENCHMARK_TEMPLATE(BM_MatrixAssignIndexed, float)->RangeMultiplier(4)->Range(64, 2048);
+
+
+template<typename MatrixType, typename VectorType>
+static void transform_chain(benchmark::State& state)
+{
+  auto matDynA = random_matrix<double>(4, 1);
+  auto matDynB = random_matrix<double>(4, 2);
+  MatrixType matA = matDynA;
+  MatrixType matB = matDynB;
+  VectorType vec = MatrixT<double>{{1}, {2}, {3}, {4}};
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(matA.AtUnsafe(0, 0));
+    VectorType result = matA * matB * vec + vec;
+    benchmark::DoNotOptimize(result.AtUnsafe(0, 0));
+  }
+}
+
+static void BM_MatrixTransformFixed(benchmark::State& state)
+{
+  transform_chain<MatrixT<double, 4, 4>, MatrixT<double, 4, 1>>(state);
+}
+
+static void BM_MatrixTransformDynamic(benchmark::State& state)
+{
+  transform_chain<MatrixT<double>, MatrixT<double>>(state);
+}
+
+
+BENCHMARK(BM_MatrixTransformFixed);
+BENCHMARK(BM_MatrixTransformDynamic);
+
+
+template<typename MatrixType>
+static void BM_MatrixTranspose(benchmark::State& state)
+{
+  const auto size = static_cast<MatrixSizeType>(state.range(0));
+  MatrixType matA = random_matrix<double>(size, 1);
+  MatrixType matC(size, size);
+  for (auto _ : state)
+  {
+    matC = Transpose(matA);
+    benchmark::DoNotOptimize(matC.AtUnsafe(0, 0));
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(size * size));
+}
+
+using AlignedMatrix = MatrixT<double, MatrixDynamicSize, MatrixDynamicSize, MatrixAlignedLayout<>>;
+
+template<typename MatrixType>
+static void BM_MatrixTransposeInto(benchmark::State& state)
+{
+  const auto size = static_cast<MatrixSizeType>(state.range(0));
+  auto matA = random_matrix<double>(size, 1);
+  MatrixType matC(size, size);
+  for (auto _ : state)
+  {
+    matC = Transpose(matA);
+    benchmark::DoNotOptimize(matC.AtUnsafe(0, 0));
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(size * size));
+}
+
+using ColMajorMatrix = MatrixT<double, MatrixDynamicSize, MatrixDynamicSize, MatrixColMajorLayout>;
+
+BENCHMARK_TEMPLATE(BM_MatrixTranspose, MatrixT<double>)->RangeMultiplier(4)->Range(256, 4096);
+BENCHMARK_TEMPLATE(BM_MatrixTranspose, AlignedMatrix)->RangeMultiplier(4)->Range(256, 4096);
+BENCHMARK_TEMPLATE(BM_MatrixTransposeInto, ColMajorMatrix)->RangeMultiplier(4)->Range(256, 4096);
+
+
+template<typename MatrixType>
+static void BM_MatrixMultTransposed(benchmark::State& state)
+{
+  const auto size = static_cast<MatrixSizeType>(state.range(0));
+  MatrixType matA = random_matrix<double>(size, 1);
+  auto matB = random_matrix<double>(size, 2);
+  for (auto _ : state)
+  {
+    MatrixT<double> matC = Transpose(matA) * matB;
+    benchmark::DoNotOptimize(matC.AtUnsafe(0, 0));
+  }
+  set_flops(state, size);
+}
+
+BENCHMARK_TEMPLATE(BM_MatrixMultTransposed, MatrixT<double>)->RangeMultiplier(4)->Range(64, 1024)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_MatrixMultTransposed, ColMajorMatrix)->RangeMultiplier(4)->Range(64, 1024)->Unit(benchmark::kMillisecond);
+
+
+template<typename ValueT>
+static void BM_MatrixAccumulateAssign(benchmark::State& state)
+{
+  const auto size = static_cast<MatrixSizeType>(state.range(0));
+  auto matA = random_matrix<ValueT>(size, 1);
+  auto matB = random_matrix<ValueT>(size, 2);
+  auto matC = random_matrix<ValueT>(size, 3);
+  for (auto _ : state)
+  {
+    matC = matC + matA * matB;
+    benchmark::DoNotOptimize(matC.AtUnsafe(0, 0));
+  }
+  set_flops(state, size);
+}
+
+template<typename ValueT>
+static void BM_MatrixAccumulateNoAlias(benchmark::State& state)
+{
+  const auto size = static_cast<MatrixSizeType>(state.range(0));
+  auto matA = random_matrix<ValueT>(size, 1);
+  auto matB = random_matrix<ValueT>(size, 2);
+  auto matC = random_matrix<ValueT>(size, 3);
+  for (auto _ : state)
+  {
+    NoAlias(matC) += matA * matB;
+    benchmark::DoNotOptimize(matC.AtUnsafe(0, 0));
+  }
+  set_flops(state, size);
+}
+
+BENCHMARK_TEMPLATE(BM_MatrixAccumulateAssign, double)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK_TEMPLATE(BM_MatrixAccumulateNoAlias, double)->RangeMultiplier(4)->Range(16, 1024);
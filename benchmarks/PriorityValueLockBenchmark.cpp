@@ -0,0 +1,114 @@
+#include "NickSV/Tools/PriorityValueLock.h"
+
+
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <math.h>
+
+#include <benchmark/benchmark.h>
+
+
+// Interactive and background threads contend on the same few keys,
+// latency of interactive Lock() calls is reported as p50/p99 counters.
+
+constexpr static size_t highPriorityThreadC = 2;
+constexpr static size_t lowPriorityThreadC = 6;
+constexpr static size_t opsPerThread = 200;
+constexpr static uint32_t keyC = 2;
+
+static double short_operation()
+{
+  double sum = 0;
+  for (size_t i = 0; i < 2000; ++i)
+  {
+    benchmark::DoNotOptimize(sum += cos(sum));
+  }
+  return sum;
+}
+
+static double percentile(std::vector<double>& values, double ratio)
+{
+  if(values.empty())
+    return 0;
+  std::sort(values.begin(), values.end());
+  auto index = static_cast<size_t>(ratio * static_cast<double>(values.size() - 1));
+  return values[index];
+}
+
+template<typename LockType, typename LockFunc>
+static void priority_mixed_load(benchmark::State& state, LockFunc lockFunc)
+{
+  using namespace std::chrono;
+  std::vector<double> highLatencies;
+  std::vector<double> lowLatencies;
+  for (auto a : state)
+  {
+    LockType vLock;
+    std::vector<std::vector<double>> latencies(highPriorityThreadC + lowPriorityThreadC);
+    std::vector<std::thread> threads;
+    for (size_t th = 0; th < latencies.size(); ++th)
+    {
+      threads.emplace_back([&, th]()
+      {
+        const bool isHigh = th < highPriorityThreadC;
+        latencies[th].reserve(opsPerThread);
+        for (size_t i = 0; i < opsPerThread; ++i)
+        {
+          uint32_t key = static_cast<uint32_t>((th + i) % keyC);
+          auto start = steady_clock::now();
+          lockFunc(vLock, key, isHigh);
+          latencies[th].push_back(duration<double, std::micro>(steady_clock::now() - start).count());
+          benchmark::DoNotOptimize(short_operation());
+          vLock.Unlock(key);
+        }
+      });
+    }
+    for (auto& thread : threads)
+      thread.join();
+    for (size_t th = 0; th < latencies.size(); ++th)
+    {
+      auto& target = (th < highPriorityThreadC) ? highLatencies : lowLatencies;
+      target.insert(target.end(), latencies[th].begin(), latencies[th].end());
+    }
+  }
+  state.counters["high_p50_us"] = percentile(highLatencies, 0.50);
+  state.counters["high_p99_us"] = percentile(highLatencies, 0.99);
+  state.counters["low_p99_us"] = percentile(lowLatencies, 0.99);
+}
+
+
+
+
+//cppcheck-suppress constParameterCallback
+static void BM_PriorityValueLockMixedLoad(benchmark::State& state) {
+  using LockType = NickSV::Tools::PriorityValueLock<uint32_t>;
+  priority_mixed_load<LockType>(state, [](LockType& vLock, uint32_t key, bool isHigh)
+  {
+    vLock.Lock(key, isHigh ? 10 : 0);
+  });
+}
+
+BENCHMARK(BM_PriorityValueLockMixedLoad)->Unit(benchmark::kMillisecond)->Iterations(20);
+
+//cppcheck-suppress constParameterCallback
+static void BM_PriorityValueLockNoPriorityMixedLoad(benchmark::State& state) {
+  using LockType = NickSV::Tools::PriorityValueLock<uint32_t>;
+  priority_mixed_load<LockType>(state, [](LockType& vLock, uint32_t key, bool)
+  {
+    vLock.Lock(key);
+  });
+}
+
+BENCHMARK(BM_PriorityValueLockNoPriorityMixedLoad)->Unit(benchmark::kMillisecond)->Iterations(20);
+
+//cppcheck-suppress constParameterCallback
+static void BM_DynamicValueLockMixedLoad(benchmark::State& state) {
+  using LockType = NickSV::Tools::DynamicValueLock<uint32_t>;
+  priority_mixed_load<LockType>(state, [](LockType& vLock, uint32_t key, bool)
+  {
+    vLock.Lock(key);
+  });
+}
+
+BENCHMARK(BM_DynamicValueLockMixedLoad)->Unit(benchmark::kMillisecond)->Iterations(20);
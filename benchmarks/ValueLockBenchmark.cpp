@@ -339,4 +339,52 @@ static void BM_FakeValueLockAllTime(benchmark::State& state) {
 BENCHMARK(BM_FakeValueLockAllTime)->Unit(benchmark::kMillisecond)->Iterations(50);
 
 
+
+
+
+
+// One thread locks the same few values in a tight loop,
+// compared with bare std::mutex lock/unlock.
+template<typename LockType>
+static void warm_values_loop(benchmark::State& state)
+{
+  LockType vLock;
+  uint32_t value = 0;
+  for (auto a : state)
+  {
+    vLock.Lock(value);
+    benchmark::ClobberMemory();
+    vLock.Unlock(value);
+    value = (value + 1) % 4;
+  }
+}
+
+//cppcheck-suppress constParameterCallback
+static void BM_ValueLockWarmValues(benchmark::State& state) {
+  warm_values_loop<NickSV::Tools::ValueLock<uint32_t, 64>>(state);
+}
+
+BENCHMARK(BM_ValueLockWarmValues);
+
+//cppcheck-suppress constParameterCallback
+static void BM_RecursiveValueLockWarmValues(benchmark::State& state) {
+  warm_values_loop<NickSV::Tools::ValueLock<uint32_t, 64, NickSV::Tools::RecursiveValueLockPolicy>>(state);
+}
+
+BENCHMARK(BM_RecursiveValueLockWarmValues);
+
+//cppcheck-suppress constParameterCallback
+static void BM_MutexWarmValues(benchmark::State& state) {
+  std::mutex mtx;
+  for (auto a : state)
+  {
+    mtx.lock();
+    benchmark::ClobberMemory();
+    mtx.unlock();
+  }
+}
+
+BENCHMARK(BM_MutexWarmValues);
+
+
 BENCHMARK_MAIN();
\ No newline at end of file
@@ -0,0 +1,89 @@
+#ifndef _NICKSV_VALUELOCK_COMPETITORS
+#define _NICKSV_VALUELOCK_COMPETITORS
+#pragma once
+
+
+#include "NickSV/Tools/Definitions.h"
+
+
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <array>
+#include <functional>
+
+
+// Straightforward alternatives to ValueLock with the same
+// Lock(value)/Unlock(value) interface, measured by the workload
+// benchmark next to the library locks (FakeValueLock is the
+// single global mutex variant).
+
+
+/**
+ * @brief std::unordered_map<ValueT, std::mutex> under a global mutex,
+ *        the "map of mutexes" from ValueLock description.
+ *        Mutexes are created on first use and never removed.
+ */
+template<typename ValueT>
+class MutexMapLock
+{
+public:
+  using ValueType = ValueT;
+
+  void Lock(const ValueType& value)
+  {
+    FindMutex(value).lock();
+  }
+
+  void Unlock(const ValueType& value)
+  {
+    FindMutex(value).unlock();
+  }
+
+private:
+  // Map nodes are never moved, so the mutex
+  // can be used after the global lock is released
+  std::mutex& FindMutex(const ValueType& value)
+  {
+    std::lock_guard<std::mutex> lockGuard(m_mtx);
+    return m_mapMutexes[value];
+  }
+
+  std::unordered_map<ValueType, std::mutex> m_mapMutexes;
+  std::mutex m_mtx;
+};
+
+
+/**
+ * @brief Fixed array of std::shared_mutex indexed by value hash,
+ *        different values can share a stripe.
+ */
+template<typename ValueT, size_t stripeCount = 64>
+class StripedSharedMutexLock
+{
+public:
+  using ValueType = ValueT;
+
+  void Lock(const ValueType& value) { StripeOf(value).lock(); }
+  void Unlock(const ValueType& value) { StripeOf(value).unlock(); }
+  void LockShared(const ValueType& value) { StripeOf(value).lock_shared(); }
+  void UnlockShared(const ValueType& value) { StripeOf(value).unlock_shared(); }
+
+private:
+  struct alignas(NICKSV_CACHE_LINE_SIZE) Stripe
+  {
+    std::shared_mutex Mutex;
+  };
+
+  std::shared_mutex& StripeOf(const ValueType& value)
+  {
+    return m_aStripes[std::hash<ValueType>{}(value) % stripeCount].Mutex;
+  }
+
+  std::array<Stripe, stripeCount> m_aStripes;
+};
+
+
+
+
+#endif // _NICKSV_VALUELOCK_COMPETITORS
@@ -0,0 +1,273 @@
+#ifndef _NICKSV_VALUELOCK_WORKLOAD
+#define _NICKSV_VALUELOCK_WORKLOAD
+#pragma once
+
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <vector>
+#include <map>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include <benchmark/benchmark.h>
+
+
+// Shared parts of ValueLock workload benchmarks:
+// key distributions, persistent worker pool and latency statistics.
+
+
+enum class KeyDistribution
+{
+  Uniform,  // every key is equally likely
+  Zipf,     // key k has weight 1/(k+1)^0.99
+  HotSpot   // 90% of operations hit 10% of keys
+};
+
+inline const char* key_distribution_name(KeyDistribution distribution)
+{
+  switch (distribution)
+  {
+  case KeyDistribution::Uniform: return "Uniform";
+  case KeyDistribution::Zipf:    return "Zipf";
+  case KeyDistribution::HotSpot: return "HotSpot";
+  default:                       return "Unknown";
+  }
+}
+
+
+/**
+ * @brief Draws key indices in [0, keyCount) from given distribution,
+ *        one generator per worker thread.
+ */
+class KeyGenerator
+{
+public:
+  constexpr static double ZipfExponent = 0.99;
+  constexpr static double HotSpotOpsRatio = 0.9;
+  constexpr static double HotSpotKeysRatio = 0.1;
+
+  KeyGenerator(KeyDistribution distribution, uint32_t keyCount, uint32_t seed)
+    : m_Distribution(distribution), m_nKeyCount(keyCount), m_Engine(seed)
+  {
+    if(m_Distribution == KeyDistribution::Zipf)
+    {
+      m_vecZipfCdf.resize(keyCount);
+      double sum = 0;
+      for (uint32_t k = 0; k < keyCount; ++k)
+        m_vecZipfCdf[k] = (sum += 1.0 / std::pow(static_cast<double>(k + 1), ZipfExponent));
+      for (auto& cdf : m_vecZipfCdf)
+        cdf /= sum;
+    }
+  }
+
+  uint32_t operator()()
+  {
+    switch (m_Distribution)
+    {
+    case KeyDistribution::Zipf:
+    {
+      auto iter = std::upper_bound(m_vecZipfCdf.begin(), m_vecZipfCdf.end(), m_Uniform(m_Engine));
+      return static_cast<uint32_t>(std::min<size_t>(static_cast<size_t>(iter - m_vecZipfCdf.begin()), m_nKeyCount - 1));
+    }
+    case KeyDistribution::HotSpot:
+    {
+      auto hotKeyCount = std::max<uint32_t>(1, static_cast<uint32_t>(m_nKeyCount * HotSpotKeysRatio));
+      if(m_Uniform(m_Engine) < HotSpotOpsRatio || hotKeyCount == m_nKeyCount)
+        return static_cast<uint32_t>(m_Engine() % hotKeyCount);
+      return hotKeyCount + static_cast<uint32_t>(m_Engine() % (m_nKeyCount - hotKeyCount));
+    }
+    case KeyDistribution::Uniform:
+    default:
+      return static_cast<uint32_t>(m_Engine() % m_nKeyCount);
+    }
+  }
+
+private:
+  KeyDistribution m_Distribution;
+  uint32_t m_nKeyCount;
+  std::mt19937 m_Engine;
+  std::uniform_real_distribution<double> m_Uniform{0.0, 1.0};
+  std::vector<double> m_vecZipfCdf;
+};
+
+
+/**
+ * @brief Threads started once and reused by every Run(),
+ *        so thread creation is not measured.
+ */
+class WorkerPool
+{
+public:
+  explicit WorkerPool(size_t threadCount)
+  {
+    for (size_t i = 0; i < threadCount; ++i)
+      m_vecThreads.emplace_back([this, i]{ WorkerLoop(i); });
+  }
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  ~WorkerPool()
+  {
+    {
+      std::lock_guard<std::mutex> lockGuard(m_mtx);
+      m_bStop = true;
+    }
+    m_cvStart.notify_all();
+    for (auto& thread : m_vecThreads)
+      thread.join();
+  }
+
+  size_t Size() const noexcept { return m_vecThreads.size(); }
+
+  // Invokes task(workerIndex) on every worker and waits for all of them
+  void Run(const std::function<void(size_t)>& task)
+  {
+    std::unique_lock<std::mutex> uLock(m_mtx);
+    m_pTask = &task;
+    m_nRunning = m_vecThreads.size();
+    ++m_nGeneration;
+    m_cvStart.notify_all();
+    m_cvDone.wait(uLock, [this]{ return m_nRunning == 0; });
+    m_pTask = nullptr;
+  }
+
+private:
+  void WorkerLoop(size_t index)
+  {
+    uint64_t seenGeneration = 0;
+    std::unique_lock<std::mutex> uLock(m_mtx);
+    while (true)
+    {
+      m_cvStart.wait(uLock, [&]{ return m_bStop || m_nGeneration != seenGeneration; });
+      if(m_bStop)
+        return;
+      seenGeneration = m_nGeneration;
+      auto pTask = m_pTask;
+      uLock.unlock();
+      (*pTask)(index);
+      uLock.lock();
+      if(--m_nRunning == 0)
+        m_cvDone.notify_one();
+    }
+  }
+
+  std::vector<std::thread> m_vecThreads;
+  std::mutex m_mtx;
+  std::condition_variable m_cvStart;
+  std::condition_variable m_cvDone;
+  const std::function<void(size_t)>* m_pTask = nullptr;
+  uint64_t m_nGeneration = 0;
+  size_t m_nRunning = 0;
+  bool m_bStop = false;
+};
+
+
+// Busy work of given length done inside the critical section
+inline void critical_section(int64_t length)
+{
+  uint64_t acc = 0;
+  for (int64_t i = 0; i < length; ++i)
+    benchmark::DoNotOptimize(acc += static_cast<uint64_t>(i));
+}
+
+inline double latency_percentile(std::vector<double>& latencies, double ratio)
+{
+  if(latencies.empty())
+    return 0;
+  auto index = static_cast<size_t>(ratio * static_cast<double>(latencies.size() - 1));
+  std::nth_element(latencies.begin(), latencies.begin() + static_cast<std::ptrdiff_t>(index), latencies.end());
+  return latencies[index];
+}
+
+constexpr static int64_t workloadMaxThreads = 64;
+constexpr static uint32_t workloadKeyCount = 1024;
+
+// Thread counts 1, 2, 4 ... up to the hardware concurrency
+// (at least 4, so contention shows up on small machines,
+// at most workloadMaxThreads) crossed with short and long
+// critical sections.
+inline void workload_arguments(benchmark::internal::Benchmark* pBenchmark)
+{
+  const int64_t maxThreads = std::min<int64_t>(workloadMaxThreads,
+    std::max<int64_t>(4, std::thread::hardware_concurrency()));
+  for (int64_t csLength : {16, 1024})
+    for (int64_t threads = 1; threads <= maxThreads; threads *= 2)
+      pBenchmark->Args({threads, csLength});
+}
+
+
+/**
+ * @brief Runs lockFunc/unlockFunc from a persistent pool
+ *        of state.range(0) workers with critical section of
+ *        state.range(1) length, keys are taken from distribution.
+ *
+ * Reports ops/s, acquire latency p50/p99/p999 in nanoseconds
+ * and scaling efficiency: throughput per thread relative to
+ * single thread run of the same series (kept in baselines
+ * by critical section length, workload_arguments() runs it first).
+ */
+template<typename LockFunc, typename UnlockFunc>
+void run_value_lock_workload(benchmark::State& state, KeyDistribution distribution,
+  std::map<int64_t, double>& baselines, LockFunc lockFunc, UnlockFunc unlockFunc)
+{
+  using namespace std::chrono;
+  constexpr static size_t opsPerWorker = 2000;
+
+  const auto threadCount = static_cast<size_t>(state.range(0));
+  const auto csLength = state.range(1);
+  WorkerPool pool(threadCount);
+  std::vector<KeyGenerator> generators;
+  for (size_t i = 0; i < threadCount; ++i)
+    generators.emplace_back(distribution, workloadKeyCount, static_cast<uint32_t>(i + 1));
+  std::vector<std::vector<double>> latencies(threadCount);
+
+  std::function<void(size_t)> task = [&](size_t worker)
+  {
+    auto& workerLatencies = latencies[worker];
+    auto& generator = generators[worker];
+    for (size_t i = 0; i < opsPerWorker; ++i)
+    {
+      auto key = generator();
+      auto start = steady_clock::now();
+      lockFunc(key);
+      workerLatencies.push_back(static_cast<double>(duration_cast<nanoseconds>(steady_clock::now() - start).count()));
+      critical_section(csLength);
+      unlockFunc(key);
+    }
+  };
+
+  double elapsed = 0;
+  for (auto a : state)
+  {
+    auto start = steady_clock::now();
+    pool.Run(task);
+    elapsed += duration<double>(steady_clock::now() - start).count();
+  }
+
+  std::vector<double> allLatencies;
+  for (auto& workerLatencies : latencies)
+    allLatencies.insert(allLatencies.end(), workerLatencies.begin(), workerLatencies.end());
+  const double opsPerSecond = elapsed > 0 ? static_cast<double>(allLatencies.size()) / elapsed : 0;
+  if(threadCount == 1)
+    baselines[csLength] = opsPerSecond;
+  const double singleThreadBaseline = baselines[csLength];
+
+  state.counters["ops_per_s"] = opsPerSecond;
+  state.counters["p50_ns"] = latency_percentile(allLatencies, 0.50);
+  state.counters["p99_ns"] = latency_percentile(allLatencies, 0.99);
+  state.counters["p999_ns"] = latency_percentile(allLatencies, 0.999);
+  state.counters["scaling"] = singleThreadBaseline > 0 ?
+    opsPerSecond / (singleThreadBaseline * static_cast<double>(threadCount)) : 0;
+}
+
+
+
+
+#endif // _NICKSV_VALUELOCK_WORKLOAD
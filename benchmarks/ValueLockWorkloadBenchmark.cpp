@@ -0,0 +1,107 @@
+#include "NickSV/Tools/ValueLock.h"
+#include "NickSV/Tools/ValueSeqLock.h"
+#include "NickSV/Tools/UpgradableValueLock.h"
+#include "NickSV/Tools/IntervalValueLock.h"
+#include "NickSV/Tools/HierarchicalValueLock.h"
+#include "NickSV/Tools/PriorityValueLock.h"
+#include "NickSV/Tools/ResizableValueLock.h"
+#if defined(__unix__)
+#include "NickSV/Tools/InterprocessValueLock.h"
+#endif
+
+#include "ValueLockWorkload.h"
+#include "ValueLockCompetitors.h"
+
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+
+// Throughput of every is_value_lock type and of the competitors
+// from ValueLockCompetitors.h under the same workload:
+// persistent workers, uniform/Zipf/hot-spot keys, 1->N threads.
+// Names are BM_ValueLockWorkload/<Lock>/<Distribution>/<threads>/<csLength>.
+
+using namespace NickSV::Tools;
+
+constexpr static size_t workloadSlotCount = static_cast<size_t>(workloadMaxThreads);
+
+
+template<typename ValueT>
+static ValueT make_workload_key(uint32_t index) { return static_cast<ValueT>(index); }
+
+template<>
+std::string make_workload_key<std::string>(uint32_t index) { return "root/" + std::to_string(index); }
+
+
+template<typename LockT>
+struct workload_lock
+{
+  static std::unique_ptr<LockT> make() { return std::unique_ptr<LockT>(new LockT()); }
+};
+
+#if defined(__unix__)
+template<typename ValueT, size_t slotCount>
+struct workload_lock<InterprocessValueLock<ValueT, slotCount>>
+{
+  using LockT = InterprocessValueLock<ValueT, slotCount>;
+  static std::unique_ptr<LockT> make()
+  {
+    const std::string name = "/nicksv_workload_benchmark";
+    LockT::Remove(name);
+    std::unique_ptr<LockT> upLock(new LockT(LockT::Create(name)));
+    LockT::Remove(name);
+    return upLock;
+  }
+};
+#endif
+
+
+// LockT is any type with ValueType, Lock(value) and Unlock(value)
+template<typename LockT>
+static void register_workloads(const char* lockName)
+{
+  using ValueType = typename LockT::ValueType;
+  for (auto distribution : {KeyDistribution::Uniform, KeyDistribution::Zipf, KeyDistribution::HotSpot})
+  {
+    auto spBaselines = std::make_shared<std::map<int64_t, double>>();
+    std::string name = std::string("BM_ValueLockWorkload/") + lockName + "/" + key_distribution_name(distribution);
+    benchmark::RegisterBenchmark(name.c_str(), [distribution, spBaselines](benchmark::State& state)
+    {
+      auto upLock = workload_lock<LockT>::make();
+      std::vector<ValueType> keys;
+      for (uint32_t i = 0; i < workloadKeyCount; ++i)
+        keys.push_back(make_workload_key<ValueType>(i));
+      LockT& vLock = *upLock;
+      run_value_lock_workload(state, distribution, *spBaselines,
+        [&vLock, &keys](uint32_t key) { vLock.Lock(keys[key]); },
+        [&vLock, &keys](uint32_t key) { vLock.Unlock(keys[key]); });
+    })->Apply(workload_arguments)->UseRealTime()->Unit(benchmark::kMillisecond)->Iterations(10);
+  }
+}
+
+
+static int register_all_workloads()
+{
+  register_workloads<ValueLock<uint32_t, workloadSlotCount>>("ValueLock");
+  register_workloads<ValueLock<uint32_t, workloadSlotCount, RecursiveValueLockPolicy>>("RecursiveValueLock");
+  register_workloads<DynamicValueLock<uint32_t>>("DynamicValueLock");
+  register_workloads<FakeValueLock<uint32_t, workloadSlotCount>>("FakeValueLock");
+  register_workloads<ValueSeqLock<uint32_t>>("ValueSeqLock");
+  register_workloads<UpgradableValueLock<uint32_t>>("UpgradableValueLock");
+  register_workloads<IntervalValueLock<uint32_t>>("IntervalValueLock");
+  register_workloads<HierarchicalValueLock>("HierarchicalValueLock");
+  register_workloads<PriorityValueLock<uint32_t>>("PriorityValueLock");
+  register_workloads<ResizableValueLock<uint32_t>>("ResizableValueLock");
+#if defined(__unix__)
+  register_workloads<InterprocessValueLock<uint32_t, workloadSlotCount>>("InterprocessValueLock");
+#endif
+  register_workloads<MutexMapLock<uint32_t>>("MutexMapLock");
+  register_workloads<StripedSharedMutexLock<uint32_t>>("StripedSharedMutexLock");
+  return 0;
+}
+
+static int workloadsRegistered BENCHMARK_UNUSED = register_all_workloads();
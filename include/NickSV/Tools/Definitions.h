@@ -29,6 +29,17 @@
 #endif
 
 
+//EXCEPTIONS STUFF (builds with -fno-exceptions abort instead of throwing)
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+    #define NICKSV_EXCEPTIONS 1
+    #define NICKSV_THROW(exception) throw exception
+#else
+    #include <cstdlib>
+    #define NICKSV_EXCEPTIONS 0
+    #define NICKSV_THROW(exception) (static_cast<void>(sizeof(exception)), std::abort())
+#endif
+
+
 #if (__cplusplus >= CXX14_VERSION)
 #define CONSTEXPR_SINCE_CPP14 constexpr
 #else
@@ -86,6 +97,16 @@
 #endif
 
 
+#ifndef NICKSV_CACHE_LINE_SIZE
+/**
+ * @def NICKSV_CACHE_LINE_SIZE
+ * @brief Assumed cache line size in bytes used to separate
+ *        data written by different threads (define yours before including)
+*/
+#define NICKSV_CACHE_LINE_SIZE 64
+#endif
+
+
 #define NOTHING
 
 #define DECLARE_COPY(ClassName, prefix, postfix)                              \
@@ -0,0 +1,469 @@
+
+#ifndef _NICKSV_HIERARCHICAL_VALUELOCK
+#define _NICKSV_HIERARCHICAL_VALUELOCK
+#pragma once
+
+
+#include "NickSV/Tools/ValueLock.h"
+
+
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+
+
+namespace NickSV {
+namespace Tools {
+
+
+
+#define INVALID_PATH_ERROR_TEXT "Invalid function call: path has not yet been locked in this mode"
+
+
+/**
+ * @brief Modes of @ref HierarchicalValueLock.
+ *
+ * Compatibility of modes held on the same path:
+ *
+ * |    | IS | IX | S | X |
+ * |----|----|----|---|---|
+ * | IS | +  | +  | + | - |
+ * | IX | +  | +  | - | - |
+ * | S  | +  | -  | + | - |
+ * | X  | -  | -  | - | - |
+ */
+enum class HierarchicalLockMode
+{
+    IntentionShared,    // some descendant is locked shared
+    IntentionExclusive, // some descendant is locked exclusively
+    Shared,             // path and all its descendants are readable
+    Exclusive           // path and all its descendants are writable
+};
+
+
+/**
+ * @class HierarchicalValueLock
+ *
+ * @brief Value lock for tree-structured keys: paths like
+ *        "tenant/42/document/7", where locking a path
+ *        locks its whole subtree.
+ *
+ * Locking path in Shared/Exclusive mode takes IntentionShared/
+ * IntentionExclusive on every ancestor (empty path "" is the root,
+ * ancestor of every path), so documents of the same tenant
+ * are locked in parallel, while locking the tenant excludes them:
+ * @code{.cpp}
+ *     // HierarchicalValueLock docsLock declared before
+ *     {
+ *         // IX on "", "tenant", "tenant/42", X on "tenant/42/doc/7"
+ *         ValueLockGuard<HierarchicalValueLock> lockGuard(docsLock, "tenant/42/doc/7");
+ *         documents.at(7).doSomething();
+ *     }
+ *     // somewhere else, waits for all tenant/42 documents
+ *     {
+ *         ValueLockGuard<HierarchicalValueLock> lockGuard(docsLock, "tenant/42");
+ *         tenants.at(42).removeAllDocuments();
+ *     }
+ * @endcode
+ *
+ * All the locks of one call are taken atomically under
+ * inner mutex, so there is no ancestor lock ordering deadlock.
+ * Path must not start or end with separator.
+ */
+class HierarchicalValueLock
+{
+public:
+
+    using ValueType = std::string;
+    using Mode = HierarchicalLockMode;
+
+    static constexpr char Separator = '/';
+
+
+    /**
+     * @class Unlocker
+     *
+     * @brief Unary functor that calls Unlock(value)
+     *        on given pointer to HierarchicalValueLock
+     *        with value.
+     *
+     * @warning
+     * Invoking throws the same exception as HierarchicalValueLock::Unlock(value) if there is no stack unwinding,
+     * otherwise printing error message to std::cerr and returns
+     *
+    */
+    class Unlocker
+    {
+        ValueType m_Value;
+    public:
+        Unlocker() = default;
+        DECLARE_RULE_OF_5_DEFAULT(Unlocker, NOTHING);
+        explicit Unlocker(const ValueType& value) : m_Value(value) {}
+
+        /**
+         * @throws
+         * Same exception as HierarchicalValueLock::Unlock(value) if there is no stack unwinding,
+         * otherwise printing error message to std::cerr and returns
+         */
+        inline void operator()(HierarchicalValueLock* pValueLock) const
+        {
+            #if NICKSV_EXCEPTIONS
+            try { pValueLock->Unlock(m_Value); }
+            catch(const std::exception& e)
+            {
+                #ifdef __cpp_lib_uncaught_exceptions
+                if(!std::uncaught_exceptions()) throw;
+                #else
+                if(!std::uncaught_exception()) throw;
+                #endif
+                std::cerr << "Unlocker::operator() caught std::exception in call of HierarchicalValueLock::Unlock()"
+                             "during stack unwinding, it won't be rethrown. std::exception::what(): "
+                          << e.what() << std::endl;
+            }
+            #else
+            pValueLock->Unlock(m_Value);
+            #endif
+        }
+    };
+
+    /**
+     * @class UnlockerAll
+     *
+     * @brief Unary functor that calls UnlockAll([value])
+     *        on given pointer to HierarchicalValueLock
+     *        with value.
+     *
+     * @warning
+     * Invoking throws the same exception as HierarchicalValueLock::UnlockAll([value]) if there is no stack unwinding,
+     * otherwise printing error message to std::cerr and returns
+     *
+    */
+    class UnlockerAll
+    {
+        std::unique_ptr<ValueType> m_upKeepLockedValue;
+    public:
+        UnlockerAll() = default;
+        DECLARE_RULE_OF_5_DEFAULT(UnlockerAll, NOTHING);
+        explicit UnlockerAll(const ValueType& keepLockedValue)
+            : m_upKeepLockedValue(new ValueType(keepLockedValue)) {}
+
+        /**
+         * @throws
+         * Same exception as HierarchicalValueLock::UnlockAll([value]) if there is no stack unwinding,
+         * otherwise printing error message to std::cerr and returns
+         */
+        inline void operator()(HierarchicalValueLock* pValueLock) const
+        {
+            #if NICKSV_EXCEPTIONS
+            try
+            {
+                if(m_upKeepLockedValue)
+                    pValueLock->UnlockAll(*m_upKeepLockedValue);
+                else
+                    pValueLock->UnlockAll();
+            }
+            catch(const std::exception& e)
+            {
+                #ifdef __cpp_lib_uncaught_exceptions
+                if(!std::uncaught_exceptions()) throw;
+                #else
+                if(!std::uncaught_exception()) throw;
+                #endif
+                std::cerr << "UnlockerAll::operator() caught std::exception in call of HierarchicalValueLock::UnlockAll()"
+                             "during stack unwinding, it won't be rethrown. std::exception::what(): "
+                          << e.what() << std::endl;
+            }
+            #else
+            if(m_upKeepLockedValue)
+                pValueLock->UnlockAll(*m_upKeepLockedValue);
+            else
+                pValueLock->UnlockAll();
+            #endif
+        }
+    };
+
+
+    // Non-copyable, non-movable
+    DECLARE_RULE_OF_5_DELETE(HierarchicalValueLock);
+
+    HierarchicalValueLock() = default;
+
+    /**
+     * @brief Locks path in given mode and its ancestors
+     *        in corresponding intention mode.
+     */
+    void Lock(const ValueType& path, Mode mode) noexcept(false)
+    {
+        auto plan = MakePlan(path, mode);
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        // Keeps its arrival order over wake-ups, so earlier waiters are never overtaken
+        const uint64_t ticket = m_nNextTicket++;
+        Plan::const_iterator iterWaiting = plan.end();
+        while(true)
+        {
+            auto iterBlocking = FindBlocking(plan, ticket);
+            if(iterBlocking == plan.end())
+                break;
+            if(iterBlocking != iterWaiting)
+            {
+                if(iterWaiting != plan.end())
+                    StopPending(*iterWaiting, ticket, true);
+                StartPending(*iterBlocking, ticket);
+                iterWaiting = iterBlocking;
+            }
+            m_mapNodes[iterWaiting->first].Condition.wait(uLock);
+        }
+        Hold(plan);
+        // Held in the same mode it was pending, so nobody it blocked can proceed yet
+        if(iterWaiting != plan.end())
+            StopPending(*iterWaiting, ticket, false);
+    }
+
+    /**
+     * @brief Locks path and its subtree exclusively.
+     */
+    void Lock(const ValueType& path) noexcept(false)
+    {
+        Lock(path, Mode::Exclusive);
+    }
+
+    /**
+     * @brief Locks every path exclusively
+     */
+    void LockAll() noexcept(false)
+    {
+        Lock(ValueType(), Mode::Exclusive);
+    }
+
+    /**
+     * @brief Unlocks path locked in given mode.
+     *
+     * @warning HierarchicalValueLock::Lock(path, mode) must be called
+     * by the current thread of execution,
+     * otherwise, the behavior is undefined.
+     */
+    void Unlock(const ValueType& path, Mode mode) noexcept(false)
+    {
+        auto plan = MakePlan(path, mode);
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        Release(plan);
+    }
+
+    /**
+     * @brief Unlocks exclusively locked path.
+     *
+     * @warning HierarchicalValueLock::Lock(path) must be called
+     * by the current thread of execution,
+     * otherwise, the behavior is undefined.
+     */
+    void Unlock(const ValueType& path) noexcept(false)
+    {
+        Unlock(path, Mode::Exclusive);
+    }
+
+    /**
+     * @brief Unlocks all paths.
+     *
+     * @warning HierarchicalValueLock::LockAll() must be called
+     * by the current thread of execution,
+     * otherwise, the behavior is undefined.
+     */
+    void UnlockAll() noexcept(false)
+    {
+        Unlock(ValueType(), Mode::Exclusive);
+    }
+
+    /**
+     * @brief Unlocks all paths except given one,
+     *        it stays locked exclusively.
+     *
+     * @warning HierarchicalValueLock::LockAll() must be called
+     * by the current thread of execution,
+     * otherwise, the behavior is undefined.
+     */
+    void UnlockAll(const ValueType& keepLockedPath) noexcept(false)
+    {
+        auto plan = MakePlan(keepLockedPath, Mode::Exclusive);
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        Release(MakePlan(ValueType(), Mode::Exclusive));
+        Hold(plan);
+    }
+
+    bool TryLock(const ValueType& path, Mode mode) noexcept(false)
+    {
+        auto plan = MakePlan(path, mode);
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        if(FindBlocking(plan, m_nNextTicket) != plan.end())
+            return false;
+        Hold(plan);
+        return true;
+    }
+
+    bool TryLock(const ValueType& path) noexcept(false)
+    {
+        return TryLock(path, Mode::Exclusive);
+    }
+
+private:
+    using Plan = std::vector<std::pair<ValueType, Mode>>;
+
+    // Count of holders (or waiters) per mode
+    struct ModeCounts
+    {
+        uint32_t Counts[4] = {0, 0, 0, 0};
+
+        inline uint32_t operator[](Mode mode) const noexcept { return Counts[static_cast<size_t>(mode)]; }
+        inline uint32_t& operator[](Mode mode) noexcept { return Counts[static_cast<size_t>(mode)]; }
+
+        bool IsCompatible(Mode mode) const noexcept
+        {
+            switch (mode)
+            {
+            case Mode::IntentionShared:
+                return !(*this)[Mode::Exclusive];
+            case Mode::IntentionExclusive:
+                return !(*this)[Mode::Shared] && !(*this)[Mode::Exclusive];
+            case Mode::Shared:
+                return !(*this)[Mode::IntentionExclusive] && !(*this)[Mode::Exclusive];
+            case Mode::Exclusive:
+            default:
+                return !(*this)[Mode::IntentionShared] && !(*this)[Mode::IntentionExclusive] &&
+                       !(*this)[Mode::Shared] && !(*this)[Mode::Exclusive];
+            }
+        }
+    };
+
+    struct Node
+    {
+        std::condition_variable Condition;
+        ModeCounts Held;
+        // Blocked on this node by arrival ticket, lockers give way to
+        // the ones arrived before, so subtree lock is not starved by descendants' locks
+        std::map<uint64_t, Mode> Pending;
+        // Holders and waiters of the node
+        uint32_t RefCount = 0;
+
+        ModeCounts PendingBefore(uint64_t ticket) const noexcept
+        {
+            ModeCounts counts;
+            for (auto iter = Pending.begin(); iter != Pending.end() && iter->first < ticket; ++iter)
+                ++counts[iter->second];
+            return counts;
+        }
+    };
+
+    // Root first, path itself last
+    static Plan MakePlan(const ValueType& path, Mode mode)
+    {
+        NICKSV_ASSERT(path.empty() || (path.front() != Separator && path.back() != Separator),
+            "HierarchicalValueLock path must not start or end with separator");
+        Mode intention = (mode == Mode::Shared || mode == Mode::IntentionShared) ?
+            Mode::IntentionShared : Mode::IntentionExclusive;
+        Plan plan;
+        if(!path.empty())
+        {
+            plan.emplace_back(ValueType(), intention);
+            for (size_t pos = path.find(Separator); pos != ValueType::npos; pos = path.find(Separator, pos + 1))
+                plan.emplace_back(path.substr(0, pos), intention);
+        }
+        plan.emplace_back(path, mode);
+        return plan;
+    }
+
+    // Step blocked by holders or by waiters arrived before ticket
+    Plan::const_iterator FindBlocking(const Plan& plan, uint64_t ticket) const
+    {
+        return std::find_if(plan.begin(), plan.end(), [this, ticket](const Plan::value_type& step)
+        {
+            auto iterNode = m_mapNodes.find(step.first);
+            return iterNode != m_mapNodes.end() && (!iterNode->second.Held.IsCompatible(step.second) ||
+                !iterNode->second.PendingBefore(ticket).IsCompatible(step.second));
+        });
+    }
+
+    void StartPending(const Plan::value_type& step, uint64_t ticket)
+    {
+        Node& node = m_mapNodes[step.first];
+        ++node.RefCount;
+        node.Pending.emplace(ticket, step.second);
+    }
+
+    // Waiters that gave way to this one are woken if it leaves for another node
+    void StopPending(const Plan::value_type& step, uint64_t ticket, bool isNotifying)
+    {
+        auto iterNode = m_mapNodes.find(step.first);
+        iterNode->second.Pending.erase(ticket);
+        if(!--iterNode->second.RefCount)
+            m_mapNodes.erase(iterNode);
+        else if(isNotifying)
+            iterNode->second.Condition.notify_all();
+    }
+
+    void Hold(const Plan& plan)
+    {
+        for (auto& step: plan)
+        {
+            Node& node = m_mapNodes[step.first];
+            ++node.RefCount;
+            ++node.Held[step.second];
+        }
+    }
+
+    void Release(const Plan& plan)
+    {
+        for (auto& step: plan)
+        {
+            auto iterNode = m_mapNodes.find(step.first);
+            NICKSV_ASSERT(iterNode != m_mapNodes.end() && iterNode->second.Held[step.second], INVALID_PATH_ERROR_TEXT);
+            --iterNode->second.Held[step.second];
+            if(!--iterNode->second.RefCount)
+                m_mapNodes.erase(iterNode);
+            else
+                iterNode->second.Condition.notify_all();
+        }
+    }
+
+    std::unordered_map<ValueType, Node> m_mapNodes;
+    uint64_t m_nNextTicket = 0;
+    std::mutex m_mtx;
+};
+
+
+template<>
+struct is_value_lock<HierarchicalValueLock> : std::true_type {};
+
+
+
+
+template<typename LockT>
+class HierarchicalValueLockGuard final
+{
+public:
+    using LockType = typename std::remove_cvref<LockT>::type;
+    using ValueType = typename LockType::ValueType;
+    using Mode = typename LockType::Mode;
+
+    HierarchicalValueLockGuard() = delete;
+    DECLARE_RULE_OF_5_DELETE(HierarchicalValueLockGuard);
+
+    HierarchicalValueLockGuard(LockType& lock, const ValueType& path, Mode mode) :
+        m_rLock(lock), m_path(path), m_mode(mode) { m_rLock.Lock(m_path, m_mode); }
+    ~HierarchicalValueLockGuard() { m_rLock.Unlock(m_path, m_mode); }
+private:
+    LockType& m_rLock;
+    const ValueType m_path;
+    const Mode m_mode;
+};
+
+
+}}  /*END OF NAMESPACES*/
+
+
+#endif // _NICKSV_HIERARCHICAL_VALUELOCK
@@ -0,0 +1,649 @@
+
+#ifndef _NICKSV_INTERPROCESS_VALUELOCK
+#define _NICKSV_INTERPROCESS_VALUELOCK
+#pragma once
+
+
+#include "NickSV/Tools/ValueLock.h"
+
+
+#if defined(__unix__) || defined(__unix)
+
+
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include <atomic>
+#include <new>
+#include <string>
+#include <thread>
+#include <system_error>
+#include <stdexcept>
+
+
+
+
+namespace NickSV {
+namespace Tools {
+
+
+
+#define INTERPROCESS_VALUELOCK_MAGIC 0x4E53564CU // "NSVL"
+
+
+/**
+ * @brief Result of InterprocessValueLock::Lock(value)
+ */
+enum class InterprocessLockResult
+{
+    Locked,     ///< value is locked
+    OwnerDied   ///< value is locked, but previous owner process died
+                ///  holding it, so protected data may be inconsistent
+};
+
+
+/**
+ * @class InterprocessValueLock
+ *
+ * @brief Same as @ref ValueLock, but its state
+ *        lives in POSIX shared memory, so
+ *        the value can be locked across processes.
+ *
+ * @tparam ValueT trivially copyable type of value to lock
+ *         (it is copied into shared memory as is,
+ *         use std::array<char, N> instead of std::string e.g.)
+ * @tparam slotCount max number of values that can be
+ *         simultaneously locked by all processes
+ *
+ * Every slot and the slot table are guarded by process-shared
+ * robust pthread mutexes, so if some process dies holding
+ * a value, next locker gets InterprocessLockResult::OwnerDied
+ * and slot is recovered.
+ *
+ * Shared memory object can be managed by this class:
+ * @code{.cpp}
+ *     // process 1
+ *     auto lock = InterprocessValueLock<ID, 16>::Create("/users-lock");
+ *     // process 2
+ *     auto lock = InterprocessValueLock<ID, 16>::Attach("/users-lock");
+ *     {
+ *         ValueLockGuard<decltype(lock)> lockGuard(lock, id);
+ *         // ... work with mmap'd user ...
+ *     }
+ *     // process 1 at the end
+ *     InterprocessValueLock<ID, 16>::Remove("/users-lock");
+ * @endcode
+ * or state can be placed into your own shared mapping
+ * (see Initialize(memory) and InterprocessValueLock(memory)).
+ *
+ * @warning
+ * Process dying while it waits for the value
+ * leaks one reference of the slot, so the slot stays
+ * binded to the value (locking it is still correct,
+ * but the slot can't be reused for other values).
+ */
+template<typename ValueT, size_t slotCount>
+class InterprocessValueLock
+{
+public:
+
+    static_assert(std::is_trivially_copyable<ValueT>::value, "ValueT must be trivially copyable");
+    static_assert(     is_equality_comparable<ValueT>::value, "ValueT must has equality operator overloaded");
+    static_assert(slotCount > 0, "slotCount must be greater than zero");
+
+    using ValueType = ValueT;
+
+    struct ValueMutex
+    {
+        pthread_mutex_t Mutex;
+        ValueType Value;
+        uint32_t RefCount;
+        // Pid of the process holding Mutex with its share of RefCount,
+        // guarded by Mutex itself (used for owner death recovery only)
+        pid_t HolderPid;
+    };
+
+    /**
+     * @brief Shared state, placed in shared memory.
+     */
+    struct State
+    {
+        std::atomic<uint32_t> Magic;
+        uint32_t SlotCount;
+        uint32_t ValueSize;
+        std::atomic<uint32_t> RecoveredCount;
+        pthread_mutex_t TableMutex;
+        ValueMutex Slots[slotCount];
+    };
+
+    static_assert(std::is_standard_layout<State>::value, "State must be standard layout");
+
+    /**
+     * @class Unlocker
+     *
+     * @brief Unary functor that calls Unlock(value)
+     *        on given pointer to InterprocessValueLock
+     *        with value.
+     *
+     * @warning
+     * Invoking throws the same exception as InterprocessValueLock::Unlock(value) if there is no stack unwinding,
+     * otherwise printing error message to std::cerr and returns
+     *
+    */
+    class Unlocker
+    {
+        ValueType m_Value;
+    public:
+        Unlocker() = default;
+        DECLARE_RULE_OF_5_DEFAULT(Unlocker, NOTHING);
+        explicit Unlocker(const ValueType& value) : m_Value(value) {}
+
+        /**
+         * @throws
+         * Same exception as InterprocessValueLock::Unlock(value) if there is no stack unwinding,
+         * otherwise printing error message to std::cerr and returns
+         */
+        inline void operator()(InterprocessValueLock* pValueLock) const
+        {
+            #if NICKSV_EXCEPTIONS
+            try { pValueLock->Unlock(m_Value); }
+            catch(const std::exception& e)
+            {
+                #ifdef __cpp_lib_uncaught_exceptions
+                if(!std::uncaught_exceptions()) throw;
+                #else
+                if(!std::uncaught_exception()) throw;
+                #endif
+                std::cerr << "Unlocker::operator() caught std::exception in call of InterprocessValueLock::Unlock()"
+                             "during stack unwinding, it won't be rethrown. std::exception::what(): "
+                          << e.what() << std::endl;
+            }
+            #else
+            pValueLock->Unlock(m_Value);
+            #endif
+        }
+    };
+
+    /**
+     * @class UnlockerAll
+     *
+     * @brief Unary functor that calls UnlockAll([value])
+     *        on given pointer to InterprocessValueLock
+     *        with value.
+     *
+     * @warning
+     * Invoking throws the same exception as InterprocessValueLock::UnlockAll([value]) if there is no stack unwinding,
+     * otherwise printing error message to std::cerr and returns
+     *
+    */
+    class UnlockerAll
+    {
+        std::unique_ptr<ValueType> m_upKeepLockedValue;
+    public:
+        UnlockerAll() = default;
+        DECLARE_RULE_OF_5_DEFAULT(UnlockerAll, NOTHING);
+        explicit UnlockerAll(const ValueType& keepLockedValue)
+            : m_upKeepLockedValue(new ValueType(keepLockedValue)) {}
+
+        /**
+         * @throws
+         * Same exception as InterprocessValueLock::UnlockAll([value]) if there is no stack unwinding,
+         * otherwise printing error message to std::cerr and returns
+         */
+        inline void operator()(InterprocessValueLock* pValueLock) const
+        {
+            #if NICKSV_EXCEPTIONS
+            try
+            {
+                if(m_upKeepLockedValue)
+                    pValueLock->UnlockAll(*m_upKeepLockedValue);
+                else
+                    pValueLock->UnlockAll();
+            }
+            catch(const std::exception& e)
+            {
+                #ifdef __cpp_lib_uncaught_exceptions
+                if(!std::uncaught_exceptions()) throw;
+                #else
+                if(!std::uncaught_exception()) throw;
+                #endif
+                std::cerr << "UnlockerAll::operator() caught std::exception in call of InterprocessValueLock::UnlockAll()"
+                             "during stack unwinding, it won't be rethrown. std::exception::what(): "
+                          << e.what() << std::endl;
+            }
+            #else
+            if(m_upKeepLockedValue)
+                pValueLock->UnlockAll(*m_upKeepLockedValue);
+            else
+                pValueLock->UnlockAll();
+            #endif
+        }
+    };
+
+
+    // Move only non-virtual
+    DECLARE_COPY_DELETE(InterprocessValueLock);
+
+    InterprocessValueLock(InterprocessValueLock&& rvalRef) noexcept
+        : m_pState(rvalRef.m_pState), m_nMappedSize(rvalRef.m_nMappedSize)
+    {
+        rvalRef.m_pState = nullptr;
+        rvalRef.m_nMappedSize = 0;
+    }
+
+    InterprocessValueLock& operator=(InterprocessValueLock&& rvalRef) noexcept
+    {
+        std::swap(m_pState, rvalRef.m_pState);
+        std::swap(m_nMappedSize, rvalRef.m_nMappedSize);
+        return *this;
+    }
+
+    /**
+     * @brief Attaches to the state already initialized
+     *        with Initialize(memory) in shared mapping
+     *        owned by the caller (it is not unmapped by this object).
+     *
+     * @throws std::runtime_error if state is not initialized
+     *         within a few seconds or has incompatible layout
+     */
+    explicit InterprocessValueLock(void* memory) noexcept(false)
+        : m_pState(static_cast<State*>(memory))
+    {
+        WaitInitialized(m_pState);
+    }
+
+    ~InterprocessValueLock()
+    {
+        if(m_pState && m_nMappedSize)
+            munmap(m_pState, m_nMappedSize);
+    }
+
+    /**
+     * @brief Size of the memory needed by Initialize(memory)
+     */
+    static constexpr size_t StateSize() noexcept
+    {
+        return sizeof(State);
+    }
+
+    /**
+     * @brief Initializes the state in given memory.
+     *
+     * @param memory is at least StateSize() bytes of
+     *        shared memory suitably aligned for State
+     *        (page aligned mmap'd memory is always fine)
+     *
+     * @throws std::system_error if mutex initialization fails
+     *
+     * @warning Must be called once by a single process before
+     *          any process attaches to this memory.
+     */
+    static void Initialize(void* memory) noexcept(false)
+    {
+        State* pState = static_cast<State*>(memory);
+        new (&pState->Magic) std::atomic<uint32_t>(0);
+        new (&pState->RecoveredCount) std::atomic<uint32_t>(0);
+        pState->SlotCount = static_cast<uint32_t>(slotCount);
+        pState->ValueSize = static_cast<uint32_t>(sizeof(ValueType));
+        InitMutex(&pState->TableMutex);
+        for (auto& slot : pState->Slots)
+        {
+            InitMutex(&slot.Mutex);
+            slot.Value = ValueType();
+            slot.RefCount = 0;
+            slot.HolderPid = 0;
+        }
+        pState->Magic.store(INTERPROCESS_VALUELOCK_MAGIC, std::memory_order_release);
+    }
+
+    /**
+     * @brief Creates new POSIX shared memory object
+     *        with given name and initializes the state in it.
+     *
+     * @throws std::system_error if object already exists
+     *         or can't be created/mapped
+     */
+    static InterprocessValueLock Create(const std::string& name) noexcept(false)
+    {
+        int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if(fd == -1)
+            NICKSV_THROW(std::system_error(errno, std::generic_category(), "shm_open(" + name + ")"));
+        return CreateState(fd, name);
+    }
+
+    /**
+     * @brief Attaches to POSIX shared memory object
+     *        created by Create(name) in some process.
+     *
+     * @throws std::system_error if object doesn't exist
+     *         or can't be mapped, std::runtime_error if
+     *         object is not initialized within a few seconds
+     *         or has incompatible layout
+     */
+    static InterprocessValueLock Attach(const std::string& name) noexcept(false)
+    {
+        int fd = shm_open(name.c_str(), O_RDWR, 0600);
+        if(fd == -1)
+            NICKSV_THROW(std::system_error(errno, std::generic_category(), "shm_open(" + name + ")"));
+        struct stat fdStat{};
+        // Creator may not have truncated the object yet
+        while_limit((fstat(fd, &fdStat) == 0) &&
+                    (static_cast<size_t>(fdStat.st_size) < StateSize()), AttachWaitIterations)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        if(static_cast<size_t>(fdStat.st_size) < StateSize())
+        {
+            close(fd);
+            NICKSV_THROW(std::runtime_error("InterprocessValueLock::Attach(): shared memory object is too small"));
+        }
+        InterprocessValueLock lock(MapState(fd, name), StateSize());
+        WaitInitialized(lock.m_pState);
+        return lock;
+    }
+
+    /**
+     * @brief Attaches to POSIX shared memory object
+     *        with given name or creates it.
+     */
+    static InterprocessValueLock CreateOrAttach(const std::string& name) noexcept(false)
+    {
+        int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if(fd == -1 && errno == EEXIST)
+            return Attach(name);
+        if(fd == -1)
+            NICKSV_THROW(std::system_error(errno, std::generic_category(), "shm_open(" + name + ")"));
+        return CreateState(fd, name);
+    }
+
+    /**
+     * @brief Removes POSIX shared memory object name,
+     *        attached processes keep working with it.
+     *
+     * @returns false if there is no object with this name
+     */
+    static bool Remove(const std::string& name) noexcept
+    {
+        return shm_unlink(name.c_str()) == 0;
+    }
+
+    /**
+     * @throws std::system_error if inner pthread mutex fails,
+     *         std::runtime_error if all slots are busy
+     */
+    InterprocessLockResult Lock(const ValueType& value) noexcept(false)
+    {
+        LockTable();
+        auto pSlot = FindBusySlot(value);
+        if(!pSlot)
+        {
+            pSlot = FindEmptySlot();
+            if(!pSlot)
+            {
+                UnlockTable();
+                NICKSV_THROW(std::runtime_error(CONCURRENCY_ERROR_TEXT));
+            }
+            pSlot->Value = value;
+        }
+        ++(pSlot->RefCount);
+        UnlockTable();
+        int error = pthread_mutex_lock(&pSlot->Mutex);
+        if(error && error != EOWNERDEAD)
+        {
+            LockTable();
+            --(pSlot->RefCount);
+            UnlockTable();
+            NICKSV_THROW(std::system_error(error, std::generic_category(), "InterprocessValueLock::Lock()"));
+        }
+        return OnSlotLocked(pSlot, error == EOWNERDEAD);
+    }
+
+    /**
+     * @brief Locks every slot/value
+     *
+     * @throws std::system_error if inner pthread mutex fails
+     *         and unlocks everything that was successfully locked.
+     */
+    void LockAll() noexcept(false)
+    {
+        for_each_exception_safe(std::begin(m_pState->Slots), std::end(m_pState->Slots),
+        [this](ValueMutex& slot) { if(LockRobust(&slot.Mutex)) ForgetDeadHolder(&slot); },
+        [](ValueMutex& slot) noexcept { pthread_mutex_unlock(&slot.Mutex); });
+    }
+
+    /**
+     * @brief Unlocks given value.
+     *
+     * @warning InterprocessValueLock::Lock(value) must be called
+     * by the current thread of execution,
+     * otherwise, the behavior is undefined.
+    */
+    void Unlock(const ValueType& value) noexcept(false)
+    {
+        LockTable();
+        auto pSlot = FindBusySlot(value);
+        NICKSV_ASSERT(pSlot, INVALID_VALUE_ERROR_TEXT);
+        // Leaking reference on death between these lines
+        // is safer than counting it twice
+        pSlot->HolderPid = 0;
+        --(pSlot->RefCount);
+        pthread_mutex_unlock(&pSlot->Mutex);
+        UnlockTable();
+    }
+
+    /**
+     * @brief Unlocks all values.
+     *
+     * @warning InterprocessValueLock::LockAll() must be called
+     * by the current thread of execution,
+     * otherwise, the behavior is undefined.
+    */
+    void UnlockAll() noexcept
+    {
+        for (auto& slot : m_pState->Slots)
+            pthread_mutex_unlock(&slot.Mutex);
+    }
+
+    /**
+     * @brief Unlocks all values except given one.
+     *
+     * @warning InterprocessValueLock::LockAll() must be called
+     * by the current thread of execution,
+     * otherwise, the behavior is undefined.
+    */
+    void UnlockAll(const ValueType& keepLockedValue) noexcept(false)
+    {
+        LockTable();
+        auto pSlot = FindBusySlot(keepLockedValue);
+        if(!pSlot)
+        {
+            pSlot = FindEmptySlot();
+            if(!pSlot)
+            {
+                UnlockTable();
+                NICKSV_THROW(std::runtime_error(CONCURRENCY_ERROR_TEXT));
+            }
+            pSlot->Value = keepLockedValue;
+        }
+        ++(pSlot->RefCount);
+        pSlot->HolderPid = getpid();
+        UnlockTable();
+        for (auto& slot : m_pState->Slots)
+        {
+            if(&slot != pSlot)
+                pthread_mutex_unlock(&slot.Mutex);
+        }
+    }
+
+    /**
+     * @throws std::system_error if inner pthread mutex fails,
+     *         std::runtime_error if all slots are busy
+     */
+    bool TryLock(const ValueType& value) noexcept(false)
+    {
+        LockTable();
+        auto pSlot = FindBusySlot(value);
+        if(!pSlot)
+        {
+            pSlot = FindEmptySlot();
+            if(!pSlot)
+            {
+                UnlockTable();
+                NICKSV_THROW(std::runtime_error(CONCURRENCY_ERROR_TEXT));
+            }
+            pSlot->Value = value;
+        }
+        ++(pSlot->RefCount);
+        int error = pthread_mutex_trylock(&pSlot->Mutex);
+        if(error && error != EOWNERDEAD)
+        {
+            --(pSlot->RefCount);
+            UnlockTable();
+            if(error == EBUSY)
+                return false;
+            NICKSV_THROW(std::system_error(error, std::generic_category(), "InterprocessValueLock::TryLock()"));
+        }
+        UnlockTable();
+        OnSlotLocked(pSlot, error == EOWNERDEAD);
+        return true;
+    }
+
+    /**
+     * @brief How many times slots or the slot table
+     *        were recovered after their owner death
+     *        (by all processes)
+     */
+    uint32_t RecoveredCount() const noexcept
+    {
+        return m_pState->RecoveredCount.load(std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr uint64_t AttachWaitIterations = 5000;
+
+    InterprocessValueLock(State* pState, size_t mappedSize) noexcept
+        : m_pState(pState), m_nMappedSize(mappedSize) {}
+
+    // Sizes and initializes newly created object
+    static InterprocessValueLock CreateState(int fd, const std::string& name)
+    {
+        if(ftruncate(fd, static_cast<off_t>(StateSize())) == -1)
+        {
+            int error = errno;
+            close(fd);
+            shm_unlink(name.c_str());
+            NICKSV_THROW(std::system_error(error, std::generic_category(), "ftruncate(" + name + ")"));
+        }
+        InterprocessValueLock lock(MapState(fd, name), StateSize());
+        Initialize(lock.m_pState);
+        return lock;
+    }
+
+    static State* MapState(int fd, const std::string& name)
+    {
+        void* memory = mmap(nullptr, StateSize(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        int error = errno;
+        close(fd);
+        if(memory == MAP_FAILED)
+            NICKSV_THROW(std::system_error(error, std::generic_category(), "mmap(" + name + ")"));
+        return static_cast<State*>(memory);
+    }
+
+    static void WaitInitialized(const State* pState)
+    {
+        while_limit(pState->Magic.load(std::memory_order_acquire) != INTERPROCESS_VALUELOCK_MAGIC, AttachWaitIterations)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        if(pState->Magic.load(std::memory_order_acquire) != INTERPROCESS_VALUELOCK_MAGIC)
+            NICKSV_THROW(std::runtime_error("InterprocessValueLock: shared state is not initialized"));
+        if(pState->SlotCount != slotCount || pState->ValueSize != sizeof(ValueType))
+            NICKSV_THROW(std::runtime_error("InterprocessValueLock: shared state has incompatible layout"));
+    }
+
+    static void InitMutex(pthread_mutex_t* pMutex)
+    {
+        pthread_mutexattr_t attr;
+        int error = pthread_mutexattr_init(&attr);
+        if(!error) error = pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+        if(!error) error = pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+        if(!error) error = pthread_mutex_init(pMutex, &attr);
+        pthread_mutexattr_destroy(&attr);
+        if(error)
+            NICKSV_THROW(std::system_error(error, std::generic_category(), "InterprocessValueLock: mutex initialization"));
+    }
+
+    // returns true if previous owner died
+    bool LockRobust(pthread_mutex_t* pMutex)
+    {
+        int error = pthread_mutex_lock(pMutex);
+        if(error == EOWNERDEAD)
+        {
+            pthread_mutex_consistent(pMutex);
+            m_pState->RecoveredCount.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        if(error)
+            NICKSV_THROW(std::system_error(error, std::generic_category(), "InterprocessValueLock: mutex lock"));
+        return false;
+    }
+
+    // Table updates are ordered so that the table
+    // stays consistent at every point of owner death
+    inline void LockTable() { LockRobust(&m_pState->TableMutex); }
+    inline void UnlockTable() noexcept { pthread_mutex_unlock(&m_pState->TableMutex); }
+
+    InterprocessLockResult OnSlotLocked(ValueMutex* pSlot, bool ownerDied)
+    {
+        if(!ownerDied)
+        {
+            pSlot->HolderPid = getpid();
+            return InterprocessLockResult::Locked;
+        }
+        pthread_mutex_consistent(&pSlot->Mutex);
+        m_pState->RecoveredCount.fetch_add(1, std::memory_order_relaxed);
+        ForgetDeadHolder(pSlot);
+        pSlot->HolderPid = getpid();
+        return InterprocessLockResult::OwnerDied;
+    }
+
+    // Dead holder never gave its reference back,
+    // slot mutex must be locked by the current thread
+    void ForgetDeadHolder(ValueMutex* pSlot)
+    {
+        LockTable();
+        if(pSlot->HolderPid && pSlot->RefCount)
+            --(pSlot->RefCount);
+        pSlot->HolderPid = 0;
+        UnlockTable();
+    }
+
+    inline ValueMutex* FindEmptySlot() noexcept
+    {
+        auto iter = std::find_if(std::begin(m_pState->Slots), std::end(m_pState->Slots),
+                [](const ValueMutex & slot) noexcept { return slot.RefCount == 0; });
+        return iter == std::end(m_pState->Slots) ? nullptr : iter;
+    }
+    inline ValueMutex* FindBusySlot(const ValueType& value) noexcept
+    {
+        auto iter = std::find_if(std::begin(m_pState->Slots), std::end(m_pState->Slots),
+                [&value](const ValueMutex & slot) noexcept { return (value == slot.Value) && (slot.RefCount > 0); });
+        return iter == std::end(m_pState->Slots) ? nullptr : iter;
+    }
+
+    State* m_pState = nullptr;
+    size_t m_nMappedSize = 0;
+};
+
+
+template<typename ValueT, size_t slotCount>
+struct is_value_lock<InterprocessValueLock<ValueT, slotCount>> : std::true_type {};
+
+
+}}  /*END OF NAMESPACES*/
+
+
+#endif // __unix__
+
+
+#endif // _NICKSV_INTERPROCESS_VALUELOCK
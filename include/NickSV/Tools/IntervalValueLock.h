@@ -0,0 +1,444 @@
+
+#ifndef _NICKSV_INTERVAL_VALUELOCK
+#define _NICKSV_INTERVAL_VALUELOCK
+#pragma once
+
+
+#include "NickSV/Tools/ValueLock.h"
+
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <list>
+#include <map>
+
+
+
+
+namespace NickSV {
+namespace Tools {
+
+
+
+#define INVALID_INTERVAL_ERROR_TEXT "Invalid function call: interval is empty or has not yet been locked"
+
+
+/**
+ * @class IntervalValueLock
+ *
+ * @brief Same as @ref ValueLock, but locks half-open
+ *        ranges [begin, end) of ordered values as well
+ *        as single values.
+ *
+ * @tparam ValueT type of value to lock
+ * @tparam Compare strict weak ordering of ValueT
+ *
+ * Batch job locks all the IDs it works with by one call,
+ * while threads working with single IDs outside of the range
+ * are not blocked:
+ * @code{.cpp}
+ *     // IntervalValueLock<ID> usersLock declared before
+ *     {
+ *         IntervalValueLockGuard<decltype(usersLock)> rangeGuard(usersLock, 1000, 5000);
+ *         for (ID id = 1000; id < 5000; ++id)
+ *             mapUsers.at(id).doSomething();
+ *     }
+ *     // somewhere else
+ *     {
+ *         ValueLockGuard<decltype(usersLock)> lockGuard(usersLock, id);
+ *         mapUsers.at(id).doSomething();
+ *     }
+ * @endcode
+ *
+ * Held intervals never overlap, so they are kept in an ordered
+ * map and overlap is checked in O(log n). Blocked requests are
+ * queued and granted in order: request never overtakes an earlier
+ * overlapping one, so wide ranges are not starved by single values.
+ * Lock is handed off to a waiter by unlocking thread.
+ */
+template<typename ValueT, class Compare = std::less<ValueT>>
+class IntervalValueLock
+{
+public:
+
+    static_assert(std::is_copy_constructible<ValueT>::value, "ValueT must be copy constructible");
+
+    using ValueType = ValueT;
+    using CompareType = Compare;
+
+
+    /**
+     * @class Unlocker
+     *
+     * @brief Unary functor that calls Unlock(value)
+     *        on given pointer to IntervalValueLock
+     *        with value.
+     *
+     * @warning
+     * Invoking throws the same exception as IntervalValueLock::Unlock(value) if there is no stack unwinding,
+     * otherwise printing error message to std::cerr and returns
+     *
+    */
+    class Unlocker
+    {
+        ValueType m_Value;
+    public:
+        Unlocker() = default;
+        DECLARE_RULE_OF_5_DEFAULT(Unlocker, NOTHING);
+        explicit Unlocker(const ValueType& value) : m_Value(value) {}
+
+        /**
+         * @throws
+         * Same exception as IntervalValueLock::Unlock(value) if there is no stack unwinding,
+         * otherwise printing error message to std::cerr and returns
+         */
+        inline void operator()(IntervalValueLock* pValueLock) const
+        {
+            #if NICKSV_EXCEPTIONS
+            try { pValueLock->Unlock(m_Value); }
+            catch(const std::exception& e)
+            {
+                #ifdef __cpp_lib_uncaught_exceptions
+                if(!std::uncaught_exceptions()) throw;
+                #else
+                if(!std::uncaught_exception()) throw;
+                #endif
+                std::cerr << "Unlocker::operator() caught std::exception in call of IntervalValueLock::Unlock()"
+                             "during stack unwinding, it won't be rethrown. std::exception::what(): "
+                          << e.what() << std::endl;
+            }
+            #else
+            pValueLock->Unlock(m_Value);
+            #endif
+        }
+    };
+
+    /**
+     * @class UnlockerAll
+     *
+     * @brief Unary functor that calls UnlockAll([value])
+     *        on given pointer to IntervalValueLock
+     *        with value.
+     *
+     * @warning
+     * Invoking throws the same exception as IntervalValueLock::UnlockAll([value]) if there is no stack unwinding,
+     * otherwise printing error message to std::cerr and returns
+     *
+    */
+    class UnlockerAll
+    {
+        std::unique_ptr<ValueType> m_upKeepLockedValue;
+    public:
+        UnlockerAll() = default;
+        DECLARE_RULE_OF_5_DEFAULT(UnlockerAll, NOTHING);
+        explicit UnlockerAll(const ValueType& keepLockedValue)
+            : m_upKeepLockedValue(new ValueType(keepLockedValue)) {}
+
+        /**
+         * @throws
+         * Same exception as IntervalValueLock::UnlockAll([value]) if there is no stack unwinding,
+         * otherwise printing error message to std::cerr and returns
+         */
+        inline void operator()(IntervalValueLock* pValueLock) const
+        {
+            #if NICKSV_EXCEPTIONS
+            try
+            {
+                if(m_upKeepLockedValue)
+                    pValueLock->UnlockAll(*m_upKeepLockedValue);
+                else
+                    pValueLock->UnlockAll();
+            }
+            catch(const std::exception& e)
+            {
+                #ifdef __cpp_lib_uncaught_exceptions
+                if(!std::uncaught_exceptions()) throw;
+                #else
+                if(!std::uncaught_exception()) throw;
+                #endif
+                std::cerr << "UnlockerAll::operator() caught std::exception in call of IntervalValueLock::UnlockAll()"
+                             "during stack unwinding, it won't be rethrown. std::exception::what(): "
+                          << e.what() << std::endl;
+            }
+            #else
+            if(m_upKeepLockedValue)
+                pValueLock->UnlockAll(*m_upKeepLockedValue);
+            else
+                pValueLock->UnlockAll();
+            #endif
+        }
+    };
+
+
+    // Non-copyable, non-movable
+    DECLARE_RULE_OF_5_DELETE(IntervalValueLock);
+
+    IntervalValueLock() = default;
+    explicit IntervalValueLock(const CompareType& comp) : m_less(comp), m_mapHeld(comp) {}
+
+    /**
+     * @brief Locks single value, blocks while
+     *        some held range contains it.
+     */
+    void Lock(const ValueType& value) noexcept(false)
+    {
+        Acquire(Interval{value, value, IntervalKind::Point});
+    }
+
+    /**
+     * @brief Locks every value in [begin, end),
+     *        blocks while any of them is held.
+     *
+     * @warning begin must be less than end,
+     * otherwise, the behavior is undefined.
+     */
+    void LockRange(const ValueType& begin, const ValueType& end) noexcept(false)
+    {
+        NICKSV_ASSERT(m_less(begin, end), INVALID_INTERVAL_ERROR_TEXT);
+        Acquire(Interval{begin, end, IntervalKind::Range});
+    }
+
+    /**
+     * @brief Locks every value
+     */
+    void LockAll() noexcept(false)
+    {
+        Acquire(Interval{ValueType(), ValueType(), IntervalKind::All});
+    }
+
+    /**
+     * @brief Unlocks given value.
+     *
+     * @warning IntervalValueLock::Lock(value) must be called
+     * by the current thread of execution,
+     * otherwise, the behavior is undefined.
+     */
+    void Unlock(const ValueType& value) noexcept(false)
+    {
+        Release(Interval{value, value, IntervalKind::Point});
+    }
+
+    /**
+     * @brief Unlocks range [begin, end).
+     *
+     * @warning IntervalValueLock::LockRange(begin, end) must be called
+     * by the current thread of execution with the same bounds,
+     * otherwise, the behavior is undefined.
+     */
+    void UnlockRange(const ValueType& begin, const ValueType& end) noexcept(false)
+    {
+        Release(Interval{begin, end, IntervalKind::Range});
+    }
+
+    /**
+     * @brief Unlocks all values.
+     *
+     * @warning IntervalValueLock::LockAll() must be called
+     * by the current thread of execution,
+     * otherwise, the behavior is undefined.
+     */
+    void UnlockAll() noexcept
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        NICKSV_ASSERT(m_bAllHeld, CONCURRENCY_ERROR_TEXT);
+        m_bAllHeld = false;
+        GrantWaiters();
+    }
+
+    /**
+     * @brief Unlocks all values except given one.
+     *
+     * @warning IntervalValueLock::LockAll() must be called
+     * by the current thread of execution,
+     * otherwise, the behavior is undefined.
+     */
+    void UnlockAll(const ValueType& keepLockedValue) noexcept(false)
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        NICKSV_ASSERT(m_bAllHeld, CONCURRENCY_ERROR_TEXT);
+        Hold(Interval{keepLockedValue, keepLockedValue, IntervalKind::Point});
+        m_bAllHeld = false;
+        GrantWaiters();
+    }
+
+    bool TryLock(const ValueType& value) noexcept(false)
+    {
+        return TryAcquire(Interval{value, value, IntervalKind::Point});
+    }
+
+    /**
+     * @warning begin must be less than end,
+     * otherwise, the behavior is undefined.
+     */
+    bool TryLockRange(const ValueType& begin, const ValueType& end) noexcept(false)
+    {
+        NICKSV_ASSERT(m_less(begin, end), INVALID_INTERVAL_ERROR_TEXT);
+        return TryAcquire(Interval{begin, end, IntervalKind::Range});
+    }
+
+private:
+    enum class IntervalKind
+    {
+        Point, // [Begin, Begin]
+        Range, // [Begin, End)
+        All
+    };
+
+    struct Interval
+    {
+        ValueType Begin;
+        ValueType End;
+        IntervalKind Kind;
+    };
+
+    struct HeldEnd
+    {
+        ValueType End;
+        IntervalKind Kind;
+    };
+
+    struct Waiter
+    {
+        explicit Waiter(const Interval& interval) : Range(interval) {}
+        Interval Range;
+        std::condition_variable Condition;
+        bool Granted = false;
+    };
+
+    // true if every value of lhs is less than every value of rhs
+    inline bool EndsBefore(const Interval& lhs, const Interval& rhs) const
+    {
+        if(lhs.Kind == IntervalKind::All || rhs.Kind == IntervalKind::All)
+            return false;
+        if(lhs.Kind == IntervalKind::Point)
+            return m_less(lhs.Begin, rhs.Begin);
+        return !m_less(rhs.Begin, lhs.End);
+    }
+
+    inline bool Overlaps(const Interval& lhs, const Interval& rhs) const
+    {
+        return !EndsBefore(lhs, rhs) && !EndsBefore(rhs, lhs);
+    }
+
+    // Held intervals are disjoint, so they are sorted by ends
+    // as well as by begins and only the last one that does
+    // not start after interval can overlap it
+    bool OverlapsHeld(const Interval& interval) const
+    {
+        if(m_bAllHeld)
+            return true;
+        if(interval.Kind == IntervalKind::All)
+            return !m_mapHeld.empty();
+        auto iterHeld = (interval.Kind == IntervalKind::Point) ?
+            m_mapHeld.upper_bound(interval.Begin) : m_mapHeld.lower_bound(interval.End);
+        if(iterHeld == m_mapHeld.begin())
+            return false;
+        --iterHeld;
+        return !EndsBefore(Interval{iterHeld->first, iterHeld->second.End, iterHeld->second.Kind}, interval);
+    }
+
+    bool OverlapsWaiters(const Interval& interval, typename std::list<Waiter>::const_iterator last) const
+    {
+        return std::any_of(m_listWaiters.cbegin(), last, [this, &interval](const Waiter& waiter)
+            { return !waiter.Granted && Overlaps(waiter.Range, interval); });
+    }
+
+    inline bool CanHold(const Interval& interval, typename std::list<Waiter>::const_iterator firstLater) const
+    {
+        return !OverlapsHeld(interval) && !OverlapsWaiters(interval, firstLater);
+    }
+
+    void Hold(const Interval& interval)
+    {
+        if(interval.Kind == IntervalKind::All)
+            m_bAllHeld = true;
+        else
+            m_mapHeld.emplace(interval.Begin, HeldEnd{interval.End, interval.Kind});
+    }
+
+    void Acquire(const Interval& interval)
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        if(CanHold(interval, m_listWaiters.cend()))
+        {
+            Hold(interval);
+            return;
+        }
+        m_listWaiters.emplace_back(interval);
+        auto iterWaiter = m_listWaiters.end();
+        --iterWaiter;
+        iterWaiter->Condition.wait(uLock, [&iterWaiter]{ return iterWaiter->Granted; });
+        m_listWaiters.erase(iterWaiter);
+    }
+
+    bool TryAcquire(const Interval& interval)
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        if(!CanHold(interval, m_listWaiters.cend()))
+            return false;
+        Hold(interval);
+        return true;
+    }
+
+    void Release(const Interval& interval)
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        auto iterHeld = m_mapHeld.find(interval.Begin);
+        NICKSV_ASSERT(iterHeld != m_mapHeld.end() && iterHeld->second.Kind == interval.Kind &&
+            !m_less(iterHeld->second.End, interval.End) && !m_less(interval.End, iterHeld->second.End),
+            INVALID_INTERVAL_ERROR_TEXT);
+        m_mapHeld.erase(iterHeld);
+        GrantWaiters();
+    }
+
+    void GrantWaiters()
+    {
+        for (auto iterWaiter = m_listWaiters.begin(); iterWaiter != m_listWaiters.end(); ++iterWaiter)
+        {
+            if(iterWaiter->Granted || !CanHold(iterWaiter->Range, iterWaiter))
+                continue;
+            Hold(iterWaiter->Range);
+            iterWaiter->Granted = true;
+            iterWaiter->Condition.notify_one();
+        }
+    }
+
+    CompareType m_less;
+    std::map<ValueType, HeldEnd, CompareType> m_mapHeld;
+    std::list<Waiter> m_listWaiters;
+    std::mutex m_mtx;
+    bool m_bAllHeld = false;
+};
+
+
+template<typename ValueT, class Compare>
+struct is_value_lock<IntervalValueLock<ValueT, Compare>> : std::true_type {};
+
+
+
+
+template<typename LockT>
+class IntervalValueLockGuard final
+{
+public:
+    using LockType = typename std::remove_cvref<LockT>::type;
+    using ValueType = typename LockType::ValueType;
+
+    IntervalValueLockGuard() = delete;
+    DECLARE_RULE_OF_5_DELETE(IntervalValueLockGuard);
+
+    IntervalValueLockGuard(LockType& lock, const ValueType& begin, const ValueType& end) :
+        m_rLock(lock), m_begin(begin), m_end(end) { m_rLock.LockRange(m_begin, m_end); }
+    ~IntervalValueLockGuard() { m_rLock.UnlockRange(m_begin, m_end); }
+private:
+    LockType& m_rLock;
+    const ValueType m_begin;
+    const ValueType m_end;
+};
+
+
+}}  /*END OF NAMESPACES*/
+
+
+#endif // _NICKSV_INTERVAL_VALUELOCK
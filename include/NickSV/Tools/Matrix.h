@@ -4,14 +4,19 @@
 
 
 #include <type_traits>
+#include <array>
 #include <ostream>
 #include <sstream>
 #include <vector>
 #include <functional>
 #include <complex>
+#include <memory>
 
 
 #include "NickSV/Tools/TypeTraits.h"
+#include "NickSV/Tools/Memory.h"
+#include "NickSV/Tools/MatrixGemm.h"
+#include "NickSV/Tools/ThreadPool.h"
 
 
 // use debug only assertions instead of excep throw, e.g matrix.At(y,x) out of bounds
@@ -27,24 +32,147 @@ namespace Tools {
 
 
 
-template<class>
+using MatrixSizeType = size_t;
+
+// Dimension known only at runtime, MatrixT<ValT> is MatrixT<ValT, MatrixDynamicSize, MatrixDynamicSize>
+constexpr MatrixSizeType MatrixDynamicSize = 0;
+
+
+/**
+ * @brief Order of elements in storage: rows one after another
+ *        or columns one after another.
+ */
+enum class MatrixStorageOrder
+{
+    RowMajor,
+    ColMajor
+};
+
+constexpr MatrixStorageOrder MatrixTransposedOrder(MatrixStorageOrder order) noexcept
+{
+    return order == MatrixStorageOrder::RowMajor ? MatrixStorageOrder::ColMajor : MatrixStorageOrder::RowMajor;
+}
+
+
+/**
+ * @brief Storage layouts of MatrixT: storage order, allocator of elements,
+ *        stride (leading dimension) in elements between rows of row-major
+ *        or columns of column-major storage and whether there is padding
+ *        between them.
+ *
+ * MatrixDenseLayout stores rows back to back.
+ */
+struct MatrixDenseLayout
+{
+    static constexpr MatrixStorageOrder Order = MatrixStorageOrder::RowMajor;
+    static constexpr bool IsPadded = false;
+
+    template<class T>
+    using Allocator = std::allocator<T>;
+
+    template<class T>
+    static constexpr size_t Alignment() noexcept { return alignof(T); }
+
+    // size is Cols() of row-major and Rows() of column-major storage
+    template<class T>
+    static constexpr MatrixSizeType Stride(MatrixSizeType size) noexcept { return size; }
+};
+
+/**
+ * @brief Columns stored back to back, e.g. for column-oriented algorithms
+ *        or data shared with Fortran-style libraries.
+ *
+ * Transpose() of row-major expression is read in this order,
+ * so assigning it here is a contiguous copy.
+ */
+struct MatrixColMajorLayout : MatrixDenseLayout
+{
+    static constexpr MatrixStorageOrder Order = MatrixStorageOrder::ColMajor;
+};
+
+/**
+ * @brief Every row (column for MatrixStorageOrder::ColMajor) starts
+ *        at alignment boundary, so SIMD kernels can use aligned loads on any of them.
+ *
+ * Stride that is multiple of 8 alignment units gets one more,
+ * so power of 2 sizes don't map rows to the same cache sets.
+ */
+template<size_t alignment = NICKSV_CACHE_LINE_SIZE, MatrixStorageOrder order = MatrixStorageOrder::RowMajor>
+struct MatrixAlignedLayout
+{
+    static constexpr MatrixStorageOrder Order = order;
+    static constexpr bool IsPadded = true;
+
+    template<class T>
+    using Allocator = AlignedAllocator<T, alignment>;
+
+    template<class T>
+    static constexpr size_t Alignment() noexcept { return alignment; }
+
+    template<class T>
+    static constexpr MatrixSizeType Stride(MatrixSizeType size) noexcept
+    {
+        static_assert(alignment % sizeof(T) == 0, "Alignment has to be multiple of element size");
+        return PaddedStride((size + alignment / sizeof(T) - 1) / (alignment / sizeof(T)), alignment / sizeof(T));
+    }
+
+private:
+    static constexpr MatrixSizeType PaddedStride(MatrixSizeType units, MatrixSizeType unit) noexcept
+    {
+        return (units && units % 8 == 0 ? units + 1 : units) * unit;
+    }
+};
+
+
+template<class, MatrixSizeType = MatrixDynamicSize, MatrixSizeType = MatrixDynamicSize, class = MatrixDenseLayout>
 class MatrixT;
 
-using MatrixSizeType = size_t;
+
+template<class>
+class MatrixView;
+
+
+template<class>
+class MatrixNoAlias;
 
 
 template<class>
 struct is_matrix : std::false_type {};
 
 
-template<class ValT>
-struct is_matrix<MatrixT<ValT>> : std::true_type {};
+template<class ValT, MatrixSizeType rows, MatrixSizeType cols, class Layout>
+struct is_matrix<MatrixT<ValT, rows, cols, Layout>> : std::true_type {};
 
 
 template<class, class>
 class MatrixExpression;
 
 
+template<class, class>
+struct MatrixMultOp;
+
+
+template<class>
+struct MatrixTransposesOp;
+
+
+template<class>
+class MatrixUnaryOp;
+
+
+/**
+ * @brief Order in which matrix expression is cheapest to read, taken
+ *        from StorageOrder member: storage order of MatrixT, transposed
+ *        one for Transpose() and so on. Row-major for types without it.
+ */
+template<class T, class = void>
+struct matrix_storage_order : std::integral_constant<MatrixStorageOrder, MatrixStorageOrder::RowMajor> {};
+
+template<class T>
+struct matrix_storage_order<T, std::void_t<decltype(T::StorageOrder)>> 
+    : std::integral_constant<MatrixStorageOrder, T::StorageOrder> {};
+
+
 template<class T, class ValT>
 class Row
 {
@@ -124,6 +252,19 @@ public:
         return static_cast<T*>(this)->AtUnsafe(y, x);
     }
 
+    // Flat index in matrix_storage_order, only for @ref is_matrix_linear expressions
+    inline auto AtLinear(MatrixSizeType index) const
+    -> std::conditional_t<is_matrix<T>::value, const ValueType&, ValueType>
+    {
+        return static_cast<const T*>(this)->AtLinear(index);
+    }
+
+    // Whether columns are cheaper to read than rows, MatrixView decides it by strides
+    inline bool IsColMajor() const noexcept
+    {
+        return matrix_storage_order<T>::value == MatrixStorageOrder::ColMajor;
+    }
+
     inline auto operator[](MatrixSizeType index) const
     -> const Row<T, ValT>
     {
@@ -176,6 +317,69 @@ template<class T>
 struct is_matrix_expression<MatrixExpression<T, typename T::ValueType>, true> : std::true_type {};
 
 
+/**
+ * @brief true_type for matrix expressions with IsLinear member equal to true:
+ *        their AtLinear(index) is the same as AtUnsafe(index / Cols(), index % Cols())
+ *        for row-major @ref matrix_storage_order and AtUnsafe(index % Rows(), index / Rows())
+ *        for column-major one, so they can be assigned to storage of
+ *        the same order by single contiguous loop
+ */
+template<class T, class = void>
+struct is_matrix_linear : std::false_type {};
+
+template<class T>
+struct is_matrix_linear<T, std::enable_if_t<T::IsLinear>> : std::true_type {};
+
+// true_type if both are linear in the same order, so AtLinear(index) of them is the same element
+template<class T1, class T2>
+struct is_matrix_linear_together : std::integral_constant<bool, 
+    is_matrix_linear<T1>::value && is_matrix_linear<T2>::value && 
+    matrix_storage_order<T1>::value == matrix_storage_order<T2>::value> {};
+
+
+/**
+ * @brief Dimensions of matrix expressions known at compile time,
+ *        taken from StaticRows and StaticCols members.
+ *        MatrixDynamicSize for types without them.
+ */
+template<class T, class = void>
+struct matrix_static_rows : std::integral_constant<MatrixSizeType, MatrixDynamicSize> {};
+
+template<class T>
+struct matrix_static_rows<T, std::void_t<decltype(T::StaticRows)>> 
+    : std::integral_constant<MatrixSizeType, T::StaticRows> {};
+
+template<class T, class = void>
+struct matrix_static_cols : std::integral_constant<MatrixSizeType, MatrixDynamicSize> {};
+
+template<class T>
+struct matrix_static_cols<T, std::void_t<decltype(T::StaticCols)>> 
+    : std::integral_constant<MatrixSizeType, T::StaticCols> {};
+
+// true_type when both dimensions are known at compile time
+template<class T>
+struct is_matrix_static : std::integral_constant<bool, 
+    matrix_static_rows<T>::value != MatrixDynamicSize && matrix_static_cols<T>::value != MatrixDynamicSize> {};
+
+// Fixed-size MatrixT for static expressions, dynamic one otherwise
+template<class T, class ValT = typename T::ValueType>
+using matrix_evaluated_t = MatrixT<ValT,
+    is_matrix_static<T>::value ? matrix_static_rows<T>::value : MatrixDynamicSize,
+    is_matrix_static<T>::value ? matrix_static_cols<T>::value : MatrixDynamicSize>;
+
+// Static dimension of element-wise operation result
+constexpr MatrixSizeType MatrixCommonStaticSize(MatrixSizeType size1, MatrixSizeType size2) noexcept
+{
+    return size1 != MatrixDynamicSize ? size1 : size2;
+}
+
+// false only if both dimensions are static and differ
+constexpr bool IsMatrixStaticSizeEqual(MatrixSizeType size1, MatrixSizeType size2) noexcept
+{
+    return size1 == MatrixDynamicSize || size2 == MatrixDynamicSize || size1 == size2;
+}
+
+
 
 
 
@@ -247,11 +451,21 @@ public:
 
     MatrixUnaryOp(const typename OperationType::OperandType& matrixE) : matEx(matrixE) {};
 
+    static constexpr bool IsLinear = is_matrix_linear<OperationType>::value;
+    static constexpr MatrixStorageOrder StorageOrder = OperationType::StorageOrder;
+    static constexpr MatrixSizeType StaticRows = OperationType::StaticRows;
+    static constexpr MatrixSizeType StaticCols = OperationType::StaticCols;
+
     inline ValueType AtUnsafe(MatrixSizeType y, MatrixSizeType x) const
     {
         return OperationType::Operate(matEx, y, x);
     }
 
+    inline ValueType AtLinear(MatrixSizeType index) const
+    {
+        return OperationType::OperateLinear(matEx, index);
+    }
+
     inline MatrixSizeType Cols() const
     {
        return OperationType::Cols(matEx);
@@ -294,11 +508,21 @@ public:
 
     MatrixBinaryOp(const typename OperationType::LeftType& l, const typename OperationType::RightType& r) : left(l), right(r) {};
 
+    static constexpr bool IsLinear = is_matrix_linear<OperationType>::value;
+    static constexpr MatrixStorageOrder StorageOrder = OperationType::StorageOrder;
+    static constexpr MatrixSizeType StaticRows = OperationType::StaticRows;
+    static constexpr MatrixSizeType StaticCols = OperationType::StaticCols;
+
     inline ValueType AtUnsafe(MatrixSizeType y, MatrixSizeType x) const
     {
         return OperationType::Operate(left, right, y, x);
     }
 
+    inline ValueType AtLinear(MatrixSizeType index) const
+    {
+        return OperationType::OperateLinear(left, right, index);
+    }
+
     inline MatrixSizeType Cols() const
     {
        return OperationType::Cols(left, right);
@@ -309,7 +533,15 @@ public:
        return OperationType::Rows(left, right);
     }
 
+    inline const typename OperationType::LeftType& Left() const noexcept
+    {
+        return left;
+    }
 
+    inline const typename OperationType::RightType& Right() const noexcept
+    {
+        return right;
+    }
 
 private:
 
@@ -318,13 +550,274 @@ private:
 
 };
 
-template<class ValT>
-class MatrixT : public MatrixExpression<MatrixT<ValT>, ValT>
+/**
+ * @brief How assignment of matrix expression to MatrixT
+ *        is split between threads of ThreadPool.
+ *
+ * Output rows (flat index ranges for @ref is_matrix_linear expressions)
+ * are split into parts evaluated by the same code as serial assignment,
+ * so result doesn't depend on number of threads.
+ * MatrixT constructors and operator= use Global(),
+ * MatrixT::Assign(matEx, parallelism) is for one assignment.
+ */
+class MatrixParallelism
+{
+public:
+    static constexpr size_t DefaultMinOperations = 1 << 16;
+
+    // Serial evaluation
+    MatrixParallelism() = default;
+
+    /**
+     * @param threads threads evaluating one assignment, caller included,
+     *        0 is every worker of the pool and caller
+     * @param minOperations assignments of fewer element operations
+     *        (multiply-adds for products) are serial
+     * @param pPool nullptr is ThreadPool::Global()
+     */
+    explicit MatrixParallelism(size_t threads, size_t minOperations = DefaultMinOperations, ThreadPool* pPool = nullptr) noexcept
+        : m_nThreads(threads), m_nMinOperations(minOperations), m_pPool(pPool) {}
+
+    inline size_t Threads() const noexcept { return m_nThreads; }
+    inline size_t MinOperations() const noexcept { return m_nMinOperations; }
+    inline ThreadPool& Pool() const { return m_pPool ? *m_pPool : ThreadPool::Global(); }
+
+    /**
+     * @brief Calls func(begin, end) for consecutive parts of [0, count),
+     *        size of every part but the last is multiple of grain.
+     *
+     * @param operations work of all count items, decides
+     *        if it is worth to split
+     */
+    template<class Func>
+    void ForEachPart(size_t count, size_t operations, size_t grain, Func&& func) const
+    {
+        size_t parts = m_nThreads;
+        if(parts != 1 && operations >= m_nMinOperations)
+        {
+            const size_t poolThreads = Pool().Size() + 1;
+            parts = parts == 0 || parts > poolThreads ? poolThreads : parts;
+        }
+        else
+            parts = 1;
+        size_t partSize = (count + parts - 1) / (parts ? parts : 1);
+        partSize = (partSize + grain - 1) / grain * grain;
+        if(parts <= 1 || partSize >= count)
+        {
+            func(size_t(0), count);
+            return;
+        }
+        Pool().ParallelFor((count + partSize - 1) / partSize, [&](size_t part)
+        {
+            const size_t begin = part * partSize;
+            func(begin, count - begin < partSize ? count : begin + partSize);
+        });
+    }
+
+    static MatrixParallelism Global() noexcept
+    {
+        const GlobalSettings& settings = GetGlobalSettings();
+        return MatrixParallelism(settings.Threads.load(std::memory_order_relaxed),
+            settings.MinOperations.load(std::memory_order_relaxed),
+            settings.pPool.load(std::memory_order_relaxed));
+    }
+
+    // Meant to be called at startup, assignments running meanwhile may see it partially
+    static void SetGlobal(const MatrixParallelism& parallelism) noexcept
+    {
+        GlobalSettings& settings = GetGlobalSettings();
+        settings.Threads.store(parallelism.m_nThreads, std::memory_order_relaxed);
+        settings.MinOperations.store(parallelism.m_nMinOperations, std::memory_order_relaxed);
+        settings.pPool.store(parallelism.m_pPool, std::memory_order_relaxed);
+    }
+
+private:
+    struct GlobalSettings
+    {
+        std::atomic<size_t> Threads{1};
+        std::atomic<size_t> MinOperations{DefaultMinOperations};
+        std::atomic<ThreadPool*> pPool{nullptr};
+    };
+
+    static GlobalSettings& GetGlobalSettings() noexcept
+    {
+        static GlobalSettings settings;
+        return settings;
+    }
+
+    size_t m_nThreads = 1;
+    size_t m_nMinOperations = DefaultMinOperations;
+    ThreadPool* m_pPool = nullptr;
+};
+
+
+namespace details {
+
+/**
+ * @brief Gemm() of LeftT * RightT packs operands into and accumulates
+ *        in common type of their values (instead of converting them
+ *        to destination type first), so it writes straight into
+ *        storage of ValT only when both operands hold ValT.
+ */
+template<class LeftT, class RightT, class ValT>
+struct GemmOperandTypes
+{
+    using ValueType = typename std::common_type<typename LeftT::ValueType, typename RightT::ValueType>::type;
+
+    static constexpr bool IsEnabled = std::is_arithmetic<ValueType>::value;
+    static constexpr bool IsDirect = IsEnabled && 
+        std::is_same<typename LeftT::ValueType, ValT>::value && std::is_same<typename RightT::ValueType, ValT>::value;
+};
+
+// GemmOperandTypes of operands of product
+template<class Product, class ValT>
+using GemmProductTypes = GemmOperandTypes<typename Product::OperationType::LeftType, 
+    typename Product::OperationType::RightType, ValT>;
+
+// Gemm() or GemmAccumulate() split into parts of rows, multiples of micro-kernel rows
+template<class T, class LeftT, class RightT>
+void GemmByRows(const LeftT& a, const RightT& b, T* pC, size_t ldc, bool isAccumulating,
+    const MatrixParallelism& parallelism)
+{
+    parallelism.ForEachPart(a.Rows(), a.Rows() * b.Cols() * a.Cols(), GemmTraits<T>::MR,
+        [&](MatrixSizeType rowBegin, MatrixSizeType rowEnd)
+        {
+            if(isAccumulating)
+                GemmAccumulate(a, b, pC, ldc, rowBegin, rowEnd);
+            else
+                Gemm(a, b, pC, ldc, rowBegin, rowEnd);
+        });
+}
+
+// GemmByRows() into C with rows rowStride and columns colStride apart, one of them
+// has to be 1: column-major C is computed as row-major Transpose(B) * Transpose(A)
+template<class T, class LeftT, class RightT>
+void GemmByParts(const LeftT& a, const RightT& b, T* pC, MatrixSizeType rowStride, MatrixSizeType colStride,
+    bool isAccumulating, const MatrixParallelism& parallelism)
+{
+    if(colStride == 1)
+        GemmByRows(a, b, pC, rowStride, isAccumulating, parallelism);
+    else
+        GemmByRows(MatrixUnaryOp<MatrixTransposesOp<RightT>>(b), MatrixUnaryOp<MatrixTransposesOp<LeftT>>(a), 
+            pC, colStride, isAccumulating, parallelism);
+}
+
+} // namespace details
+
+
+/**
+ * @brief Block(), RowView(), ColView() and Diagonal() of matrices
+ *        storing their elements, T::View() references all of them.
+ *
+ * Views are valid while matrix lives and isn't reassigned or resized.
+ */
+template<class T, class ValT>
+class MatrixViewAccess
+{
+public:
+
+    inline MatrixView<ValT> Block(MatrixSizeType row, MatrixSizeType col, MatrixSizeType rows, MatrixSizeType cols)
+    {
+        return static_cast<T*>(this)->View().Block(row, col, rows, cols);
+    }
+
+    inline MatrixView<const ValT> Block(MatrixSizeType row, MatrixSizeType col, MatrixSizeType rows, MatrixSizeType cols) const
+    {
+        return static_cast<const T*>(this)->View().Block(row, col, rows, cols);
+    }
+
+    inline MatrixView<ValT> RowView(MatrixSizeType row)
+    {
+        return static_cast<T*>(this)->View().RowView(row);
+    }
+
+    inline MatrixView<const ValT> RowView(MatrixSizeType row) const
+    {
+        return static_cast<const T*>(this)->View().RowView(row);
+    }
+
+    inline MatrixView<ValT> ColView(MatrixSizeType col)
+    {
+        return static_cast<T*>(this)->View().ColView(col);
+    }
+
+    inline MatrixView<const ValT> ColView(MatrixSizeType col) const
+    {
+        return static_cast<const T*>(this)->View().ColView(col);
+    }
+
+    inline MatrixView<ValT> Diagonal() noexcept
+    {
+        return static_cast<T*>(this)->View().Diagonal();
+    }
+
+    inline MatrixView<const ValT> Diagonal() const noexcept
+    {
+        return static_cast<const T*>(this)->View().Diagonal();
+    }
+};
+
+
+namespace details {
+
+// Calls func(index) for every index in [begin, end) without a loop
+template<MatrixSizeType begin, MatrixSizeType end>
+struct MatrixUnrolled
+{
+    template<class Func>
+    static inline void Apply(Func& func)
+    {
+        func(begin);
+        MatrixUnrolled<begin + 1, end>::Apply(func);
+    }
+};
+
+template<MatrixSizeType end>
+struct MatrixUnrolled<end, end>
+{
+    template<class Func>
+    static inline void Apply(Func&) noexcept {}
+};
+
+// Bigger fixed-size matrices are assigned by loops
+constexpr MatrixSizeType MatrixMaxUnrolled = 64;
+
+} // namespace details
+
+
+/**
+ * @brief Matrix with dimensions and storage size fixed at compile time,
+ *        elements are stored inline (std::array), without heap allocation.
+ *
+ * Assignment of expression is unrolled up to details::MatrixMaxUnrolled elements.
+ * Layout can be MatrixDenseLayout or MatrixColMajorLayout.
+ * Operators check static shapes of fixed-size operands by static_assert,
+ * runtime checks remain for dynamic ones.
+ *
+ * @code{.cpp}
+ *     MatrixT<double, 3, 3> rotation = {{0, -1, 0}, {1, 0, 0}, {0, 0, 1}};
+ *     MatrixT<double, 3, 1> point = rotation * position;
+ * @endcode
+ */
+template<class ValT, MatrixSizeType rows, MatrixSizeType cols, class Layout>
+class MatrixT : public MatrixExpression<MatrixT<ValT, rows, cols, Layout>, ValT>,
+                public MatrixViewAccess<MatrixT<ValT, rows, cols, Layout>, ValT>
 {
+    static_assert(rows != MatrixDynamicSize && cols != MatrixDynamicSize,
+        "MatrixT dimensions have to be both fixed or both MatrixDynamicSize");
+    static_assert(!Layout::IsPadded, "Fixed-size MatrixT is always dense");
+
+    static constexpr bool IsColMajorStorage = Layout::Order == MatrixStorageOrder::ColMajor;
+
 public:
 
     using ValueType = ValT;
-    using ParentType = MatrixExpression<MatrixT<ValT>, ValT>;
+    using LayoutType = Layout;
+    using ParentType = MatrixExpression<MatrixT<ValT, rows, cols, Layout>, ValT>;
+
+    static constexpr MatrixSizeType StaticRows = rows;
+    static constexpr MatrixSizeType StaticCols = cols;
+    static constexpr MatrixStorageOrder StorageOrder = Layout::Order;
 
     MatrixT() = default;
     MatrixT(const MatrixT&) = default;
@@ -332,20 +825,20 @@ public:
     MatrixT& operator=(const MatrixT&) = default;
     MatrixT& operator=(MatrixT&&) noexcept = default;
 
-    MatrixT(MatrixSizeType rows, MatrixSizeType cols) : m_nRows(rows), m_nCols(cols), m_vData(cols*rows) {}
-
     template<class T, class MatExValT>
     MatrixT(const MatrixExpression<T, MatExValT>& matEx) 
-        : MatrixT(matEx.Rows(), matEx.Cols())
     {
-        AssignElems(matEx);
+        static_assert(IsMatrixStaticSizeEqual(matrix_static_rows<T>::value, rows) &&
+            IsMatrixStaticSizeEqual(matrix_static_cols<T>::value, cols),
+            "Matrix expression size differs from MatrixT size");
+        NICKSV_MATRIX_INVALID_ARG(is_matrix_static<T>::value || (matEx.Rows() == rows && matEx.Cols() == cols),
+            "Matrix expression size differs from MatrixT size");
+        AssignElems(static_cast<const T&>(matEx));
     }
 
     /**
      * @exception
-     * Strong exception guarantee
-     * 
-     * @sa AssignTryNoBuffer
+     * Strong exception guarantee if ValueType copy assignment doesn't throw
      */
     template<class T, class MatExValT>
     MatrixT& operator=(const MatrixExpression<T, MatExValT>& matEx)
@@ -353,73 +846,681 @@ public:
         if (static_cast<const void*>(this) == static_cast<const void*>(std::addressof(matEx)))
             return *this;
 
-        MatrixT<ValueType> buff(matEx);
-        std::swap(*this, buff);
+        // expression may read this matrix
+        MatrixT buff(matEx);
+        *this = buff;
+        return *this;
+    }
+
+    /**
+     * @brief In place, without buffer for element-wise expressions
+     *
+     * @exception
+     * Basic exception guarantee
+     */
+    template<class T, class MatExValT>
+    inline MatrixT& operator+=(const MatrixExpression<T, MatExValT>& matEx)
+    {
+        NoAlias(*this) += AsAliasSafe(*this, static_cast<const T&>(matEx));
         return *this;
     }
 
+    template<class T, class MatExValT>
+    inline MatrixT& operator-=(const MatrixExpression<T, MatExValT>& matEx)
+    {
+        NoAlias(*this) -= AsAliasSafe(*this, static_cast<const T&>(matEx));
+        return *this;
+    }
+
+    template<class NumberT>
+    inline auto operator*=(const NumberT& number)
+    -> std::enable_if_t<!is_matrix_expression<NumberT>::value, MatrixT&>
+    {
+        NoAlias(*this) = *this * number;
+        return *this;
+    }
 
     template<class ListValueT>
     MatrixT(std::initializer_list<std::initializer_list<ListValueT>> list) 
-        :   MatrixT(list.size(), list.size() ? list.begin()->size() : 0)
     {
-        auto vIter = m_vData.begin();
+        NICKSV_MATRIX_INVALID_ARG(list.size() == rows, 
+            "std::initializer_list should have as many rows as MatrixT");
+        MatrixSizeType y = 0;
         for(std::initializer_list<ListValueT> row : list)
         {
-            NICKSV_MATRIX_INVALID_ARG(row.size() == m_nCols, 
-                "Every row in std::initializer_list should have the same size");
+            NICKSV_MATRIX_INVALID_ARG(row.size() == cols, 
+                "Every row in std::initializer_list should have as many items as MatrixT columns");
+            MatrixSizeType x = 0;
             for(const ListValueT& item : row)
-                *(vIter++) = item;
+                AtUnsafe(y, x++) = item;
+            ++y;
         }
     }
 
-    
 
     inline void SetAll(const ValueType& value) 
         noexcept(noexcept(std::declval<ValueType&>() = std::declval<const ValueType&>()))
     {
-        for(ValueType& item : m_vData)
+        for(ValueType& item : m_aData)
             item = value;
     }
 
-    inline MatrixSizeType Cols() const noexcept
+    static constexpr MatrixSizeType Cols() noexcept
     {
-       return m_nCols;
+       return cols;
     }
     
-    inline MatrixSizeType Rows() const noexcept
+    static constexpr MatrixSizeType Rows() noexcept
     {
-       return m_nRows;
+       return rows;
     }
 
-    
     inline ValueType& AtUnsafe(MatrixSizeType y, MatrixSizeType x) noexcept
     {
-        return m_vData[ y * m_nCols + x ];
+        return m_aData[ IsColMajorStorage ? x * rows + y : y * cols + x ];
     }
 
     inline const ValueType& AtUnsafe(MatrixSizeType y, MatrixSizeType x) const noexcept
     {
-        return m_vData[ y * m_nCols + x ];
+        return m_aData[ IsColMajorStorage ? x * rows + y : y * cols + x ];
     }
 
-private:
-    
-    template<class T, class MatExValT>
-    void inline AssignElems(const MatrixExpression<T, MatExValT>& matEx)
+    static constexpr bool IsLinear = true;
+
+    inline const ValueType& AtLinear(MatrixSizeType index) const noexcept
     {
-        for(MatrixSizeType index = 0; index < m_nRows*m_nCols; ++index)
-            m_vData[index] = matEx.AtUnsafe(index / m_nCols, index % m_nCols);
+        return m_aData[index];
     }
 
+    inline ValueType* Data() noexcept
+    {
+        return m_aData.data();
+    }
 
-    MatrixSizeType m_nRows = 0;
-    MatrixSizeType m_nCols = 0;
-    std::vector<ValueType> m_vData;
-};
+    inline const ValueType* Data() const noexcept
+    {
+        return m_aData.data();
+    }
 
-template<class T, class ValT> 
-inline std::ostream& operator << (std::ostream& out, const MatrixExpression<T, ValT>& matEx)
+    // Distance between rows (columns of column-major storage) in elements
+    static constexpr MatrixSizeType Stride() noexcept
+    {
+        return IsColMajorStorage ? rows : cols;
+    }
+
+    inline MatrixView<ValueType> View() noexcept
+    {
+        return { Data(), rows, cols, IsColMajorStorage ? 1 : cols, IsColMajorStorage ? rows : 1 };
+    }
+
+    inline MatrixView<const ValueType> View() const noexcept
+    {
+        return { Data(), rows, cols, IsColMajorStorage ? 1 : cols, IsColMajorStorage ? rows : 1 };
+    }
+
+private:
+
+    template<class>
+    friend class MatrixNoAlias;
+
+    template<class T>
+    void inline AssignElems(const T& matEx)
+    {
+        auto assign = [&](MatrixSizeType index)
+        {
+            m_aData[index] = static_cast<ValueType>(At(matEx, index, is_matrix_linear_together<T, MatrixT>()));
+        };
+        ForEachIndex(assign, std::integral_constant<bool, (rows * cols <= details::MatrixMaxUnrolled)>());
+    }
+
+    template<class Func>
+    static inline void ForEachIndex(Func& func, std::true_type)
+    {
+        details::MatrixUnrolled<0, rows * cols>::Apply(func);
+    }
+
+    template<class Func>
+    static inline void ForEachIndex(Func& func, std::false_type)
+    {
+        for(MatrixSizeType index = 0; index < rows * cols; ++index)
+            func(index);
+    }
+
+    template<class T>
+    static inline auto At(const T& matEx, MatrixSizeType index, std::true_type)
+    -> decltype(matEx.AtLinear(index))
+    {
+        return matEx.AtLinear(index);
+    }
+
+    template<class T>
+    static inline auto At(const T& matEx, MatrixSizeType index, std::false_type)
+    -> decltype(matEx.AtUnsafe(index, index))
+    {
+        return IsColMajorStorage ? matEx.AtUnsafe(index % rows, index / rows) : matEx.AtUnsafe(index / cols, index % cols);
+    }
+
+
+    std::array<ValueType, rows * cols> m_aData{};
+};
+
+
+/**
+ * @brief Matrix with dimensions set at runtime, elements are
+ *        stored in std::vector as Layout says.
+ *
+ * Row y starts at Data() + y * Stride(), column x of column-major
+ * storage (Layout::Order) starts at Data() + x * Stride().
+ * Padded layouts (e.g. MatrixAlignedLayout) aren't @ref is_matrix_linear.
+ */
+template<class ValT, class Layout>
+class MatrixT<ValT, MatrixDynamicSize, MatrixDynamicSize, Layout> 
+    : public MatrixExpression<MatrixT<ValT, MatrixDynamicSize, MatrixDynamicSize, Layout>, ValT>,
+      public MatrixViewAccess<MatrixT<ValT, MatrixDynamicSize, MatrixDynamicSize, Layout>, ValT>
+{
+    static constexpr bool IsColMajorStorage = Layout::Order == MatrixStorageOrder::ColMajor;
+
+public:
+
+    using ValueType = ValT;
+    using LayoutType = Layout;
+    using ParentType = MatrixExpression<MatrixT<ValT, MatrixDynamicSize, MatrixDynamicSize, Layout>, ValT>;
+
+    static constexpr MatrixStorageOrder StorageOrder = Layout::Order;
+
+    MatrixT() = default;
+    MatrixT(const MatrixT&) = default;
+    MatrixT(MatrixT&&) noexcept = default;
+    MatrixT& operator=(const MatrixT&) = default;
+    MatrixT& operator=(MatrixT&&) noexcept = default;
+
+    MatrixT(MatrixSizeType rows, MatrixSizeType cols) 
+        : m_nRows(rows), m_nCols(cols), m_nStride(Layout::template Stride<ValueType>(IsColMajorStorage ? rows : cols)), 
+          m_vData(m_nStride * (IsColMajorStorage ? cols : rows)) {}
+
+    template<class T, class MatExValT>
+    MatrixT(const MatrixExpression<T, MatExValT>& matEx) 
+        : MatrixT(matEx, MatrixParallelism::Global())
+    {
+    }
+
+    template<class T, class MatExValT>
+    MatrixT(const MatrixExpression<T, MatExValT>& matEx, const MatrixParallelism& parallelism) 
+        : MatrixT(matEx.Rows(), matEx.Cols())
+    {
+        AssignElems(matEx, parallelism);
+    }
+
+    /**
+     * @exception
+     * Strong exception guarantee
+     * 
+     * @sa NoAlias() writes into existing elements instead
+     */
+    template<class T, class MatExValT>
+    MatrixT& operator=(const MatrixExpression<T, MatExValT>& matEx)
+    {
+        return Assign(matEx, MatrixParallelism::Global());
+    }
+
+    /**
+     * @brief Same as operator=, but evaluated as parallelism says
+     *        instead of MatrixParallelism::Global()
+     *
+     * @exception
+     * Strong exception guarantee
+     */
+    template<class T, class MatExValT>
+    MatrixT& Assign(const MatrixExpression<T, MatExValT>& matEx, const MatrixParallelism& parallelism)
+    {
+        if (static_cast<const void*>(this) == static_cast<const void*>(std::addressof(matEx)))
+            return *this;
+
+        MatrixT buff(matEx, parallelism);
+        std::swap(*this, buff);
+        return *this;
+    }
+
+    /**
+     * @brief In place, without buffer for element-wise expressions
+     *        (others are evaluated first, as they may read this matrix)
+     *
+     * @exception
+     * Basic exception guarantee
+     */
+    template<class T, class MatExValT>
+    inline MatrixT& operator+=(const MatrixExpression<T, MatExValT>& matEx)
+    {
+        NoAlias(*this) += AsAliasSafe(*this, static_cast<const T&>(matEx));
+        return *this;
+    }
+
+    // @sa operator+=
+    template<class T, class MatExValT>
+    inline MatrixT& operator-=(const MatrixExpression<T, MatExValT>& matEx)
+    {
+        NoAlias(*this) -= AsAliasSafe(*this, static_cast<const T&>(matEx));
+        return *this;
+    }
+
+    template<class NumberT>
+    inline auto operator*=(const NumberT& number)
+    -> std::enable_if_t<!is_matrix_expression<NumberT>::value, MatrixT&>
+    {
+        NoAlias(*this) = *this * number;
+        return *this;
+    }
+
+
+    template<class ListValueT>
+    MatrixT(std::initializer_list<std::initializer_list<ListValueT>> list) 
+        :   MatrixT(list.size(), list.size() ? list.begin()->size() : 0)
+    {
+        MatrixSizeType y = 0;
+        for(std::initializer_list<ListValueT> row : list)
+        {
+            NICKSV_MATRIX_INVALID_ARG(row.size() == m_nCols, 
+                "Every row in std::initializer_list should have the same size");
+            MatrixSizeType x = 0;
+            for(const ListValueT& item : row)
+                AtUnsafe(y, x++) = item;
+            ++y;
+        }
+    }
+
+    
+
+    inline void SetAll(const ValueType& value) 
+        noexcept(noexcept(std::declval<ValueType&>() = std::declval<const ValueType&>()))
+    {
+        for(ValueType& item : m_vData)
+            item = value;
+    }
+
+    inline MatrixSizeType Cols() const noexcept
+    {
+       return m_nCols;
+    }
+    
+    inline MatrixSizeType Rows() const noexcept
+    {
+       return m_nRows;
+    }
+
+    
+    inline ValueType& AtUnsafe(MatrixSizeType y, MatrixSizeType x) noexcept
+    {
+        return m_vData[ IsColMajorStorage ? x * m_nStride + y : y * m_nStride + x ];
+    }
+
+    inline const ValueType& AtUnsafe(MatrixSizeType y, MatrixSizeType x) const noexcept
+    {
+        return m_vData[ IsColMajorStorage ? x * m_nStride + y : y * m_nStride + x ];
+    }
+
+    static constexpr bool IsLinear = !Layout::IsPadded;
+
+    inline const ValueType& AtLinear(MatrixSizeType index) const noexcept
+    {
+        return Layout::IsPadded ? m_vData[index / InnerSize() * m_nStride + index % InnerSize()] : m_vData[index];
+    }
+
+    inline ValueType* Data() noexcept
+    {
+        return m_vData.data();
+    }
+
+    inline const ValueType* Data() const noexcept
+    {
+        return m_vData.data();
+    }
+
+    // Distance between rows (columns of column-major storage) in elements, not less than their size
+    inline MatrixSizeType Stride() const noexcept
+    {
+        return m_nStride;
+    }
+
+    // Guaranteed alignment of Data() and, for padded layouts, of every row
+    static constexpr size_t Alignment() noexcept
+    {
+        return Layout::template Alignment<ValueType>();
+    }
+
+    inline MatrixView<ValueType> View() noexcept
+    {
+        return { Data(), m_nRows, m_nCols, IsColMajorStorage ? 1 : m_nStride, IsColMajorStorage ? m_nStride : 1 };
+    }
+
+    inline MatrixView<const ValueType> View() const noexcept
+    {
+        return { Data(), m_nRows, m_nCols, IsColMajorStorage ? 1 : m_nStride, IsColMajorStorage ? m_nStride : 1 };
+    }
+
+private:
+
+    // Rows of row-major storage, columns of column-major one
+    inline MatrixSizeType OuterSize() const noexcept
+    {
+        return IsColMajorStorage ? m_nCols : m_nRows;
+    }
+
+    inline MatrixSizeType InnerSize() const noexcept
+    {
+        return IsColMajorStorage ? m_nRows : m_nCols;
+    }
+
+    template<class>
+    friend class MatrixNoAlias;
+
+    template<class T, class MatExValT>
+    void inline AssignElems(const MatrixExpression<T, MatExValT>& matEx)
+    {
+        AssignElems(matEx, MatrixParallelism::Global());
+    }
+    
+    template<class T, class MatExValT>
+    void inline AssignElems(const MatrixExpression<T, MatExValT>& matEx, const MatrixParallelism& parallelism)
+    {
+        AssignEachElem(matEx, parallelism);
+    }
+
+    // Product of arithmetic values is computed by Gemm() instead of
+    // dot product per element walking right operand column-wise,
+    // through buffer of details::GemmOperandTypes unless operands hold ValueType
+    template<class U, class V, class MatExValT>
+    void inline AssignElems(const MatrixExpression<MatrixBinaryOp<MatrixMultOp<U, V>>, MatExValT>& matEx,
+        const MatrixParallelism& parallelism)
+    {
+        using GemmTypes = details::GemmOperandTypes<U, V, ValueType>;
+        AssignProduct(static_cast<const MatrixBinaryOp<MatrixMultOp<U, V>>&>(matEx), parallelism,
+            std::integral_constant<bool, GemmTypes::IsEnabled>(),
+            std::integral_constant<bool, GemmTypes::IsDirect>());
+    }
+
+    template<class Product, class IsDirect>
+    void inline AssignProduct(const Product& product, const MatrixParallelism& parallelism, std::false_type, IsDirect)
+    {
+        AssignEachElem(product, parallelism);
+    }
+
+    template<class Product>
+    void inline AssignProduct(const Product& product, const MatrixParallelism& parallelism, std::true_type, std::true_type)
+    {
+        const auto view = View();
+        details::GemmByParts(product.Left(), product.Right(), view.Data(), view.RowStride(), view.ColStride(), false, parallelism);
+    }
+
+    template<class Product>
+    void inline AssignProduct(const Product& product, const MatrixParallelism& parallelism, std::true_type, std::false_type)
+    {
+        const auto view = View();
+        std::vector<typename details::GemmProductTypes<Product, ValueType>::ValueType> vBuff(m_vData.size());
+        details::GemmByParts(product.Left(), product.Right(), vBuff.data(), view.RowStride(), view.ColStride(), false, parallelism);
+        for(MatrixSizeType index = 0; index < vBuff.size(); ++index)
+            m_vData[index] = static_cast<ValueType>(vBuff[index]);
+    }
+
+    template<class T, class MatExValT>
+    void inline AssignEachElem(const MatrixExpression<T, MatExValT>& matEx, const MatrixParallelism& parallelism)
+    {
+        AssignEachElem(static_cast<const T&>(matEx), parallelism, is_matrix_linear_together<T, MatrixT>());
+    }
+
+    // Element-wise expressions (and Transpose() of other storage order)
+    // to dense storage: flat loops compilers can vectorize
+    template<class T>
+    void inline AssignEachElem(const T& matEx, const MatrixParallelism& parallelism, std::true_type)
+    {
+        ValueType* pData = m_vData.data();
+        parallelism.ForEachPart(m_vData.size(), m_vData.size(), NICKSV_CACHE_LINE_SIZE,
+            [&](MatrixSizeType begin, MatrixSizeType end)
+            {
+                for(MatrixSizeType index = begin; index < end; ++index)
+                    pData[index] = static_cast<ValueType>(matEx.AtLinear(index));
+            });
+    }
+
+    // Shape-changing ones (transpose, product...), other storage order and padded storage,
+    // by rows of row-major and columns of column-major storage
+    template<class T>
+    void inline AssignEachElem(const T& matEx, const MatrixParallelism& parallelism, std::false_type)
+    {
+        parallelism.ForEachPart(OuterSize(), m_vData.size(), 1,
+            [&](MatrixSizeType outerBegin, MatrixSizeType outerEnd)
+            {
+                for(MatrixSizeType outer = outerBegin; outer < outerEnd; ++outer)
+                    for(MatrixSizeType inner = 0; inner < InnerSize(); ++inner)
+                        m_vData[outer * m_nStride + inner] = static_cast<ValueType>(IsColMajorStorage ? 
+                            matEx.AtUnsafe(inner, outer) : matEx.AtUnsafe(outer, inner));
+            });
+    }
+
+
+    MatrixSizeType m_nRows = 0;
+    MatrixSizeType m_nCols = 0;
+    MatrixSizeType m_nStride = 0;
+    std::vector<ValueType, typename Layout::template Allocator<ValueType>> m_vData;
+};
+
+/**
+ * @brief Matrix expression referencing elements of other matrix
+ *        (RowStride() and ColStride() elements apart), nothing is copied.
+ *        Writable unless ElemT is const.
+ *
+ * Made by View(), Block(), RowView(), ColView(), Diagonal() of MatrixT
+ * and of other views. Like pointers, copies reference the same elements
+ * and const view can be written through, but assignment of view
+ * writes its elements.
+ *
+ * @code{.cpp}
+ *     mat.Block(0, 0, 2, 2) = Transpose(mat.Block(2, 2, 2, 2));
+ *     mat.Diagonal().SetAll(1);
+ * @endcode
+ */
+template<class ElemT>
+class MatrixView : public MatrixExpression<MatrixView<ElemT>, typename std::remove_const<ElemT>::type>
+{
+public:
+
+    using ValueType = typename std::remove_const<ElemT>::type;
+    using ElementType = ElemT;
+
+    MatrixView(ElementType* pData, MatrixSizeType rows, MatrixSizeType cols, 
+        MatrixSizeType rowStride, MatrixSizeType colStride) noexcept
+        : m_pData(pData), m_nRows(rows), m_nCols(cols), m_nRowStride(rowStride), m_nColStride(colStride) {}
+
+    MatrixView(const MatrixView&) = default;
+
+    template<class E = ElemT, class = std::enable_if_t<std::is_const<E>::value>>
+    MatrixView(const MatrixView<ValueType>& view) noexcept
+        : MatrixView(view.Data(), view.Rows(), view.Cols(), view.RowStride(), view.ColStride()) {}
+
+    MatrixView& operator=(const MatrixView& view)
+    {
+        return operator=<MatrixView, ValueType>(view);
+    }
+
+    /**
+     * @brief Writes elements, expression is evaluated first
+     *        as it may read them.
+     */
+    template<class T, class MatExValT>
+    MatrixView& operator=(const MatrixExpression<T, MatExValT>& matEx)
+    {
+        NoAlias(*this) = matrix_evaluated_t<T, ValueType>(matEx);
+        return *this;
+    }
+
+    // Expression is evaluated first, NoAlias(view) += matEx writes without buffer
+    template<class T, class MatExValT>
+    inline MatrixView& operator+=(const MatrixExpression<T, MatExValT>& matEx)
+    {
+        NoAlias(*this) += AsAliasSafe(*this, static_cast<const T&>(matEx));
+        return *this;
+    }
+
+    template<class T, class MatExValT>
+    inline MatrixView& operator-=(const MatrixExpression<T, MatExValT>& matEx)
+    {
+        NoAlias(*this) -= AsAliasSafe(*this, static_cast<const T&>(matEx));
+        return *this;
+    }
+
+    template<class NumberT>
+    inline auto operator*=(const NumberT& number)
+    -> std::enable_if_t<!is_matrix_expression<NumberT>::value, MatrixView&>
+    {
+        NoAlias(*this) = *this * number;
+        return *this;
+    }
+
+    inline void SetAll(const ValueType& value) const
+        noexcept(noexcept(std::declval<ValueType&>() = std::declval<const ValueType&>()))
+    {
+        for(MatrixSizeType row = 0; row < m_nRows; ++row)
+            for(MatrixSizeType col = 0; col < m_nCols; ++col)
+                AtUnsafe(row, col) = value;
+    }
+
+    inline MatrixSizeType Cols() const noexcept
+    {
+       return m_nCols;
+    }
+    
+    inline MatrixSizeType Rows() const noexcept
+    {
+       return m_nRows;
+    }
+
+    inline ElementType* Data() const noexcept
+    {
+        return m_pData;
+    }
+
+    inline MatrixSizeType RowStride() const noexcept
+    {
+        return m_nRowStride;
+    }
+
+    inline MatrixSizeType ColStride() const noexcept
+    {
+        return m_nColStride;
+    }
+
+    // True for views of column-major storage, @sa MatrixExpression::IsColMajor
+    inline bool IsColMajor() const noexcept
+    {
+        return m_nRowStride < m_nColStride;
+    }
+
+    inline ElementType& AtUnsafe(MatrixSizeType y, MatrixSizeType x) const noexcept
+    {
+        return m_pData[ y * m_nRowStride + x * m_nColStride ];
+    }
+
+    inline ElementType& At(MatrixSizeType y, MatrixSizeType x) const
+    {
+        NICKSV_MATRIX_INVALID_ARG(y < m_nRows && x < m_nCols, "At(y, x) - index param out of range");
+        return AtUnsafe(y, x);
+    }
+
+    inline ElementType& AtLinear(MatrixSizeType index) const noexcept
+    {
+        return AtUnsafe(index / m_nCols, index % m_nCols);
+    }
+
+    inline MatrixView Block(MatrixSizeType row, MatrixSizeType col, MatrixSizeType rows, MatrixSizeType cols) const
+    {
+        NICKSV_MATRIX_INVALID_ARG(row <= m_nRows && rows <= m_nRows - row && col <= m_nCols && cols <= m_nCols - col,
+            "Block(row, col, rows, cols) - block is out of range");
+        return { m_pData + row * m_nRowStride + col * m_nColStride, rows, cols, m_nRowStride, m_nColStride };
+    }
+
+    inline MatrixView RowView(MatrixSizeType row) const
+    {
+        return Block(row, 0, 1, m_nCols);
+    }
+
+    inline MatrixView ColView(MatrixSizeType col) const
+    {
+        return Block(0, col, m_nRows, 1);
+    }
+
+    // Main diagonal as column
+    inline MatrixView Diagonal() const noexcept
+    {
+        return { m_pData, m_nRows < m_nCols ? m_nRows : m_nCols, 1, m_nRowStride + m_nColStride, m_nColStride };
+    }
+
+    // Same as MatrixT::View()
+    inline MatrixView View() const noexcept
+    {
+        return *this;
+    }
+
+private:
+
+    template<class>
+    friend class MatrixNoAlias;
+
+    template<class T, class MatExValT>
+    void AssignElems(const MatrixExpression<T, MatExValT>& matEx)
+    {
+        static_assert(!std::is_const<ElementType>::value, "Elements of MatrixView<const T> can't be assigned");
+        AssignEachElem(static_cast<const T&>(matEx));
+    }
+
+    // Rows one by one, columns for views of column-major storage
+    template<class T>
+    void AssignEachElem(const T& matEx) const
+    {
+        if(IsColMajor())
+            for(MatrixSizeType col = 0; col < m_nCols; ++col)
+                for(MatrixSizeType row = 0; row < m_nRows; ++row)
+                    AtUnsafe(row, col) = static_cast<ValueType>(matEx.AtUnsafe(row, col));
+        else
+            for(MatrixSizeType row = 0; row < m_nRows; ++row)
+                for(MatrixSizeType col = 0; col < m_nCols; ++col)
+                    AtUnsafe(row, col) = static_cast<ValueType>(matEx.AtUnsafe(row, col));
+    }
+
+    // Product is computed by Gemm() when rows or columns are contiguous
+    // and both operands hold ValueType (@sa details::GemmOperandTypes)
+    template<class U, class V, class MatExValT>
+    void AssignElems(const MatrixExpression<MatrixBinaryOp<MatrixMultOp<U, V>>, MatExValT>& matEx)
+    {
+        static_assert(!std::is_const<ElementType>::value, "Elements of MatrixView<const T> can't be assigned");
+        const auto& product = static_cast<const MatrixBinaryOp<MatrixMultOp<U, V>>&>(matEx);
+        AssignProduct(product, std::integral_constant<bool, details::GemmOperandTypes<U, V, ValueType>::IsDirect>());
+    }
+
+    template<class Product>
+    void AssignProduct(const Product& product, std::true_type)
+    {
+        if(m_nColStride == 1 || m_nRowStride == 1)
+            details::GemmByParts(product.Left(), product.Right(), m_pData, m_nRowStride, m_nColStride, 
+                false, MatrixParallelism::Global());
+        else
+            AssignProduct(product, std::false_type());
+    }
+
+    template<class Product>
+    void AssignProduct(const Product& product, std::false_type)
+    {
+        AssignEachElem(product);
+    }
+
+    ElementType* m_pData;
+    MatrixSizeType m_nRows;
+    MatrixSizeType m_nCols;
+    MatrixSizeType m_nRowStride;
+    MatrixSizeType m_nColStride;
+};
+
+
+template<class T, class ValT> 
+inline std::ostream& operator << (std::ostream& out, const MatrixExpression<T, ValT>& matEx)
 {
     return out << matEx.ToString();
 }
@@ -442,6 +1543,20 @@ struct MatrixDefaultBinaryOp
     using RightType = RightT;
     using ReturnType = rangest_matrix_value_t<LeftType, RightType>;
 
+    // Element-wise operations declare it true and define
+    // "ReturnType OperateLinear(const LeftType& l, const RightType& r, MatrixSizeType index) const"
+    static constexpr bool IsLinear = false;
+
+    // Order of matrix operand (left one if both are)
+    static constexpr MatrixStorageOrder StorageOrder = 
+        matrix_storage_order<std::conditional_t<is_matrix_expression<LeftT>::value, LeftT, RightT>>::value;
+
+    // Shape changing operations redefine them
+    static constexpr MatrixSizeType StaticRows = 
+        MatrixCommonStaticSize(matrix_static_rows<LeftT>::value, matrix_static_rows<RightT>::value);
+    static constexpr MatrixSizeType StaticCols = 
+        MatrixCommonStaticSize(matrix_static_cols<LeftT>::value, matrix_static_cols<RightT>::value);
+
     template<class LT = LeftType>
     inline auto Cols(const LT& l, const RightType& r) const noexcept
     -> std::enable_if_t<is_matrix_expression<LT>::value, MatrixSizeType>
@@ -493,6 +1608,16 @@ struct MatrixDefaultUnaryOp
     using OperandType = MatExType;
     using ReturnType = RetT;
 
+    // Element-wise operations declare it true and define
+    // "ReturnType OperateLinear(const OperandType& m, MatrixSizeType index) const"
+    static constexpr bool IsLinear = false;
+
+    static constexpr MatrixStorageOrder StorageOrder = matrix_storage_order<MatExType>::value;
+
+    // Shape changing operations redefine them
+    static constexpr MatrixSizeType StaticRows = matrix_static_rows<MatExType>::value;
+    static constexpr MatrixSizeType StaticCols = matrix_static_cols<MatExType>::value;
+
     ReturnType Operate(const OperandType& m, MatrixSizeType y, MatrixSizeType x) const
     { 
         return static_cast<ReturnType>(m.AtUnsafe(y,x));
@@ -519,10 +1644,17 @@ struct MatrixPlusOp : MatrixDefaultBinaryOp<U, V>
     using RightType = V;
     using ReturnType = rangest_matrix_value_t<LeftType, RightType>;
 
+    static constexpr bool IsLinear = is_matrix_linear_together<LeftType, RightType>::value;
+
     ReturnType Operate(const LeftType& l, const RightType& r, MatrixSizeType y, MatrixSizeType x)  const
     { 
         return static_cast<ReturnType>(l.AtUnsafe(y,x) + r.AtUnsafe(y,x));
     };
+
+    ReturnType OperateLinear(const LeftType& l, const RightType& r, MatrixSizeType index)  const
+    { 
+        return static_cast<ReturnType>(l.AtLinear(index) + r.AtLinear(index));
+    };
 };
 
 template<class U , class V>
@@ -532,10 +1664,17 @@ struct MatrixBinaryMinusOp : MatrixDefaultBinaryOp<U, V>
     using RightType = V;
     using ReturnType = rangest_matrix_value_t<LeftType, RightType>;
 
+    static constexpr bool IsLinear = is_matrix_linear_together<LeftType, RightType>::value;
+
     ReturnType Operate(const LeftType& l, const RightType& r, MatrixSizeType y, MatrixSizeType x)  const
     { 
         return static_cast<ReturnType>(l.AtUnsafe(y,x) - r.AtUnsafe(y,x));
     };
+
+    ReturnType OperateLinear(const LeftType& l, const RightType& r, MatrixSizeType index)  const
+    { 
+        return static_cast<ReturnType>(l.AtLinear(index) - r.AtLinear(index));
+    };
 };
 
 template<class U , class V>
@@ -545,11 +1684,18 @@ struct MatrixMultOp : MatrixDefaultBinaryOp<U, V>
     using RightType = V;
     using ReturnType = rangest_matrix_value_t<LeftType, RightType>;
 
+    // Evaluated into row-major storage
+    static constexpr MatrixStorageOrder StorageOrder = MatrixStorageOrder::RowMajor;
+    static constexpr MatrixSizeType StaticRows = matrix_static_rows<LeftType>::value;
+    static constexpr MatrixSizeType StaticCols = matrix_static_cols<RightType>::value;
+
     ReturnType Operate(const LeftType& l, const RightType& r, MatrixSizeType y, MatrixSizeType x) const
     { 
+        // mixed operand types are multiplied in their common type
+        using CommonType = typename std::common_type<typename U::ValueType, typename V::ValueType>::type;
         ReturnType sum = 0;
         for(MatrixSizeType col = 0; col < r.Rows(); ++col)
-            sum += static_cast<ReturnType>(l.AtUnsafe(y, col) * r.AtUnsafe(col, x));
+            sum += static_cast<ReturnType>(static_cast<CommonType>(l.AtUnsafe(y, col)) * static_cast<CommonType>(r.AtUnsafe(col, x)));
         return sum;
     };
 
@@ -572,10 +1718,17 @@ struct MatrixMultNumOp : MatrixDefaultBinaryOp<NumberT, U>
     using RightType = U;
     using ReturnType = rangest_matrix_value_t<LeftType, RightType>;
 
+    static constexpr bool IsLinear = is_matrix_linear<RightType>::value;
+
     ReturnType Operate(const LeftType& n, const RightType& u, MatrixSizeType y, MatrixSizeType x)  const
     { 
         return static_cast<ReturnType>(n * u.AtUnsafe(y,x)); 
     };
+
+    ReturnType OperateLinear(const LeftType& n, const RightType& u, MatrixSizeType index)  const
+    { 
+        return static_cast<ReturnType>(n * u.AtLinear(index)); 
+    };
 };
 
 template<class U>
@@ -584,10 +1737,32 @@ struct MatrixUnaryMinusOp : MatrixDefaultUnaryOp<U>
     using OperandType = U;
     using ReturnType = decltype(-std::declval<OperandType>().AtUnsafe(std::declval<MatrixSizeType>(),std::declval<MatrixSizeType>()));
 
+    static constexpr bool IsLinear = is_matrix_linear<OperandType>::value;
+
     ReturnType Operate(const OperandType& u, MatrixSizeType y, MatrixSizeType x)  const
     { 
         return -u.AtUnsafe(y,x); 
     };
+
+    ReturnType OperateLinear(const OperandType& u, MatrixSizeType index)  const
+    { 
+        return -u.AtLinear(index); 
+    };
+};
+
+
+template<class U, class RetT>
+struct MatrixCastOp : MatrixDefaultUnaryOp<U, RetT>
+{
+    using OperandType = U;
+    using ReturnType = RetT;
+
+    static constexpr bool IsLinear = is_matrix_linear<OperandType>::value;
+
+    ReturnType OperateLinear(const OperandType& u, MatrixSizeType index)  const
+    { 
+        return static_cast<ReturnType>(u.AtLinear(index)); 
+    };
 };
 
 
@@ -597,11 +1772,22 @@ struct MatrixTransposesOp : MatrixDefaultUnaryOp<U>
     using OperandType = U;
     using ReturnType = typename OperandType::ValueType;
 
+    // Row-major storage read as column-major one, flat index is the same
+    static constexpr bool IsLinear = is_matrix_linear<OperandType>::value;
+    static constexpr MatrixStorageOrder StorageOrder = MatrixTransposedOrder(matrix_storage_order<OperandType>::value);
+    static constexpr MatrixSizeType StaticRows = matrix_static_cols<OperandType>::value;
+    static constexpr MatrixSizeType StaticCols = matrix_static_rows<OperandType>::value;
+
     ReturnType Operate(const OperandType& m, MatrixSizeType y, MatrixSizeType x)  const
     { 
         return m.AtUnsafe(x,y); 
     };
 
+    ReturnType OperateLinear(const OperandType& m, MatrixSizeType index)  const
+    { 
+        return m.AtLinear(index); 
+    };
+
     inline MatrixSizeType Rows(const OperandType& m) const noexcept
     {
        return m.Cols();
@@ -627,31 +1813,206 @@ struct MatrixConjugateOp : MatrixDefaultUnaryOp<U, RetT>
 };
 
 
+
+/**
+ * @brief Matrix expression evaluated once into shared MatrixT,
+ *        copies of it (e.g. by enclosing expressions) are cheap.
+ *
+ * Created by Eval() and in place of operands that
+ * is_matrix_operation_evaluated says are too costly to
+ * recompute per element.
+ * Fixed-size one holds its MatrixT by value, so
+ * static expressions don't allocate.
+ */
+template<class ValT, MatrixSizeType rows = MatrixDynamicSize, MatrixSizeType cols = MatrixDynamicSize>
+class MatrixTemporary : public MatrixExpression<MatrixTemporary<ValT, rows, cols>, ValT>
+{
+public:
+
+    using ValueType = ValT;
+
+    static constexpr MatrixSizeType StaticRows = rows;
+    static constexpr MatrixSizeType StaticCols = cols;
+
+    template<class T, class MatExValT>
+    explicit MatrixTemporary(const MatrixExpression<T, MatExValT>& matEx)
+        : m_Matrix(matEx) {}
+
+    static constexpr MatrixSizeType Cols() noexcept
+    {
+       return cols;
+    }
+    
+    static constexpr MatrixSizeType Rows() noexcept
+    {
+       return rows;
+    }
+
+    inline const ValueType& AtUnsafe(MatrixSizeType y, MatrixSizeType x) const noexcept
+    {
+        return m_Matrix.AtUnsafe(y, x);
+    }
+
+    static constexpr bool IsLinear = true;
+
+    inline const ValueType& AtLinear(MatrixSizeType index) const noexcept
+    {
+        return m_Matrix.AtLinear(index);
+    }
+
+    inline const MatrixT<ValueType, rows, cols>& Matrix() const noexcept
+    {
+        return m_Matrix;
+    }
+
+private:
+
+    MatrixT<ValueType, rows, cols> m_Matrix;
+};
+
+template<class ValT>
+class MatrixTemporary<ValT, MatrixDynamicSize, MatrixDynamicSize> 
+    : public MatrixExpression<MatrixTemporary<ValT>, ValT>
+{
+public:
+
+    using ValueType = ValT;
+
+    template<class T, class MatExValT>
+    explicit MatrixTemporary(const MatrixExpression<T, MatExValT>& matEx)
+        : m_spMatrix(std::make_shared<const MatrixT<ValueType>>(matEx)) {}
+
+    inline MatrixSizeType Cols() const noexcept
+    {
+       return m_spMatrix->Cols();
+    }
+    
+    inline MatrixSizeType Rows() const noexcept
+    {
+       return m_spMatrix->Rows();
+    }
+
+    inline const ValueType& AtUnsafe(MatrixSizeType y, MatrixSizeType x) const noexcept
+    {
+        return m_spMatrix->AtUnsafe(y, x);
+    }
+
+    static constexpr bool IsLinear = true;
+
+    inline const ValueType& AtLinear(MatrixSizeType index) const noexcept
+    {
+        return m_spMatrix->AtLinear(index);
+    }
+
+    inline const MatrixT<ValueType>& Matrix() const noexcept
+    {
+        return *m_spMatrix;
+    }
+
+private:
+
+    std::shared_ptr<const MatrixT<ValueType>> m_spMatrix;
+};
+
+
+/**
+ * @brief Evaluation policy of operands: true_type for operations whose
+ *        expression used as operand of another operation is evaluated
+ *        into MatrixTemporary when that operation is built.
+ *
+ * Every element of product is a dot product, so (A * B) * C
+ * would cost O(n^4) and A * B + C * D would multiply per element.
+ * Specialize for own operations with the same problem.
+ */
+template<class Operation>
+struct is_matrix_operation_evaluated : std::false_type {};
+
+template<class U, class V>
+struct is_matrix_operation_evaluated<MatrixMultOp<U, V>> : std::true_type {};
+
+
+template<class T, class = void>
+struct matrix_operand
+{
+    using type = T;
+
+    static inline const T& Make(const T& matEx) noexcept { return matEx; }
+};
+
+// MatrixTemporary holding evaluated T, fixed-size for static expressions
+template<class T, class ValT = typename T::ValueType>
+using matrix_temporary_t = MatrixTemporary<ValT,
+    matrix_static_rows<matrix_evaluated_t<T, ValT>>::value,
+    matrix_static_cols<matrix_evaluated_t<T, ValT>>::value>;
+
+template<class Operation>
+struct matrix_operand<MatrixBinaryOp<Operation>, std::enable_if_t<is_matrix_operation_evaluated<Operation>::value>>
+{
+    using type = matrix_temporary_t<MatrixBinaryOp<Operation>>;
+
+    static inline type Make(const MatrixBinaryOp<Operation>& matEx) { return type(matEx); }
+};
+
+template<class Operation>
+struct matrix_operand<MatrixUnaryOp<Operation>, std::enable_if_t<is_matrix_operation_evaluated<Operation>::value>>
+{
+    using type = matrix_temporary_t<MatrixUnaryOp<Operation>>;
+
+    static inline type Make(const MatrixUnaryOp<Operation>& matEx) { return type(matEx); }
+};
+
+template<class T>
+using matrix_operand_t = typename matrix_operand<T>::type;
+
+// Operand as it is stored by operations, @sa is_matrix_operation_evaluated
+template<class T>
+inline auto AsOperand(const T& matEx) -> decltype(matrix_operand<T>::Make(matEx))
+{
+    return matrix_operand<T>::Make(matEx);
+}
+
+
 //////////////////////////////////////////////////////////////////
 // FUNCTIONS
 //////////////////////////////////////////////////////////////////
 
 
+/**
+ * @brief Evaluates expression once, result can be used
+ *        in other expressions as many times as needed.
+ *
+ * Products used as operands are evaluated automatically
+ * (@ref is_matrix_operation_evaluated), Eval() is for other
+ * sub-expressions read more than once per element.
+ */
+template<class T, class ValT> 
+inline auto Eval(const MatrixExpression<T, ValT>& matEx)
+-> matrix_temporary_t<T, ValT>
+{
+    return matrix_temporary_t<T, ValT>(matEx);
+}
+
+
 template<class NewValT, class T, class ValT> 
 inline auto MatrixStaticCast(const MatrixExpression<T, ValT>& matEx)
--> MatrixUnaryOp<MatrixDefaultUnaryOp<T, NewValT>>
+-> MatrixUnaryOp<MatrixCastOp<matrix_operand_t<T>, NewValT>>
 {
-    return { static_cast<const T&>(matEx) };
+    return { AsOperand(static_cast<const T&>(matEx)) };
 }
 
 
 template<class T, class ValT> 
 inline auto Transpose(const MatrixExpression<T, ValT>& matEx)
--> MatrixUnaryOp<MatrixTransposesOp<T>>
+-> MatrixUnaryOp<MatrixTransposesOp<matrix_operand_t<T>>>
 {
-    return { static_cast<const T&>(matEx) };
+    return { AsOperand(static_cast<const T&>(matEx)) };
 }
 
 template<class T, class ValT> 
 inline auto Conjugate(const MatrixExpression<T, ValT>& matEx)
--> MatrixUnaryOp<MatrixConjugateOp<T>>
+-> MatrixUnaryOp<MatrixConjugateOp<matrix_operand_t<T>>>
 {
-    return { static_cast<const T&>(matEx) };
+    return { AsOperand(static_cast<const T&>(matEx)) };
 }
 
 
@@ -684,55 +2045,68 @@ template<class U , class UValT, class V , class VValT>
 auto operator + (
     const MatrixExpression<U, UValT>& left, 
     const MatrixExpression<V, VValT>& right)
--> MatrixBinaryOp<MatrixPlusOp<U, V>>
+-> MatrixBinaryOp<MatrixPlusOp<matrix_operand_t<U>, matrix_operand_t<V>>>
 {
+    static_assert(
+        IsMatrixStaticSizeEqual(matrix_static_rows<U>::value, matrix_static_rows<V>::value) &&
+        IsMatrixStaticSizeEqual(matrix_static_cols<U>::value, matrix_static_cols<V>::value),
+        "You can only add matrices with the same size");
     NICKSV_MATRIX_INVALID_ARG(
+        (is_matrix_static<U>::value && is_matrix_static<V>::value) || (
         (left.Rows() == right.Rows()) &&
         (left.Cols() == right.Cols()) &&
-        !left.IsEmpty(), 
+        !left.IsEmpty()), 
         "You can only add non-empty matrices with the same size");
-    return { static_cast<const U&>(left), static_cast<const V&>(right) };
+    return { AsOperand(static_cast<const U&>(left)), AsOperand(static_cast<const V&>(right)) };
 }
 
 
 template<class U , class UValT, class V , class VValT> 
 auto operator - (const MatrixExpression<U, UValT>& left, const MatrixExpression<V, VValT>& right)
--> MatrixBinaryOp<MatrixBinaryMinusOp<U, V>>
+-> MatrixBinaryOp<MatrixBinaryMinusOp<matrix_operand_t<U>, matrix_operand_t<V>>>
 {    
+    static_assert(
+        IsMatrixStaticSizeEqual(matrix_static_rows<U>::value, matrix_static_rows<V>::value) &&
+        IsMatrixStaticSizeEqual(matrix_static_cols<U>::value, matrix_static_cols<V>::value),
+        "You can only subtract matrices with the same size");
     NICKSV_MATRIX_INVALID_ARG(
+        (is_matrix_static<U>::value && is_matrix_static<V>::value) || (
         !left.IsEmpty() &&
         (left.Rows() == right.Rows()) &&
-        (left.Cols() == right.Cols()),
+        (left.Cols() == right.Cols())),
         "You can only subtract non-empty matrices with the same size");
-    return { static_cast<const U&>(left), static_cast<const V&>(right) };
+    return { AsOperand(static_cast<const U&>(left)), AsOperand(static_cast<const V&>(right)) };
 }
 
 
 template<class U , class UValT, class V , class VValT> 
 auto operator * (const MatrixExpression<U, UValT>& left, const MatrixExpression<V, VValT>& right)
--> MatrixBinaryOp<MatrixMultOp<U, V>>
+-> MatrixBinaryOp<MatrixMultOp<matrix_operand_t<U>, matrix_operand_t<V>>>
 {
+    static_assert(IsMatrixStaticSizeEqual(matrix_static_cols<U>::value, matrix_static_rows<V>::value),
+        "Incorrect matrix size during multiplication");
     NICKSV_MATRIX_INVALID_ARG(
+        (is_matrix_static<U>::value && is_matrix_static<V>::value) || (
         !left.IsEmpty() &&
         !right.IsEmpty() &&
-        (left.Cols() == right.Rows()), 
+        (left.Cols() == right.Rows())), 
         "Incorrect matrix size during multiplication");
-    return { static_cast<const U&>(left), static_cast<const V&>(right) };
+    return { AsOperand(static_cast<const U&>(left)), AsOperand(static_cast<const V&>(right)) };
 }
 
 template<class NumberT , class V , class VValT> 
 auto operator * (const NumberT& left, const MatrixExpression<V, VValT>& right)
 -> std::enable_if_t<!is_matrix_expression<NumberT>::value && is_multiplicable<NumberT, VValT>::value, 
-        MatrixBinaryOp<MatrixMultNumOp<NumberT, V>>>
+        MatrixBinaryOp<MatrixMultNumOp<NumberT, matrix_operand_t<V>>>>
 {
-    NICKSV_MATRIX_INVALID_ARG(!right.IsEmpty(), "Incorrect matrix size during multiplication");
-    return { left, static_cast<const V&>(right) };
+    NICKSV_MATRIX_INVALID_ARG(is_matrix_static<V>::value || !right.IsEmpty(), "Incorrect matrix size during multiplication");
+    return { left, AsOperand(static_cast<const V&>(right)) };
 }
 
 template<class NumberT , class V , class VValT> 
 auto operator * (const MatrixExpression<V, VValT>& left, const NumberT& right)
 -> std::enable_if_t<!is_matrix_expression<NumberT>::value && is_multiplicable<NumberT, VValT>::value, 
-        MatrixBinaryOp<MatrixMultNumOp<NumberT, V>>> 
+        MatrixBinaryOp<MatrixMultNumOp<NumberT, matrix_operand_t<V>>>> 
 {
     return operator*(right, left);
 }
@@ -741,10 +2115,170 @@ auto operator * (const MatrixExpression<V, VValT>& left, const NumberT& right)
 
 template<class U , class UValT> 
 auto operator - (const MatrixExpression<U, UValT>& m)
--> MatrixUnaryOp<MatrixUnaryMinusOp<U>>
+-> MatrixUnaryOp<MatrixUnaryMinusOp<matrix_operand_t<U>>>
 {    
-    NICKSV_MATRIX_INVALID_ARG(!m.IsEmpty(), "You can only subtract non-empty matrices with the same size");
-    return { static_cast<const U&>(m) };
+    NICKSV_MATRIX_INVALID_ARG(is_matrix_static<U>::value || !m.IsEmpty(), "You can only subtract non-empty matrices with the same size");
+    return { AsOperand(static_cast<const U&>(m)) };
+}
+
+
+//////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////
+
+
+
+
+
+//////////////////////////////////////////////////////////////////
+// ASSIGNMENT WITHOUT BUFFER
+//////////////////////////////////////////////////////////////////
+
+
+/**
+ * @brief Assignments made by NoAlias(): expression is written
+ *        straight into existing elements of MatrixT or MatrixView,
+ *        shapes have to match.
+ *
+ * Caller guarantees that expression doesn't read those elements
+ * at other positions than it writes (e.g. Transpose(m) or m * a),
+ * otherwise result is undefined.
+ * Element-wise expressions of the same matrix (m + a, 2 * m) are fine.
+ * Products are computed by Gemm() right into rows of matrix,
+ * += and -= of product accumulate without temporary.
+ */
+template<class MatrixType>
+class MatrixNoAlias
+{
+public:
+
+    using ValueType = typename MatrixType::ValueType;
+    // Views are held by value, so temporary Block() can be assigned
+    using StoredType = std::conditional_t<is_matrix<MatrixType>::value, MatrixType&, MatrixType>;
+
+    explicit MatrixNoAlias(StoredType mat) noexcept : m_Matrix(mat) {}
+
+    template<class T, class MatExValT>
+    StoredType operator=(const MatrixExpression<T, MatExValT>& matEx)
+    {
+        CheckSize(matEx);
+        m_Matrix.AssignElems(static_cast<const T&>(matEx));
+        return m_Matrix;
+    }
+
+    template<class T, class MatExValT>
+    StoredType operator+=(const MatrixExpression<T, MatExValT>& matEx)
+    {
+        CheckSize(matEx);
+        if(!m_Matrix.IsEmpty())
+            Add(static_cast<const T&>(matEx));
+        return m_Matrix;
+    }
+
+    template<class T, class MatExValT>
+    StoredType operator-=(const MatrixExpression<T, MatExValT>& matEx)
+    {
+        CheckSize(matEx);
+        if(!m_Matrix.IsEmpty())
+            Subtract(static_cast<const T&>(matEx));
+        return m_Matrix;
+    }
+
+private:
+
+    template<class T, class MatExValT>
+    void CheckSize(const MatrixExpression<T, MatExValT>& matEx) const
+    {
+        static_assert(IsMatrixStaticSizeEqual(matrix_static_rows<T>::value, matrix_static_rows<MatrixType>::value) &&
+            IsMatrixStaticSizeEqual(matrix_static_cols<T>::value, matrix_static_cols<MatrixType>::value),
+            "Matrix expression size differs from assigned matrix size");
+        NICKSV_MATRIX_INVALID_ARG(matEx.Rows() == m_Matrix.Rows() && matEx.Cols() == m_Matrix.Cols(),
+            "Matrix expression size differs from assigned matrix size");
+    }
+
+    template<class T>
+    void Add(const T& matEx)
+    {
+        m_Matrix.AssignElems(m_Matrix + matEx);
+    }
+
+    template<class U, class V>
+    void Add(const MatrixBinaryOp<MatrixMultOp<U, V>>& product)
+    {
+        Accumulate<details::GemmOperandTypes<U, V, ValueType>>(product.Left(), product.Right());
+    }
+
+    template<class T>
+    void Subtract(const T& matEx)
+    {
+        m_Matrix.AssignElems(m_Matrix - matEx);
+    }
+
+    template<class U, class V>
+    void Subtract(const MatrixBinaryOp<MatrixMultOp<U, V>>& product)
+    {
+        // negation is exact, so it is the same as subtracting A * B
+        Accumulate<details::GemmOperandTypes<U, V, ValueType>>(-product.Left(), product.Right());
+    }
+
+    // Gemm() accumulates straight into elements only if operands of product hold ValueType
+    template<class GemmTypes, class LeftT, class RightT>
+    void Accumulate(const LeftT& left, const RightT& right)
+    {
+        const auto view = m_Matrix.View();
+        const bool isGemm = GemmTypes::IsDirect && (view.ColStride() == 1 || view.RowStride() == 1);
+        if(isGemm)
+            details::GemmByParts(left, right, view.Data(), view.RowStride(), view.ColStride(), true, MatrixParallelism::Global());
+        else
+            m_Matrix.AssignElems(m_Matrix + Eval(left * right));
+    }
+
+    StoredType m_Matrix;
+};
+
+
+/**
+ * @brief Assignment into existing elements of mat, without buffer
+ *        operator= makes, @sa MatrixNoAlias
+ *
+ * @code{.cpp}
+ *     NoAlias(matC) = matA * matB;
+ *     NoAlias(matX) -= rate * matGrad;
+ *     NoAlias(mat.Block(0, 0, 4, 4)) += matA * matB;
+ * @endcode
+ */
+template<class ValT, MatrixSizeType rows, MatrixSizeType cols, class Layout>
+inline MatrixNoAlias<MatrixT<ValT, rows, cols, Layout>> NoAlias(MatrixT<ValT, rows, cols, Layout>& mat) noexcept
+{
+    return MatrixNoAlias<MatrixT<ValT, rows, cols, Layout>>(mat);
+}
+
+template<class ElemT>
+inline MatrixNoAlias<MatrixView<ElemT>> NoAlias(const MatrixView<ElemT>& view) noexcept
+{
+    return MatrixNoAlias<MatrixView<ElemT>>(view);
+}
+
+
+/**
+ * @brief Expression itself if it is linear together with matrix it is assigned to,
+ *        evaluated copy otherwise (always for views, they can overlap with operands).
+ *
+ * Linear expression in the same order reads matrix at the written index,
+ * Transpose() changes the order unless it is transposed back.
+ */
+template<class TargetT, class T>
+inline auto AsAliasSafe(const TargetT&, const T& matEx) noexcept
+-> std::enable_if_t<is_matrix_linear_together<T, TargetT>::value, const T&>
+{
+    return matEx;
+}
+
+template<class TargetT, class T>
+inline auto AsAliasSafe(const TargetT&, const T& matEx)
+-> std::enable_if_t<!is_matrix_linear_together<T, TargetT>::value, matrix_temporary_t<T>>
+{
+    return Eval(matEx);
 }
 
 
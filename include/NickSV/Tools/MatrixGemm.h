@@ -0,0 +1,330 @@
+#ifndef __NICKSV_MATRIX_GEMM_H__
+#define __NICKSV_MATRIX_GEMM_H__
+#pragma once
+
+
+#include <cstddef>
+#include <vector>
+
+
+#include "NickSV/Tools/Definitions.h"
+
+
+/**
+ * @def NICKSV_GEMM_AVX2
+ * @brief 1 if Gemm() uses AVX2/FMA micro-kernels for float and double
+ *        (default when compiler targets them, e.g. -mavx2 -mfma or -march=native),
+ *        define as 0 to force portable kernels
+ */
+#ifndef NICKSV_GEMM_AVX2
+    #if defined(__AVX2__) && defined(__FMA__)
+        #define NICKSV_GEMM_AVX2 1
+    #else
+        #define NICKSV_GEMM_AVX2 0
+    #endif
+#endif
+
+#if NICKSV_GEMM_AVX2
+    #include <immintrin.h>
+#endif
+
+
+namespace NickSV {
+namespace Tools {
+
+
+
+namespace details
+{
+
+/**
+ * @brief Micro-kernel in plain C++, compilers vectorize it
+ *        for whatever target they have.
+ *
+ * Kernel(kc, pA, pB, pTile) writes product of packed A panel
+ * (kc columns of mr values) and packed B panel (kc rows of nr values)
+ * into row-major mr x nr tile.
+ */
+template<class T, size_t mr, size_t nr>
+struct GemmPortableKernel
+{
+    static constexpr size_t MR = mr;
+    static constexpr size_t NR = nr;
+
+    static inline void Kernel(size_t kc, const T* pA, const T* pB, T* pTile) noexcept
+    {
+        T acc[mr][nr] = {};
+        for (size_t p = 0; p < kc; ++p, pA += mr, pB += nr)
+            for (size_t r = 0; r < mr; ++r)
+                for (size_t c = 0; c < nr; ++c)
+                    acc[r][c] = static_cast<T>(acc[r][c] + pA[r] * pB[c]);
+        for (size_t r = 0; r < mr; ++r)
+            for (size_t c = 0; c < nr; ++c)
+                pTile[r * nr + c] = acc[r][c];
+    }
+};
+
+
+/**
+ * @brief Register tile and cache blocking of Gemm() for T.
+ *
+ * KC x NR panel of B stays in L1, MC x KC block of A stays in L2,
+ * KC x NC block of B is shared by all row blocks of A.
+ * MC is multiple of MR and NC is multiple of NR.
+ */
+template<class T>
+struct GemmTraits : GemmPortableKernel<T, 4, 4>
+{
+    static constexpr size_t KC = 256;
+    static constexpr size_t MC = 64;
+    static constexpr size_t NC = 4096;
+};
+
+
+#if NICKSV_GEMM_AVX2
+
+// 6 x 8 tile in 12 ymm accumulators, 2 for B row and 1 for A broadcast
+template<>
+struct GemmTraits<double>
+{
+    static constexpr size_t MR = 6;
+    static constexpr size_t NR = 8;
+    static constexpr size_t KC = 256;
+    static constexpr size_t MC = 72;
+    static constexpr size_t NC = 4080;
+
+    static inline void Kernel(size_t kc, const double* pA, const double* pB, double* pTile) noexcept
+    {
+        __m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+        __m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+        __m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+        __m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+        __m256d c40 = _mm256_setzero_pd(), c41 = _mm256_setzero_pd();
+        __m256d c50 = _mm256_setzero_pd(), c51 = _mm256_setzero_pd();
+        for (size_t p = 0; p < kc; ++p, pA += MR, pB += NR)
+        {
+            const __m256d b0 = _mm256_loadu_pd(pB);
+            const __m256d b1 = _mm256_loadu_pd(pB + 4);
+            __m256d a = _mm256_broadcast_sd(pA);
+            c00 = _mm256_fmadd_pd(a, b0, c00); c01 = _mm256_fmadd_pd(a, b1, c01);
+            a = _mm256_broadcast_sd(pA + 1);
+            c10 = _mm256_fmadd_pd(a, b0, c10); c11 = _mm256_fmadd_pd(a, b1, c11);
+            a = _mm256_broadcast_sd(pA + 2);
+            c20 = _mm256_fmadd_pd(a, b0, c20); c21 = _mm256_fmadd_pd(a, b1, c21);
+            a = _mm256_broadcast_sd(pA + 3);
+            c30 = _mm256_fmadd_pd(a, b0, c30); c31 = _mm256_fmadd_pd(a, b1, c31);
+            a = _mm256_broadcast_sd(pA + 4);
+            c40 = _mm256_fmadd_pd(a, b0, c40); c41 = _mm256_fmadd_pd(a, b1, c41);
+            a = _mm256_broadcast_sd(pA + 5);
+            c50 = _mm256_fmadd_pd(a, b0, c50); c51 = _mm256_fmadd_pd(a, b1, c51);
+        }
+        _mm256_storeu_pd(pTile +  0, c00); _mm256_storeu_pd(pTile +  4, c01);
+        _mm256_storeu_pd(pTile +  8, c10); _mm256_storeu_pd(pTile + 12, c11);
+        _mm256_storeu_pd(pTile + 16, c20); _mm256_storeu_pd(pTile + 20, c21);
+        _mm256_storeu_pd(pTile + 24, c30); _mm256_storeu_pd(pTile + 28, c31);
+        _mm256_storeu_pd(pTile + 32, c40); _mm256_storeu_pd(pTile + 36, c41);
+        _mm256_storeu_pd(pTile + 40, c50); _mm256_storeu_pd(pTile + 44, c51);
+    }
+};
+
+// Same register layout as double, 8 floats per ymm
+template<>
+struct GemmTraits<float>
+{
+    static constexpr size_t MR = 6;
+    static constexpr size_t NR = 16;
+    static constexpr size_t KC = 256;
+    static constexpr size_t MC = 144;
+    static constexpr size_t NC = 4080;
+
+    static inline void Kernel(size_t kc, const float* pA, const float* pB, float* pTile) noexcept
+    {
+        __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+        __m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+        __m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+        __m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+        __m256 c40 = _mm256_setzero_ps(), c41 = _mm256_setzero_ps();
+        __m256 c50 = _mm256_setzero_ps(), c51 = _mm256_setzero_ps();
+        for (size_t p = 0; p < kc; ++p, pA += MR, pB += NR)
+        {
+            const __m256 b0 = _mm256_loadu_ps(pB);
+            const __m256 b1 = _mm256_loadu_ps(pB + 8);
+            __m256 a = _mm256_broadcast_ss(pA);
+            c00 = _mm256_fmadd_ps(a, b0, c00); c01 = _mm256_fmadd_ps(a, b1, c01);
+            a = _mm256_broadcast_ss(pA + 1);
+            c10 = _mm256_fmadd_ps(a, b0, c10); c11 = _mm256_fmadd_ps(a, b1, c11);
+            a = _mm256_broadcast_ss(pA + 2);
+            c20 = _mm256_fmadd_ps(a, b0, c20); c21 = _mm256_fmadd_ps(a, b1, c21);
+            a = _mm256_broadcast_ss(pA + 3);
+            c30 = _mm256_fmadd_ps(a, b0, c30); c31 = _mm256_fmadd_ps(a, b1, c31);
+            a = _mm256_broadcast_ss(pA + 4);
+            c40 = _mm256_fmadd_ps(a, b0, c40); c41 = _mm256_fmadd_ps(a, b1, c41);
+            a = _mm256_broadcast_ss(pA + 5);
+            c50 = _mm256_fmadd_ps(a, b0, c50); c51 = _mm256_fmadd_ps(a, b1, c51);
+        }
+        _mm256_storeu_ps(pTile +  0, c00); _mm256_storeu_ps(pTile +  8, c01);
+        _mm256_storeu_ps(pTile + 16, c10); _mm256_storeu_ps(pTile + 24, c11);
+        _mm256_storeu_ps(pTile + 32, c20); _mm256_storeu_ps(pTile + 40, c21);
+        _mm256_storeu_ps(pTile + 48, c30); _mm256_storeu_ps(pTile + 56, c31);
+        _mm256_storeu_ps(pTile + 64, c40); _mm256_storeu_ps(pTile + 72, c41);
+        _mm256_storeu_ps(pTile + 80, c50); _mm256_storeu_ps(pTile + 88, c51);
+    }
+};
+
+#endif // NICKSV_GEMM_AVX2
+
+
+// Operands without IsColMajor() (storage order of matrix expressions) are read by rows
+template<class MatExT>
+inline auto GemmIsColMajor(const MatExT& m, int) noexcept -> decltype(static_cast<bool>(m.IsColMajor()))
+{
+    return m.IsColMajor();
+}
+
+template<class MatExT>
+inline bool GemmIsColMajor(const MatExT&, long) noexcept
+{
+    return false;
+}
+
+// Packs rows [row0, row0 + rows) and columns [k0, k0 + kc) of A
+// into panels of mr rows, every panel column by column, zero padded.
+// A is read in its storage order.
+template<class T, size_t mr, class MatExT>
+void GemmPackA(const MatExT& a, size_t row0, size_t rows, size_t k0, size_t kc, T* pPacked)
+{
+    const bool isColMajor = GemmIsColMajor(a, 0);
+    for (size_t ir = 0; ir < rows; ir += mr, pPacked += mr * kc)
+    {
+        const size_t panelRows = rows - ir < mr ? rows - ir : mr;
+        if(isColMajor)
+            for (size_t p = 0; p < kc; ++p)
+                for (size_t r = 0; r < panelRows; ++r)
+                    pPacked[p * mr + r] = static_cast<T>(a.AtUnsafe(row0 + ir + r, k0 + p));
+        else
+            for (size_t r = 0; r < panelRows; ++r)
+                for (size_t p = 0; p < kc; ++p)
+                    pPacked[p * mr + r] = static_cast<T>(a.AtUnsafe(row0 + ir + r, k0 + p));
+        for (size_t r = panelRows; r < mr; ++r)
+            for (size_t p = 0; p < kc; ++p)
+                pPacked[p * mr + r] = T{};
+    }
+}
+
+// Packs rows [k0, k0 + kc) and columns [col0, col0 + cols) of B
+// into panels of nr columns, every panel row by row, zero padded.
+// B is read in its storage order.
+template<class T, size_t nr, class MatExT>
+void GemmPackB(const MatExT& b, size_t k0, size_t kc, size_t col0, size_t cols, T* pPacked)
+{
+    const bool isColMajor = GemmIsColMajor(b, 0);
+    for (size_t jr = 0; jr < cols; jr += nr, pPacked += nr * kc)
+    {
+        const size_t panelCols = cols - jr < nr ? cols - jr : nr;
+        if(isColMajor)
+            for (size_t c = 0; c < panelCols; ++c)
+                for (size_t p = 0; p < kc; ++p)
+                    pPacked[p * nr + c] = static_cast<T>(b.AtUnsafe(k0 + p, col0 + jr + c));
+        else
+            for (size_t p = 0; p < kc; ++p)
+                for (size_t c = 0; c < panelCols; ++c)
+                    pPacked[p * nr + c] = static_cast<T>(b.AtUnsafe(k0 + p, col0 + jr + c));
+        for (size_t p = 0; p < kc; ++p)
+            for (size_t c = panelCols; c < nr; ++c)
+                pPacked[p * nr + c] = T{};
+    }
+}
+
+} // namespace details
+
+
+/**
+ * @brief C += A * B, where A and B are any matrix expressions
+ *        (each element is read once while packing, in storage order
+ *        of expression, and converted to T) and C is row-major with
+ *        leading dimension ldc.
+ *
+ * Cache-blocked GEMM: blocks of A and B are packed into contiguous
+ * panels, register tiles of C are computed by micro-kernel of
+ * details::GemmTraits<T> (AVX2/FMA for float and double when
+ * @ref NICKSV_GEMM_AVX2 is 1, portable one otherwise).
+ *
+ * Summation order differs from MatrixMultOp::Operate(),
+ * so floating point results may differ in last bits.
+ * It doesn't depend on row range, so C computed by parts
+ * is the same as computed at once.
+ *
+ * @param rowBegin, rowEnd only these rows of C are computed
+ */
+template<class T, class LeftT, class RightT>
+void GemmAccumulate(const LeftT& a, const RightT& b, T* pC, size_t ldc, size_t rowBegin, size_t rowEnd)
+{
+    using Traits = details::GemmTraits<T>;
+    const size_t mr = Traits::MR;
+    const size_t nr = Traits::NR;
+    const size_t rows = rowEnd - rowBegin;
+    const size_t cols = b.Cols();
+    const size_t depth = a.Cols();
+    pC += rowBegin * ldc;
+
+    const size_t ncBlock = Traits::NC;
+    const size_t kcBlock = Traits::KC;
+    const size_t mcBlock = Traits::MC;
+    const size_t ncMax = cols < ncBlock ? (cols + nr - 1) / nr * nr : ncBlock;
+    const size_t kcMax = depth < kcBlock ? depth : kcBlock;
+    const size_t mcMax = rows < mcBlock ? (rows + mr - 1) / mr * mr : mcBlock;
+    std::vector<T> vecPackedA(mcMax * kcMax);
+    std::vector<T> vecPackedB(ncMax * kcMax);
+    T tile[Traits::MR * Traits::NR];
+
+    for (size_t jc = 0; jc < cols; jc += ncMax)
+    {
+        const size_t nc = cols - jc < ncMax ? cols - jc : ncMax;
+        for (size_t pc = 0; pc < depth; pc += kcMax)
+        {
+            const size_t kc = depth - pc < kcMax ? depth - pc : kcMax;
+            details::GemmPackB<T, Traits::NR>(b, pc, kc, jc, nc, vecPackedB.data());
+            for (size_t ic = 0; ic < rows; ic += mcMax)
+            {
+                const size_t mc = rows - ic < mcMax ? rows - ic : mcMax;
+                details::GemmPackA<T, Traits::MR>(a, rowBegin + ic, mc, pc, kc, vecPackedA.data());
+                for (size_t jr = 0; jr < nc; jr += nr)
+                {
+                    const size_t tileCols = nc - jr < nr ? nc - jr : nr;
+                    for (size_t ir = 0; ir < mc; ir += mr)
+                    {
+                        const size_t tileRows = mc - ir < mr ? mc - ir : mr;
+                        Traits::Kernel(kc, vecPackedA.data() + ir * kc, vecPackedB.data() + jr * kc, tile);
+                        T* pTileC = pC + (ic + ir) * ldc + jc + jr;
+                        for (size_t r = 0; r < tileRows; ++r)
+                            for (size_t c = 0; c < tileCols; ++c)
+                                pTileC[r * ldc + c] = static_cast<T>(pTileC[r * ldc + c] + tile[r * nr + c]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// C = A * B, @sa GemmAccumulate
+template<class T, class LeftT, class RightT>
+void Gemm(const LeftT& a, const RightT& b, T* pC, size_t ldc, size_t rowBegin, size_t rowEnd)
+{
+    for (size_t y = rowBegin; y < rowEnd; ++y)
+        for (size_t x = 0; x < b.Cols(); ++x)
+            pC[y * ldc + x] = T{};
+    GemmAccumulate(a, b, pC, ldc, rowBegin, rowEnd);
+}
+
+template<class T, class LeftT, class RightT>
+inline void Gemm(const LeftT& a, const RightT& b, T* pC, size_t ldc)
+{
+    Gemm(a, b, pC, ldc, 0, a.Rows());
+}
+
+
+
+}}
+
+
+#endif // __NICKSV_MATRIX_GEMM_H__
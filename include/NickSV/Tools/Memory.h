@@ -8,6 +8,9 @@
 
 #include <stdexcept>
 #include <memory>
+#include <new>
+#include <limits>
+#include <cstdint>
 
 // • NICKSV_NOT_NULL_IGNORE - if defined, 
 //   NotNull<T> is just an empty template (using NotNull<T> = T) 
@@ -579,6 +582,72 @@ inline auto MakeShared(Args&&... args)
 }
 
 
+
+/**
+ * @brief Allocator returning memory aligned to alignment bytes,
+ *        e.g. for containers read by aligned SIMD loads.
+ *
+ * @code{.cpp}
+ *     std::vector<float, AlignedAllocator<float, 32>> vecData(size);
+ * @endcode
+ */
+template<class T, size_t alignment = NICKSV_CACHE_LINE_SIZE>
+class AlignedAllocator
+{
+    static_assert(alignment >= alignof(T) && (alignment & (alignment - 1)) == 0,
+        "Alignment has to be power of 2 not less than alignof(T)");
+
+public:
+    using value_type = T;
+
+    template<class U>
+    struct rebind { using other = AlignedAllocator<U, alignment>; };
+
+    static constexpr size_t Alignment = alignment;
+
+    AlignedAllocator() noexcept = default;
+
+    template<class U>
+    AlignedAllocator(const AlignedAllocator<U, alignment>&) noexcept {}
+
+    T* allocate(size_t count)
+    {
+        if(count > (std::numeric_limits<size_t>::max() - alignment - sizeof(void*)) / sizeof(T))
+            NICKSV_THROW(std::bad_alloc{});
+        #ifdef __cpp_aligned_new
+        return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(alignment)));
+        #else
+        // original pointer is kept right before aligned block
+        void* pRaw = ::operator new(count * sizeof(T) + alignment + sizeof(void*));
+        const uintptr_t address = (reinterpret_cast<uintptr_t>(pRaw) + sizeof(void*) + alignment - 1) & ~uintptr_t(alignment - 1);
+        reinterpret_cast<void**>(address)[-1] = pRaw;
+        return reinterpret_cast<T*>(address);
+        #endif
+    }
+
+    void deallocate(T* pData, size_t) noexcept
+    {
+        #ifdef __cpp_aligned_new
+        ::operator delete(pData, std::align_val_t(alignment));
+        #else
+        ::operator delete(reinterpret_cast<void**>(pData)[-1]);
+        #endif
+    }
+};
+
+template<class T, class U, size_t alignment>
+inline bool operator==(const AlignedAllocator<T, alignment>&, const AlignedAllocator<U, alignment>&) noexcept
+{
+    return true;
+}
+
+template<class T, class U, size_t alignment>
+inline bool operator!=(const AlignedAllocator<T, alignment>&, const AlignedAllocator<U, alignment>&) noexcept
+{
+    return false;
+}
+
+
 }}
 
 
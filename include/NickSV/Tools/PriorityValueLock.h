@@ -0,0 +1,376 @@
+
+#ifndef _NICKSV_PRIORITY_VALUELOCK
+#define _NICKSV_PRIORITY_VALUELOCK
+#pragma once
+
+
+#include "NickSV/Tools/ValueLock.h"
+
+
+#include <condition_variable>
+#include <chrono>
+#include <mutex>
+#include <list>
+
+
+
+
+namespace NickSV {
+namespace Tools {
+
+
+
+/**
+ * @class PriorityValueLock
+ *
+ * @brief Same as @ref DynamicValueLock, but threads waiting
+ *        for the same value get it in order of priority
+ *        instead of arbitrary std::mutex order.
+ *
+ * Unlocking thread hands the value off to the waiter with the
+ * highest effective priority:
+ * priority + (time waited / agingQuantum),
+ * so low priority waiter gets one level up every agingQuantum
+ * and is never starved. Waiters of the same effective priority
+ * get the value in order of arrival.
+ * @code{.cpp}
+ *     // PriorityValueLock<ID> usersLock declared before
+ *     // interactive request
+ *     usersLock.Lock(id, 10);
+ *     mapUsers.at(id).doSomething();
+ *     usersLock.Unlock(id);
+ *     // background reindexing
+ *     if(usersLock.TryLockFor(id, std::chrono::milliseconds(100)))  // priority 0
+ *     {
+ *         mapUsers.at(id).reindex();
+ *         usersLock.Unlock(id);
+ *     }
+ * @endcode
+ */
+template<typename ValueT>
+class PriorityValueLock
+{
+public:
+
+    static_assert(std::is_default_constructible<ValueT>::value, "ValueT must be default constructible");
+    static_assert(     is_equality_comparable<ValueT>::value, "ValueT must has equality operator overloaded");
+    static_assert(std::is_copy_constructible<ValueT>::value, "ValueT must be copy constructible");
+    static_assert(std::is_copy_assignable<ValueT>::value, "ValueT must be copy assignable");
+
+    using ValueType = ValueT;
+    using PriorityType = int32_t;
+    using Clock = std::chrono::steady_clock;
+
+
+    /**
+     * @class Unlocker
+     *
+     * @brief Unary functor that calls Unlock(value)
+     *        on given pointer to PriorityValueLock
+     *        with value.
+     *
+     * @warning
+     * Invoking throws the same exception as PriorityValueLock::Unlock(value) if there is no stack unwinding,
+     * otherwise printing error message to std::cerr and returns
+     *
+    */
+    class Unlocker
+    {
+        ValueType m_Value;
+    public:
+        Unlocker() = default;
+        DECLARE_RULE_OF_5_DEFAULT(Unlocker, NOTHING);
+        explicit Unlocker(const ValueType& value) : m_Value(value) {}
+
+        /**
+         * @throws
+         * Same exception as PriorityValueLock::Unlock(value) if there is no stack unwinding,
+         * otherwise printing error message to std::cerr and returns
+         */
+        inline void operator()(PriorityValueLock* pValueLock) const
+        {
+            #if NICKSV_EXCEPTIONS
+            try { pValueLock->Unlock(m_Value); }
+            catch(const std::exception& e)
+            {
+                #ifdef __cpp_lib_uncaught_exceptions
+                if(!std::uncaught_exceptions()) throw;
+                #else
+                if(!std::uncaught_exception()) throw;
+                #endif
+                std::cerr << "Unlocker::operator() caught std::exception in call of PriorityValueLock::Unlock()"
+                             "during stack unwinding, it won't be rethrown. std::exception::what(): "
+                          << e.what() << std::endl;
+            }
+            #else
+            pValueLock->Unlock(m_Value);
+            #endif
+        }
+    };
+
+    /**
+     * @class UnlockerAll
+     *
+     * @brief Unary functor that calls UnlockAll([value])
+     *        on given pointer to PriorityValueLock
+     *        with value.
+     *
+     * @warning
+     * Invoking throws the same exception as PriorityValueLock::UnlockAll([value]) if there is no stack unwinding,
+     * otherwise printing error message to std::cerr and returns
+     *
+    */
+    class UnlockerAll
+    {
+        std::unique_ptr<ValueType> m_upKeepLockedValue;
+    public:
+        UnlockerAll() = default;
+        DECLARE_RULE_OF_5_DEFAULT(UnlockerAll, NOTHING);
+        explicit UnlockerAll(const ValueType& keepLockedValue)
+            : m_upKeepLockedValue(new ValueType(keepLockedValue)) {}
+
+        /**
+         * @throws
+         * Same exception as PriorityValueLock::UnlockAll([value]) if there is no stack unwinding,
+         * otherwise printing error message to std::cerr and returns
+         */
+        inline void operator()(PriorityValueLock* pValueLock) const
+        {
+            #if NICKSV_EXCEPTIONS
+            try
+            {
+                if(m_upKeepLockedValue)
+                    pValueLock->UnlockAll(*m_upKeepLockedValue);
+                else
+                    pValueLock->UnlockAll();
+            }
+            catch(const std::exception& e)
+            {
+                #ifdef __cpp_lib_uncaught_exceptions
+                if(!std::uncaught_exceptions()) throw;
+                #else
+                if(!std::uncaught_exception()) throw;
+                #endif
+                std::cerr << "UnlockerAll::operator() caught std::exception in call of PriorityValueLock::UnlockAll()"
+                             "during stack unwinding, it won't be rethrown. std::exception::what(): "
+                          << e.what() << std::endl;
+            }
+            #else
+            if(m_upKeepLockedValue)
+                pValueLock->UnlockAll(*m_upKeepLockedValue);
+            else
+                pValueLock->UnlockAll();
+            #endif
+        }
+    };
+
+
+    // Non-copyable, non-movable
+    DECLARE_RULE_OF_5_DELETE(PriorityValueLock);
+
+    /**
+     * @param agingQuantum waiting time that raises
+     *        waiter's priority by one
+     */
+    explicit PriorityValueLock(Clock::duration agingQuantum = std::chrono::milliseconds(10))
+        : m_agingQuantum(agingQuantum)
+    {
+        NICKSV_ASSERT(agingQuantum > Clock::duration::zero(), "PriorityValueLock aging quantum must be positive");
+    }
+
+    /**
+     * @brief Locks given value, waiters with higher
+     *        priority get the value earlier.
+     */
+    void Lock(const ValueType& value, PriorityType priority = 0) noexcept(false)
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        m_cvLockAllWaiter.wait(uLock, [this]{ return !m_bIsLockingAll; });
+        auto iterState = FindSlot(value);
+        if(iterState == m_listValueStates.end())
+        {
+            TakeSlot(value);
+            return;
+        }
+        auto iterWaiter = Enqueue(*iterState, priority);
+        iterWaiter->Condition.wait(uLock, [&iterWaiter]{ return iterWaiter->Granted; });
+        iterState->Waiters.erase(iterWaiter);
+    }
+
+    /**
+     * @brief Same as Lock(value, priority), but gives up
+     *        after relTime is elapsed.
+     *
+     * @returns true if value is locked
+     */
+    template<class Rep, class Period>
+    bool TryLockFor(const ValueType& value,
+        const std::chrono::duration<Rep, Period>& relTime, PriorityType priority = 0) noexcept(false)
+    {
+        auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(relTime);
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        if(!m_cvLockAllWaiter.wait_until(uLock, deadline, [this]{ return !m_bIsLockingAll; }))
+            return false;
+        auto iterState = FindSlot(value);
+        if(iterState == m_listValueStates.end())
+        {
+            TakeSlot(value);
+            return true;
+        }
+        auto iterWaiter = Enqueue(*iterState, priority);
+        bool isLocked = iterWaiter->Condition.wait_until(uLock, deadline, [&iterWaiter]{ return iterWaiter->Granted; });
+        iterState->Waiters.erase(iterWaiter);
+        return isLocked;
+    }
+
+    bool TryLock(const ValueType& value) noexcept(false)
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        if(m_bIsLockingAll || FindSlot(value) != m_listValueStates.end())
+            return false;
+        TakeSlot(value);
+        return true;
+    }
+
+    /**
+     * @brief Unlocks given value, hands it off
+     *        to the waiter with the highest
+     *        effective priority.
+     *
+     * @warning PriorityValueLock::Lock(value) must be called
+     * by the current thread of execution,
+     * otherwise, the behavior is undefined.
+     */
+    void Unlock(const ValueType& value) noexcept(false)
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        auto iterState = FindSlot(value);
+        NICKSV_ASSERT(iterState != m_listValueStates.end(), INVALID_VALUE_ERROR_TEXT);
+        auto iterWaiter = FindNextOwner(*iterState);
+        if(iterWaiter != iterState->Waiters.end())
+        {
+            iterWaiter->Granted = true;
+            iterWaiter->Condition.notify_one();
+            return;
+        }
+        m_listValueStates.erase(iterState);
+        if(m_listValueStates.empty())
+            m_cvEmptyListWaiter.notify_one();
+    }
+
+    /**
+     * @brief Locks every value
+     */
+    void LockAll() noexcept(false)
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        m_cvLockAllWaiter.wait(uLock, [this]{ return !m_bIsLockingAll; });
+        m_bIsLockingAll = true;
+        m_cvEmptyListWaiter.wait(uLock, [this]{ return m_listValueStates.empty(); });
+    }
+
+    /**
+     * @brief Unlocks all values.
+     *
+     * @warning PriorityValueLock::LockAll() must be called
+     * by the current thread of execution,
+     * otherwise, the behavior is undefined.
+     */
+    void UnlockAll() noexcept
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        NICKSV_ASSERT(m_bIsLockingAll, CONCURRENCY_ERROR_TEXT);
+        m_bIsLockingAll = false;
+        m_cvLockAllWaiter.notify_all();
+    }
+
+    /**
+     * @brief Unlocks all values except given one.
+     *
+     * @warning PriorityValueLock::LockAll() must be called
+     * by the current thread of execution,
+     * otherwise, the behavior is undefined.
+     */
+    void UnlockAll(const ValueType& keepLockedValue) noexcept(false)
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        NICKSV_ASSERT(m_bIsLockingAll, CONCURRENCY_ERROR_TEXT);
+        TakeSlot(keepLockedValue);
+        m_bIsLockingAll = false;
+        m_cvLockAllWaiter.notify_all();
+    }
+
+private:
+    struct Waiter
+    {
+        Waiter(PriorityType priority, Clock::time_point since) : Priority(priority), Since(since) {}
+        std::condition_variable Condition;
+        PriorityType Priority;
+        Clock::time_point Since;
+        bool Granted = false;
+    };
+
+    // Slot exists while value is held
+    struct ValueState
+    {
+        explicit ValueState(const ValueType& value) : Value(value) {}
+        ValueType Value;
+        // In order of arrival
+        std::list<Waiter> Waiters;
+    };
+
+    inline auto Enqueue(ValueState& state, PriorityType priority) -> typename std::list<Waiter>::iterator
+    {
+        state.Waiters.emplace_back(priority, Clock::now());
+        auto iterWaiter = state.Waiters.end();
+        return --iterWaiter;
+    }
+
+    // Aging changes the order over time, so
+    // waiters are ranked at the moment of hand off
+    auto FindNextOwner(ValueState& state) const -> typename std::list<Waiter>::iterator
+    {
+        const auto now = Clock::now();
+        auto iterBest = state.Waiters.end();
+        int64_t bestPriority = 0;
+        for (auto iterWaiter = state.Waiters.begin(); iterWaiter != state.Waiters.end(); ++iterWaiter)
+        {
+            if(iterWaiter->Granted)
+                continue;
+            int64_t priority = iterWaiter->Priority + static_cast<int64_t>((now - iterWaiter->Since) / m_agingQuantum);
+            if(iterBest == state.Waiters.end() || priority > bestPriority)
+            {
+                iterBest = iterWaiter;
+                bestPriority = priority;
+            }
+        }
+        return iterBest;
+    }
+
+    inline auto FindSlot(const ValueType& value) noexcept -> typename std::list<ValueState>::iterator
+    {
+        return std::find_if(m_listValueStates.begin(), m_listValueStates.end(),
+                [&value](const ValueState& state) noexcept { return value == state.Value; });
+    }
+    inline void TakeSlot(const ValueType& value)
+    {
+        m_listValueStates.emplace_back(value);
+    }
+
+    const Clock::duration m_agingQuantum;
+    std::list<ValueState> m_listValueStates;
+    std::mutex m_mtx;
+    std::condition_variable m_cvLockAllWaiter;
+    std::condition_variable m_cvEmptyListWaiter;
+    bool m_bIsLockingAll = false;
+};
+
+
+template<typename ValueT>
+struct is_value_lock<PriorityValueLock<ValueT>> : std::true_type {};
+
+
+}}  /*END OF NAMESPACES*/
+
+
+#endif // _NICKSV_PRIORITY_VALUELOCK
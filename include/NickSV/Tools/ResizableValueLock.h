@@ -0,0 +1,413 @@
+
+#ifndef _NICKSV_RESIZABLE_VALUELOCK
+#define _NICKSV_RESIZABLE_VALUELOCK
+#pragma once
+
+
+#include "NickSV/Tools/ValueLock.h"
+
+
+#include <atomic>
+#include <condition_variable>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <list>
+
+
+
+
+namespace NickSV {
+namespace Tools {
+
+
+
+/**
+ * @class ResizableValueLock
+ *
+ * @brief Same as @ref ValueLock, but slot table is allocated
+ *        at runtime, grows when all slots are busy
+ *        and shrinks when most of them are idle.
+ *
+ * Nothing is allocated while there is a free slot (unlike
+ * @ref DynamicValueLock). Resize replaces the table under
+ * the inner mutex: new table becomes current, old one is retired,
+ * but its busy slots keep working until unlocked and it is freed
+ * when the last one is unlocked, so holders never wait for resize
+ * and their values are not moved. Lookups take the inner mutex
+ * too, as in DynamicValueLock.
+ *
+ * Table grows twice when full and shrinks twice when no more
+ * than a quarter of current table size is in use. Shrinking is
+ * done by the next Lock() of a new value or by ShrinkToFit(),
+ * so Unlock() never allocates.
+ * SlotHighWater() tells how many slots are really needed.
+ */
+template<typename ValueT>
+class ResizableValueLock
+{
+public:
+
+    static_assert(std::is_default_constructible<ValueT>::value, "ValueT must be default constructible");
+    static_assert(     is_equality_comparable<ValueT>::value, "ValueT must has equality operator overloaded");
+    static_assert(std::is_copy_constructible<ValueT>::value, "ValueT must be copy constructible");
+    static_assert(std::is_copy_assignable<ValueT>::value, "ValueT must be copy assignable");
+
+    using ValueType = ValueT;
+
+    struct ValueMutex
+    {
+        std::mutex Mutex;
+        ValueType Value = ValueType();
+        uint32_t RefCount = 0;
+    };
+
+
+    /**
+     * @class Unlocker
+     *
+     * @brief Unary functor that calls Unlock(value)
+     *        on given pointer to ResizableValueLock
+     *        with value.
+     *
+     * @warning
+     * Invoking throws the same exception as ResizableValueLock::Unlock(value) if there is no stack unwinding,
+     * otherwise printing error message to std::cerr and returns
+     *
+    */
+    class Unlocker
+    {
+        ValueType m_Value;
+    public:
+        Unlocker() = default;
+        DECLARE_RULE_OF_5_DEFAULT(Unlocker, NOTHING);
+        explicit Unlocker(const ValueType& value) : m_Value(value) {}
+
+        /**
+         * @throws
+         * Same exception as ResizableValueLock::Unlock(value) if there is no stack unwinding,
+         * otherwise printing error message to std::cerr and returns
+         */
+        inline void operator()(ResizableValueLock* pValueLock) const
+        {
+            #if NICKSV_EXCEPTIONS
+            try { pValueLock->Unlock(m_Value); }
+            catch(const std::exception& e)
+            {
+                #ifdef __cpp_lib_uncaught_exceptions
+                if(!std::uncaught_exceptions()) throw;
+                #else
+                if(!std::uncaught_exception()) throw;
+                #endif
+                std::cerr << "Unlocker::operator() caught std::exception in call of ResizableValueLock::Unlock()"
+                             "during stack unwinding, it won't be rethrown. std::exception::what(): "
+                          << e.what() << std::endl;
+            }
+            #else
+            pValueLock->Unlock(m_Value);
+            #endif
+        }
+    };
+
+    /**
+     * @class UnlockerAll
+     *
+     * @brief Unary functor that calls UnlockAll([value])
+     *        on given pointer to ResizableValueLock
+     *        with value.
+     *
+     * @warning
+     * Invoking throws the same exception as ResizableValueLock::UnlockAll([value]) if there is no stack unwinding,
+     * otherwise printing error message to std::cerr and returns
+     *
+    */
+    class UnlockerAll
+    {
+        std::unique_ptr<ValueType> m_upKeepLockedValue;
+    public:
+        UnlockerAll() = default;
+        DECLARE_RULE_OF_5_DEFAULT(UnlockerAll, NOTHING);
+        explicit UnlockerAll(const ValueType& keepLockedValue)
+            : m_upKeepLockedValue(new ValueType(keepLockedValue)) {}
+
+        /**
+         * @throws
+         * Same exception as ResizableValueLock::UnlockAll([value]) if there is no stack unwinding,
+         * otherwise printing error message to std::cerr and returns
+         */
+        inline void operator()(ResizableValueLock* pValueLock) const
+        {
+            #if NICKSV_EXCEPTIONS
+            try
+            {
+                if(m_upKeepLockedValue)
+                    pValueLock->UnlockAll(*m_upKeepLockedValue);
+                else
+                    pValueLock->UnlockAll();
+            }
+            catch(const std::exception& e)
+            {
+                #ifdef __cpp_lib_uncaught_exceptions
+                if(!std::uncaught_exceptions()) throw;
+                #else
+                if(!std::uncaught_exception()) throw;
+                #endif
+                std::cerr << "UnlockerAll::operator() caught std::exception in call of ResizableValueLock::UnlockAll()"
+                             "during stack unwinding, it won't be rethrown. std::exception::what(): "
+                          << e.what() << std::endl;
+            }
+            #else
+            if(m_upKeepLockedValue)
+                pValueLock->UnlockAll(*m_upKeepLockedValue);
+            else
+                pValueLock->UnlockAll();
+            #endif
+        }
+    };
+
+
+    // Non-copyable, non-movable
+    DECLARE_RULE_OF_5_DELETE(ResizableValueLock);
+
+    /**
+     * @param initialSlotCount slots preallocated at construction
+     * @param minSlotCount table never shrinks below it
+     */
+    explicit ResizableValueLock(size_t initialSlotCount = 16, size_t minSlotCount = 0)
+        : m_nMinSlotCount(minSlotCount ? minSlotCount : initialSlotCount)
+    {
+        NICKSV_ASSERT(initialSlotCount > 0, "ResizableValueLock initial slot count must be positive");
+        SwapTable(initialSlotCount);
+    }
+
+    void Lock(const ValueType& value) noexcept(false)
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        m_cvLockAllWaiter.wait(uLock, [this]{ return !m_bIsLockingAll; });
+        ValueMutex* pMutex = EnterSlot(value);
+        uLock.unlock();
+        pMutex->Mutex.lock();
+    }
+
+    /**
+     * @brief Locks every value
+     */
+    void LockAll() noexcept(false)
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        m_cvLockAllWaiter.wait(uLock, [this]{ return !m_bIsLockingAll; });
+        m_bIsLockingAll = true;
+        m_cvEmptyWaiter.wait(uLock, [this]{ return SlotsInUse() == 0; });
+    }
+
+    /**
+     * @brief Unlocks given value.
+     *
+     * @warning ResizableValueLock::Lock(value) must be called
+     * by the current thread of execution,
+     * otherwise, the behavior is undefined.
+     */
+    void Unlock(const ValueType& value) noexcept
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        auto found = FindBusySlot(value);
+        NICKSV_ASSERT(found.second, INVALID_VALUE_ERROR_TEXT);
+        found.second->Mutex.unlock();
+        LeaveSlot(found.first, *found.second);
+    }
+
+    /**
+     * @brief Unlocks all values.
+     *
+     * @warning ResizableValueLock::LockAll() must be called
+     * by the current thread of execution,
+     * otherwise, the behavior is undefined.
+     */
+    void UnlockAll() noexcept
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        NICKSV_ASSERT(m_bIsLockingAll, CONCURRENCY_ERROR_TEXT);
+        m_bIsLockingAll = false;
+        m_cvLockAllWaiter.notify_all();
+    }
+
+    /**
+     * @brief Unlocks all values except given one.
+     *
+     * @warning ResizableValueLock::LockAll() must be called
+     * by the current thread of execution,
+     * otherwise, the behavior is undefined.
+     */
+    void UnlockAll(const ValueType& keepLockedValue) noexcept(false)
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        NICKSV_ASSERT(m_bIsLockingAll, CONCURRENCY_ERROR_TEXT);
+        EnterSlot(keepLockedValue)->Mutex.lock();
+        m_bIsLockingAll = false;
+        m_cvLockAllWaiter.notify_all();
+    }
+
+    bool TryLock(const ValueType& value) noexcept(false)
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        if(m_bIsLockingAll)
+            return false;
+        auto found = FindBusySlot(value);
+        if(found.second && found.second->RefCount)
+            return false;
+        EnterSlot(value)->Mutex.lock();
+        return true;
+    }
+
+    /**
+     * @brief Makes current table at least slotCount
+     *        slots large (it can shrink later
+     *        down to the minimal slot count).
+     */
+    void Reserve(size_t slotCount) noexcept(false)
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        if(slotCount > m_listTables.front().Size)
+            SwapTable(slotCount);
+    }
+
+    /**
+     * @brief Shrinks current table while no more than
+     *        a quarter of it is in use (but not below
+     *        the minimal slot count), e.g. when idle.
+     */
+    void ShrinkToFit() noexcept(false)
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        const size_t inUse = m_nInUse.load(std::memory_order_relaxed);
+        size_t newSize = m_listTables.front().Size;
+        while (newSize > m_nMinSlotCount && inUse * 4 <= newSize)
+            newSize = std::max(m_nMinSlotCount, newSize / 2);
+        if(newSize != m_listTables.front().Size)
+            SwapTable(newSize);
+    }
+
+    /**
+     * @returns size of current slot table
+     */
+    size_t SlotCapacity() const noexcept { return m_nCapacity.load(std::memory_order_relaxed); }
+
+    /**
+     * @returns busy slots in current and retired tables
+     */
+    size_t SlotsInUse() const noexcept { return m_nInUse.load(std::memory_order_relaxed); }
+
+    /**
+     * @returns maximal SlotsInUse() since construction
+     */
+    size_t SlotHighWater() const noexcept { return m_nHighWater.load(std::memory_order_relaxed); }
+
+    /**
+     * @returns number of retired tables that still have busy slots
+     */
+    size_t RetiredTables() const noexcept { return m_nRetired.load(std::memory_order_relaxed); }
+
+private:
+    struct SlotTable
+    {
+        explicit SlotTable(size_t size) : Slots(new ValueMutex[size]), Size(size) {}
+        std::unique_ptr<ValueMutex[]> Slots;
+        size_t Size;
+        size_t InUse = 0;
+    };
+    using TableIter = typename std::list<SlotTable>::iterator;
+
+    // Current table first, then retired ones
+    auto FindBusySlot(const ValueType& value) noexcept -> std::pair<TableIter, ValueMutex*>
+    {
+        for (auto iterTable = m_listTables.begin(); iterTable != m_listTables.end(); ++iterTable)
+        {
+            if(!iterTable->InUse)
+                continue;
+            auto pEnd = iterTable->Slots.get() + iterTable->Size;
+            auto pMutex = std::find_if(iterTable->Slots.get(), pEnd,
+                [&value](const ValueMutex& mutex) noexcept { return mutex.RefCount && value == mutex.Value; });
+            if(pMutex != pEnd)
+                return std::make_pair(iterTable, pMutex);
+        }
+        return std::make_pair(m_listTables.end(), static_cast<ValueMutex*>(nullptr));
+    }
+
+    ValueMutex* EnterSlot(const ValueType& value)
+    {
+        auto found = FindBusySlot(value);
+        if(found.second)
+        {
+            ++(found.second->RefCount);
+            return found.second;
+        }
+        SlotTable* pTable = &m_listTables.front();
+        const size_t inUse = m_nInUse.load(std::memory_order_relaxed);
+        if(pTable->InUse == pTable->Size)
+            SwapTable(pTable->Size * 2);
+        else if(pTable->Size > m_nMinSlotCount && inUse * 4 <= pTable->Size)
+            SwapTable(std::max(m_nMinSlotCount, pTable->Size / 2));
+        pTable = &m_listTables.front();
+        auto pMutex = std::find_if(pTable->Slots.get(), pTable->Slots.get() + pTable->Size,
+            [](const ValueMutex& mutex) noexcept { return mutex.RefCount == 0; });
+        pMutex->Value = value;
+        pMutex->RefCount = 1;
+        ++(pTable->InUse);
+        m_nInUse.store(inUse + 1, std::memory_order_relaxed);
+        if(inUse + 1 > m_nHighWater.load(std::memory_order_relaxed))
+            m_nHighWater.store(inUse + 1, std::memory_order_relaxed);
+        return pMutex;
+    }
+
+    // Doesn't allocate, shrinking is left to the next EnterSlot()
+    void LeaveSlot(TableIter iterTable, ValueMutex& vMutex) noexcept
+    {
+        if(--(vMutex.RefCount))
+            return;
+        --(iterTable->InUse);
+        auto inUse = m_nInUse.load(std::memory_order_relaxed) - 1;
+        m_nInUse.store(inUse, std::memory_order_relaxed);
+        if(iterTable != m_listTables.begin() && !iterTable->InUse)
+        {
+            // Last busy slot of retired table is unlocked,
+            // nobody can reference the table anymore
+            m_listTables.erase(iterTable);
+            m_nRetired.store(m_listTables.size() - 1, std::memory_order_relaxed);
+        }
+        if(!inUse)
+            m_cvEmptyWaiter.notify_all();
+    }
+
+    // Busy slots stay where they are, new values
+    // take slots in new table
+    void SwapTable(size_t newSize)
+    {
+        m_listTables.emplace_front(newSize);
+        auto iterOld = std::next(m_listTables.begin());
+        if(iterOld != m_listTables.end() && !iterOld->InUse)
+            m_listTables.erase(iterOld);
+        m_nCapacity.store(newSize, std::memory_order_relaxed);
+        m_nRetired.store(m_listTables.size() - 1, std::memory_order_relaxed);
+    }
+
+    std::list<SlotTable> m_listTables;
+    const size_t m_nMinSlotCount;
+    std::atomic<size_t> m_nCapacity{0};
+    std::atomic<size_t> m_nInUse{0};
+    std::atomic<size_t> m_nHighWater{0};
+    std::atomic<size_t> m_nRetired{0};
+    std::mutex m_mtx;
+    std::condition_variable m_cvLockAllWaiter;
+    std::condition_variable m_cvEmptyWaiter;
+    bool m_bIsLockingAll = false;
+};
+
+
+template<typename ValueT>
+struct is_value_lock<ResizableValueLock<ValueT>> : std::true_type {};
+
+
+}}  /*END OF NAMESPACES*/
+
+
+#endif // _NICKSV_RESIZABLE_VALUELOCK
@@ -0,0 +1,214 @@
+#ifndef _NICKSV_THREAD_POOL
+#define _NICKSV_THREAD_POOL
+#pragma once
+
+
+#include "NickSV/Tools/Definitions.h"
+
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <type_traits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+
+
+namespace NickSV {
+namespace Tools {
+
+
+
+/**
+ * @class ThreadPool
+ *
+ * @brief Threads started once and reused by every ParallelFor(),
+ *        so splitting work between them costs a wake-up,
+ *        not thread creation.
+ *
+ * @code{.cpp}
+ *     ThreadPool::Global().ParallelFor(partCount, [&](size_t part)
+ *     {
+ *         process(part);
+ *     });
+ * @endcode
+ *
+ * One ParallelFor() runs at a time: call made while pool is busy
+ * (by other thread or from inside of a task) runs its tasks
+ * in the calling thread instead of waiting.
+ */
+class ThreadPool
+{
+public:
+    DECLARE_RULE_OF_5_DELETE(ThreadPool);
+
+    /**
+     * @param threadCount worker threads, the thread
+     *        calling ParallelFor() works too
+     */
+    explicit ThreadPool(size_t threadCount)
+    {
+        m_vecThreads.reserve(threadCount);
+        for (size_t i = 0; i < threadCount; ++i)
+            m_vecThreads.emplace_back([this]{ WorkerLoop(); });
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lockGuard(m_mtx);
+            m_bStop = true;
+        }
+        m_cvStart.notify_all();
+        for (auto& thread : m_vecThreads)
+            thread.join();
+    }
+
+    // Worker threads, without the caller of ParallelFor()
+    inline size_t Size() const noexcept { return m_vecThreads.size(); }
+
+    /**
+     * @brief Calls task(index) for every index in [0, count)
+     *        on workers and the calling thread, returns when
+     *        all calls are done.
+     *
+     * Which thread gets which index is not defined,
+     * so task result must not depend on it.
+     *
+     * @throws First exception thrown by task, after all other calls are done
+     */
+    template<typename Func>
+    void ParallelFor(size_t count, Func&& task)
+    {
+        bool isIdle = false;
+        if(count <= 1 || m_vecThreads.empty() || 
+           !m_bBusy.compare_exchange_strong(isIdle, true, std::memory_order_acquire, std::memory_order_relaxed))
+        {
+            for (size_t index = 0; index < count; ++index)
+                task(index);
+            return;
+        }
+        BusyGuard busyGuard{m_bBusy};
+
+        {
+            std::lock_guard<std::mutex> lockGuard(m_mtx);
+            m_pTask = std::addressof(task);
+            m_pfnInvoke = &Invoke<typename std::remove_reference<Func>::type>;
+            m_nCount = count;
+            m_nNext.store(0, std::memory_order_relaxed);
+            m_nRunning = m_vecThreads.size();
+            m_pException = nullptr;
+            ++m_nGeneration;
+        }
+        m_cvStart.notify_all();
+        RunTasks();
+
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        m_cvDone.wait(uLock, [this]{ return m_nRunning == 0; });
+        m_pTask = nullptr;
+        m_pfnInvoke = nullptr;
+        #if NICKSV_EXCEPTIONS
+        if(m_pException)
+        {
+            std::exception_ptr pException = m_pException;
+            m_pException = nullptr;
+            std::rethrow_exception(pException);
+        }
+        #endif
+    }
+
+    /**
+     * @brief Pool shared by whole program, with
+     *        std::thread::hardware_concurrency() - 1 workers.
+     */
+    static ThreadPool& Global()
+    {
+        static ThreadPool pool(std::thread::hardware_concurrency() > 1 ?
+            std::thread::hardware_concurrency() - 1 : 0);
+        return pool;
+    }
+
+private:
+    // Clears busy flag when ParallelFor() returns or throws
+    struct BusyGuard
+    {
+        std::atomic<bool>& Busy;
+        ~BusyGuard() { Busy.store(false, std::memory_order_release); }
+    };
+
+    template<typename Func>
+    static void Invoke(const void* pTask, size_t index)
+    {
+        (*static_cast<Func*>(const_cast<void*>(pTask)))(index);
+    }
+
+    void WorkerLoop()
+    {
+        uint64_t seenGeneration = 0;
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        while (true)
+        {
+            m_cvStart.wait(uLock, [&]{ return m_bStop || m_nGeneration != seenGeneration; });
+            if(m_bStop)
+                return;
+            seenGeneration = m_nGeneration;
+            uLock.unlock();
+            RunTasks();
+            uLock.lock();
+            if(--m_nRunning == 0)
+                m_cvDone.notify_one();
+        }
+    }
+
+    void RunTasks() noexcept
+    {
+        // m_pTask, m_pfnInvoke and m_nCount are written before generation
+        // is changed under m_mtx and read after it was seen
+        for (size_t index = m_nNext.fetch_add(1, std::memory_order_relaxed); index < m_nCount;
+             index = m_nNext.fetch_add(1, std::memory_order_relaxed))
+        {
+            #if NICKSV_EXCEPTIONS
+            try { m_pfnInvoke(m_pTask, index); }
+            catch(...)
+            {
+                std::lock_guard<std::mutex> lockGuard(m_mtx);
+                if(!m_pException)
+                    m_pException = std::current_exception();
+            }
+            #else
+            m_pfnInvoke(m_pTask, index);
+            #endif
+        }
+    }
+
+    std::vector<std::thread> m_vecThreads;
+    // Set by the running ParallelFor(), flag instead of mutex,
+    // so nested call from the same thread just sees it
+    std::atomic<bool> m_bBusy{false};
+    // Guards everything below except m_nNext
+    std::mutex m_mtx;
+    std::condition_variable m_cvStart;
+    std::condition_variable m_cvDone;
+    // Task of running ParallelFor() and its caller, without std::function allocation
+    const void* m_pTask = nullptr;
+    void (*m_pfnInvoke)(const void*, size_t) = nullptr;
+    size_t m_nCount = 0;
+    std::atomic<size_t> m_nNext{0};
+    size_t m_nRunning = 0;
+    uint64_t m_nGeneration = 0;
+    std::exception_ptr m_pException;
+    bool m_bStop = false;
+};
+
+
+
+}}  /*END OF NAMESPACES*/
+
+
+
+
+#endif // _NICKSV_THREAD_POOL
@@ -0,0 +1,527 @@
+
+#ifndef _NICKSV_UPGRADABLE_VALUELOCK
+#define _NICKSV_UPGRADABLE_VALUELOCK
+#pragma once
+
+
+#include "NickSV/Tools/ValueLock.h"
+
+
+#include <condition_variable>
+#include <mutex>
+#include <list>
+
+
+
+
+namespace NickSV {
+namespace Tools {
+
+
+
+#define INVALID_UPGRADE_ERROR_TEXT "Invalid function call: value has not yet been locked as upgradable"
+
+
+/**
+ * @class UpgradableValueLock
+ *
+ * @brief Same as @ref DynamicValueLock, but every value
+ *        can be locked in three modes:
+ *        shared (many readers), upgradable (one thread
+ *        that reads along with shared ones and can become
+ *        exclusive without unlocking) and exclusive.
+ *
+ * Read-decide-write flow without relock race window:
+ * @code{.cpp}
+ *     // UpgradableValueLock<ID> usersLock declared before
+ *     UpgradableValueLockGuard<decltype(usersLock)> lockGuard(usersLock, id);
+ *     if(mapUsers.at(id).needsUpdate())   // readers still work here
+ *     {
+ *         lockGuard.Upgrade();            // waits for readers to leave
+ *         mapUsers.at(id).update();
+ *     }
+ * @endcode
+ *
+ * Only one thread per value can hold upgradable lock,
+ * so two upgrades of the same value never deadlock each other.
+ * New shared lockers wait while exclusive lock or upgrade is pending,
+ * so readers can't starve writers.
+ */
+template<typename ValueT>
+class UpgradableValueLock
+{
+public:
+
+    static_assert(std::is_default_constructible<ValueT>::value, "ValueT must be default constructible");
+    static_assert(     is_equality_comparable<ValueT>::value, "ValueT must has equality operator overloaded");
+    static_assert(std::is_copy_constructible<ValueT>::value, "ValueT must be copy constructible");
+    static_assert(std::is_copy_assignable<ValueT>::value, "ValueT must be copy assignable");
+
+    using ValueType = ValueT;
+
+    struct ValueState
+    {
+        ValueState() = default;
+        DECLARE_RULE_OF_5_DELETE(ValueState);
+        explicit ValueState(const ValueType& val) : Value(val) {}
+
+        std::condition_variable Condition;
+        ValueType Value;
+        // Threads holding or waiting for the value
+        uint32_t RefCount = 0;
+        uint32_t Readers = 0;
+        uint32_t WritersWaiting = 0;
+        bool Writer = false;
+        bool Upgrader = false;
+        bool UpgradePending = false;
+    };
+
+    using Container = std::list<ValueState>;
+
+
+    /**
+     * @class Unlocker
+     *
+     * @brief Unary functor that calls Unlock(value)
+     *        on given pointer to UpgradableValueLock
+     *        with value.
+     *
+     * @warning
+     * Invoking throws the same exception as UpgradableValueLock::Unlock(value) if there is no stack unwinding,
+     * otherwise printing error message to std::cerr and returns
+     *
+    */
+    class Unlocker
+    {
+        ValueType m_Value;
+    public:
+        Unlocker() = default;
+        DECLARE_RULE_OF_5_DEFAULT(Unlocker, NOTHING);
+        explicit Unlocker(const ValueType& value) : m_Value(value) {}
+
+        /**
+         * @throws
+         * Same exception as UpgradableValueLock::Unlock(value) if there is no stack unwinding,
+         * otherwise printing error message to std::cerr and returns
+         */
+        inline void operator()(UpgradableValueLock* pValueLock) const
+        {
+            #if NICKSV_EXCEPTIONS
+            try { pValueLock->Unlock(m_Value); }
+            catch(const std::exception& e)
+            {
+                #ifdef __cpp_lib_uncaught_exceptions
+                if(!std::uncaught_exceptions()) throw;
+                #else
+                if(!std::uncaught_exception()) throw;
+                #endif
+                std::cerr << "Unlocker::operator() caught std::exception in call of UpgradableValueLock::Unlock()"
+                             "during stack unwinding, it won't be rethrown. std::exception::what(): "
+                          << e.what() << std::endl;
+            }
+            #else
+            pValueLock->Unlock(m_Value);
+            #endif
+        }
+    };
+
+    /**
+     * @class UnlockerAll
+     *
+     * @brief Unary functor that calls UnlockAll([value])
+     *        on given pointer to UpgradableValueLock
+     *        with value.
+     *
+     * @warning
+     * Invoking throws the same exception as UpgradableValueLock::UnlockAll([value]) if there is no stack unwinding,
+     * otherwise printing error message to std::cerr and returns
+     *
+    */
+    class UnlockerAll
+    {
+        std::unique_ptr<ValueType> m_upKeepLockedValue;
+    public:
+        UnlockerAll() = default;
+        DECLARE_RULE_OF_5_DEFAULT(UnlockerAll, NOTHING);
+        explicit UnlockerAll(const ValueType& keepLockedValue)
+            : m_upKeepLockedValue(new ValueType(keepLockedValue)) {}
+
+        /**
+         * @throws
+         * Same exception as UpgradableValueLock::UnlockAll([value]) if there is no stack unwinding,
+         * otherwise printing error message to std::cerr and returns
+         */
+        inline void operator()(UpgradableValueLock* pValueLock) const
+        {
+            #if NICKSV_EXCEPTIONS
+            try
+            {
+                if(m_upKeepLockedValue)
+                    pValueLock->UnlockAll(*m_upKeepLockedValue);
+                else
+                    pValueLock->UnlockAll();
+            }
+            catch(const std::exception& e)
+            {
+                #ifdef __cpp_lib_uncaught_exceptions
+                if(!std::uncaught_exceptions()) throw;
+                #else
+                if(!std::uncaught_exception()) throw;
+                #endif
+                std::cerr << "UnlockerAll::operator() caught std::exception in call of UpgradableValueLock::UnlockAll()"
+                             "during stack unwinding, it won't be rethrown. std::exception::what(): "
+                          << e.what() << std::endl;
+            }
+            #else
+            if(m_upKeepLockedValue)
+                pValueLock->UnlockAll(*m_upKeepLockedValue);
+            else
+                pValueLock->UnlockAll();
+            #endif
+        }
+    };
+
+
+    // Non-copyable, non-movable
+    DECLARE_RULE_OF_5_DELETE(UpgradableValueLock);
+
+    UpgradableValueLock() = default;
+
+    /**
+     * @brief Locks given value exclusively.
+     */
+    void Lock(const ValueType& value) noexcept(false)
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        auto iterState = EnterSlot(uLock, value);
+        ++(iterState->WritersWaiting);
+        iterState->Condition.wait(uLock, [&iterState]{ return CanLockExclusive(*iterState); });
+        --(iterState->WritersWaiting);
+        iterState->Writer = true;
+    }
+
+    /**
+     * @brief Locks given value in shared mode.
+     */
+    void LockShared(const ValueType& value) noexcept(false)
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        auto iterState = EnterSlot(uLock, value);
+        iterState->Condition.wait(uLock, [&iterState]{ return CanLockShared(*iterState); });
+        ++(iterState->Readers);
+    }
+
+    /**
+     * @brief Locks given value in upgradable mode:
+     *        shared lockers can work with the value,
+     *        but nobody else can lock it as upgradable or exclusive.
+     */
+    void LockUpgradable(const ValueType& value) noexcept(false)
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        auto iterState = EnterSlot(uLock, value);
+        iterState->Condition.wait(uLock, [&iterState]{ return CanLockUpgradable(*iterState); });
+        iterState->Upgrader = true;
+    }
+
+    /**
+     * @brief Atomically changes upgradable lock of
+     *        given value to exclusive one, waits for
+     *        shared lockers to unlock the value.
+     *
+     * @warning UpgradableValueLock::LockUpgradable(value) must be called
+     * by the current thread of execution,
+     * otherwise, the behavior is undefined.
+     */
+    void UpgradeToExclusive(const ValueType& value) noexcept(false)
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        auto iterState = FindSlot(value);
+        NICKSV_ASSERT(iterState != m_listValueStates.end() && iterState->Upgrader, INVALID_UPGRADE_ERROR_TEXT);
+        iterState->UpgradePending = true;
+        iterState->Condition.wait(uLock, [&iterState]{ return iterState->Readers == 0; });
+        iterState->UpgradePending = false;
+        iterState->Upgrader = false;
+        iterState->Writer = true;
+    }
+
+    /**
+     * @brief Atomically changes exclusive lock of
+     *        given value to upgradable one,
+     *        so shared lockers can enter again.
+     *
+     * @warning UpgradableValueLock::Lock(value) or UpgradeToExclusive(value)
+     * must be called by the current thread of execution,
+     * otherwise, the behavior is undefined.
+     */
+    void Downgrade(const ValueType& value) noexcept(false)
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        auto iterState = FindSlot(value);
+        NICKSV_ASSERT(iterState != m_listValueStates.end() && iterState->Writer, INVALID_VALUE_ERROR_TEXT);
+        iterState->Writer = false;
+        iterState->Upgrader = true;
+        iterState->Condition.notify_all();
+    }
+
+    /**
+     * @brief Unlocks exclusively locked value.
+     *
+     * @warning UpgradableValueLock::Lock(value) must be called
+     * by the current thread of execution,
+     * otherwise, the behavior is undefined.
+     */
+    void Unlock(const ValueType& value) noexcept(false)
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        auto iterState = FindSlot(value);
+        NICKSV_ASSERT(iterState != m_listValueStates.end() && iterState->Writer, INVALID_VALUE_ERROR_TEXT);
+        iterState->Writer = false;
+        LeaveSlot(iterState);
+    }
+
+    /**
+     * @brief Unlocks value locked in shared mode.
+     *
+     * @warning UpgradableValueLock::LockShared(value) must be called
+     * by the current thread of execution,
+     * otherwise, the behavior is undefined.
+     */
+    void UnlockShared(const ValueType& value) noexcept(false)
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        auto iterState = FindSlot(value);
+        NICKSV_ASSERT(iterState != m_listValueStates.end() && iterState->Readers, INVALID_VALUE_ERROR_TEXT);
+        --(iterState->Readers);
+        LeaveSlot(iterState);
+    }
+
+    /**
+     * @brief Unlocks value locked in upgradable mode.
+     *
+     * @warning UpgradableValueLock::LockUpgradable(value) must be called
+     * by the current thread of execution,
+     * otherwise, the behavior is undefined.
+     */
+    void UnlockUpgradable(const ValueType& value) noexcept(false)
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        auto iterState = FindSlot(value);
+        NICKSV_ASSERT(iterState != m_listValueStates.end() && iterState->Upgrader, INVALID_UPGRADE_ERROR_TEXT);
+        iterState->Upgrader = false;
+        LeaveSlot(iterState);
+    }
+
+    bool TryLock(const ValueType& value) noexcept(false)
+    {
+        return TryLockIf(value, &CanLockExclusive, [](ValueState& state) noexcept { state.Writer = true; });
+    }
+
+    bool TryLockShared(const ValueType& value) noexcept(false)
+    {
+        return TryLockIf(value, &CanLockShared, [](ValueState& state) noexcept { ++state.Readers; });
+    }
+
+    bool TryLockUpgradable(const ValueType& value) noexcept(false)
+    {
+        return TryLockIf(value, &CanLockUpgradable, [](ValueState& state) noexcept { state.Upgrader = true; });
+    }
+
+    /**
+     * @brief Locks every value exclusively
+     */
+    void LockAll() noexcept(false)
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        m_cvLockAllWaiter.wait(uLock, [this]{ return !m_bIsLockingAll; });
+        m_bIsLockingAll = true;
+        m_cvEmptyListWaiter.wait(uLock, [this]{ return m_listValueStates.empty(); });
+    }
+
+    /**
+     * @brief Unlocks all values.
+     *
+     * @warning UpgradableValueLock::LockAll() must
+     * be called  by the current thread of execution,
+     * otherwise, the behavior is undefined.
+     */
+    void UnlockAll() noexcept
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        NICKSV_ASSERT(m_bIsLockingAll, CONCURRENCY_ERROR_TEXT);
+        m_bIsLockingAll = false;
+        m_cvLockAllWaiter.notify_all();
+    }
+
+    /**
+     * @brief Unlocks all values except given one,
+     *        it stays locked exclusively.
+     *
+     * @warning UpgradableValueLock::LockAll() must
+     * be called  by the current thread of execution,
+     * otherwise, the behavior is undefined.
+     */
+    void UnlockAll(const ValueType& keepLockedValue) noexcept(false)
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        NICKSV_ASSERT(m_bIsLockingAll, CONCURRENCY_ERROR_TEXT);
+        TakeSlot(keepLockedValue)->Writer = true;
+        m_bIsLockingAll = false;
+        m_cvLockAllWaiter.notify_all();
+    }
+
+private:
+    static inline bool CanLockExclusive(const ValueState& state) noexcept
+    {
+        return !state.Writer && !state.Upgrader && !state.Readers;
+    }
+    static inline bool CanLockShared(const ValueState& state) noexcept
+    {
+        return !state.Writer && !state.UpgradePending && !state.WritersWaiting;
+    }
+    static inline bool CanLockUpgradable(const ValueState& state) noexcept
+    {
+        return CanLockShared(state) && !state.Upgrader;
+    }
+
+    template<class UpdateFunc>
+    bool TryLockIf(const ValueType& value, bool (*canLock)(const ValueState&), UpdateFunc update)
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        if(m_bIsLockingAll)
+            return false;
+        auto iterState = FindSlot(value);
+        if(iterState == m_listValueStates.end())
+            iterState = TakeSlot(value);
+        else if(canLock(*iterState))
+            ++(iterState->RefCount);
+        else
+            return false;
+        update(*iterState);
+        return true;
+    }
+
+    inline auto FindSlot(const ValueType& value) noexcept -> typename Container::iterator
+    {
+        return std::find_if(m_listValueStates.begin(), m_listValueStates.end(),
+                [&value](const ValueState& state) noexcept { return value == state.Value; });
+    }
+    inline auto TakeSlot(const ValueType& value) -> typename Container::iterator
+    {
+        m_listValueStates.emplace_back(value);
+        auto iter = m_listValueStates.end();
+        --iter; ++iter->RefCount;
+        return iter;
+    }
+    inline auto EnterSlot(std::unique_lock<std::mutex>& uLock, const ValueType& value) -> typename Container::iterator
+    {
+        m_cvLockAllWaiter.wait(uLock, [this]{ return !m_bIsLockingAll; });
+        auto iterState = FindSlot(value);
+        if(iterState == m_listValueStates.end())
+            return TakeSlot(value);
+        ++(iterState->RefCount);
+        return iterState;
+    }
+    void LeaveSlot(typename Container::iterator iter)
+    {
+        NICKSV_ASSERT(iter->RefCount, "Leaving ValueState slot with RefCount == 0, probably UpgradableValueLock implementation is broken");
+        if(--(iter->RefCount))
+        {
+            iter->Condition.notify_all();
+            return;
+        }
+        m_listValueStates.erase(iter);
+        if(m_listValueStates.empty())
+            m_cvEmptyListWaiter.notify_one();
+    }
+
+    Container m_listValueStates;
+    std::mutex m_mtx;
+    std::condition_variable m_cvLockAllWaiter;
+    std::condition_variable m_cvEmptyListWaiter;
+    bool m_bIsLockingAll = false;
+};
+
+
+template<typename ValueT>
+struct is_value_lock<UpgradableValueLock<ValueT>> : std::true_type {};
+
+
+
+
+template<typename LockT>
+class SharedValueLockGuard final
+{
+public:
+    using LockType = typename std::remove_cvref<LockT>::type;
+    using ValueType = typename LockType::ValueType;
+
+    SharedValueLockGuard() = delete;
+    DECLARE_RULE_OF_5_DELETE(SharedValueLockGuard);
+
+    SharedValueLockGuard(LockType& lock, const ValueType& value) :
+        m_rLock(lock), m_value(value) { m_rLock.LockShared(m_value); }
+    ~SharedValueLockGuard() { m_rLock.UnlockShared(m_value); }
+private:
+    LockType& m_rLock;
+    const ValueType m_value;
+};
+
+
+/**
+ * @class UpgradableValueLockGuard
+ *
+ * @brief Locks value as upgradable, remembers
+ *        Upgrade()/Downgrade() calls and unlocks
+ *        the value in its current mode.
+ */
+template<typename LockT>
+class UpgradableValueLockGuard final
+{
+public:
+    using LockType = typename std::remove_cvref<LockT>::type;
+    using ValueType = typename LockType::ValueType;
+
+    UpgradableValueLockGuard() = delete;
+    DECLARE_RULE_OF_5_DELETE(UpgradableValueLockGuard);
+
+    UpgradableValueLockGuard(LockType& lock, const ValueType& value) :
+        m_rLock(lock), m_value(value) { m_rLock.LockUpgradable(m_value); }
+
+    ~UpgradableValueLockGuard()
+    {
+        if(m_bIsExclusive)
+            m_rLock.Unlock(m_value);
+        else
+            m_rLock.UnlockUpgradable(m_value);
+    }
+
+    void Upgrade() noexcept(false)
+    {
+        if(m_bIsExclusive)
+            return;
+        m_rLock.UpgradeToExclusive(m_value);
+        m_bIsExclusive = true;
+    }
+
+    void Downgrade() noexcept(false)
+    {
+        if(!m_bIsExclusive)
+            return;
+        m_rLock.Downgrade(m_value);
+        m_bIsExclusive = false;
+    }
+
+    bool IsExclusive() const noexcept { return m_bIsExclusive; }
+
+private:
+    LockType& m_rLock;
+    const ValueType m_value;
+    bool m_bIsExclusive = false;
+};
+
+
+}}  /*END OF NAMESPACES*/
+
+
+#endif // _NICKSV_UPGRADABLE_VALUELOCK
@@ -97,10 +97,34 @@ inline std::future<void> MakeReadyFuture()
 
 
 
+#if !NICKSV_EXCEPTIONS
+
+
+
+// Without exception support tryFunc can not throw,
+// so these are just std::for_each(first, last, tryFunc)
+// and catchFunc is ignored.
+//
+// THROWS: Nothing
+template<class InputIt, class TryUnaryFunc, class CatchUnaryFunc>
+void for_each_exception_safe(InputIt first, InputIt last, TryUnaryFunc tryFunc, CatchUnaryFunc) noexcept
+{
+    for (; first != last; ++first)
+        tryFunc(*first);
+}
+
+template<class InputIt, class TryUnaryFunc, class CatchUnaryFunc>
+void for_each_exception_safe_last(InputIt first, InputIt last, TryUnaryFunc tryFunc, CatchUnaryFunc) noexcept
+{
+    for (; first != last; ++first)
+        tryFunc(*first);
+}
+
+
 // In GCC 14.1 version noexcept_expr mangling is finally impl-ted
 // (otherwise SFINAE noexcept doesn't work here).
 // Assumed that other compilers just have it
-#if !defined(__GNUC__) || (__GNUC__ * 10 + __GNUC_MINOR__ > 132)
+#elif !defined(__GNUC__) || (__GNUC__ * 10 + __GNUC_MINOR__ > 132)
 
 
 
@@ -10,12 +10,17 @@
 
 #include <condition_variable>
 #include <mutex>
+#include <chrono>
 #include <type_traits>
 #include <list>
 #include <array>
 #include <algorithm>
 #include <iostream>
 #include <exception>
+#include <stdexcept>
+#include <atomic>
+#include <vector>
+#include <thread>
 
 
 
@@ -45,6 +50,111 @@ namespace Tools {
 
 #define INVALID_VALUE_ERROR_TEXT "Invalid function call: value has not yet been locked"
 
+
+/**
+ * @brief Result of non-throwing ValueLock calls
+ *        (LockNoThrow, TryLockNoThrow, UnlockNoThrow).
+ */
+enum class ValueLockStatus
+{
+    Ok,             ///< value is locked/unlocked
+    WouldBlock,     ///< value is held by another thread (TryLockNoThrow only)
+    SlotsExhausted, ///< all slots are busy, see CONCURRENCY_ERROR_TEXT
+    NotLocked,      ///< value is not held by the current thread
+    SystemError     ///< allocation or inner mutex failed, nothing is changed (DynamicValueLock only)
+};
+
+
+/**
+ * @brief Snapshot of one value that was held or waited for
+ *        at the moment of ValueLock::HeldValues() /
+ *        DynamicValueLock::HeldValues() call.
+ */
+template<typename ValueT>
+struct HeldValueInfo
+{
+    using Clock = std::chrono::steady_clock;
+
+    ValueT Value;
+    // Threads holding or waiting for the value
+    uint32_t RefCount = 0;
+    // Threads blocked in Lock(value)
+    uint32_t Waiters = 0;
+    bool Locked = false;
+    // Meaningful only if Locked
+    Clock::time_point LockedSince;
+};
+
+namespace details
+{
+    using HeldClockRep = std::chrono::steady_clock::rep;
+
+    // Zero is reserved for "not locked"
+    inline HeldClockRep HeldNow() noexcept
+    {
+        auto ticks = std::chrono::steady_clock::now().time_since_epoch().count();
+        return ticks ? ticks : 1;
+    }
+
+    template<typename ValueT>
+    HeldValueInfo<ValueT> MakeHeldValueInfo(const ValueT& value,
+        uint32_t refCount, uint32_t notWaiting, HeldClockRep lockedSince)
+    {
+        HeldValueInfo<ValueT> info;
+        info.Value = value;
+        info.RefCount = refCount;
+        info.Locked = lockedSince != 0;
+        if(info.Locked)
+        {
+            ++notWaiting;
+            info.LockedSince = typename HeldValueInfo<ValueT>::Clock::time_point(
+                typename HeldValueInfo<ValueT>::Clock::duration(lockedSince));
+        }
+        info.Waiters = refCount > notWaiting ? refCount - notWaiting : 0;
+        return info;
+    }
+} // namespace details
+
+/**
+ * @brief Default ValueLock policy: thread that locks
+ *        a value it already holds deadlocks.
+ *        Nothing is tracked, so nothing is paid.
+ */
+struct NonRecursiveValueLockPolicy
+{
+    static constexpr bool IsRecursive = false;
+
+    struct SlotState {};
+};
+
+/**
+ * @brief ValueLock policy that lets holder thread lock
+ *        its value again (same as std::recursive_mutex),
+ *        value is unlocked by the last Unlock(value).
+ *
+ * Every slot remembers its owner thread and recursion depth,
+ * owner is compared without inner mutex being locked.
+ */
+struct RecursiveValueLockPolicy
+{
+    static constexpr bool IsRecursive = true;
+
+    struct SlotState
+    {
+        SlotState() = default;
+        DECLARE_COPY_DELETE(SlotState);
+        SlotState(SlotState&&) noexcept {}
+        SlotState& operator=(SlotState&&) noexcept { return *this; }
+
+        // Written by holder only, so thread can meet
+        // its own id here only if it holds the slot
+        std::atomic<std::thread::id> Owner{std::thread::id()};
+        // Re-entries of the owner
+        uint32_t Depth = 0;
+    };
+};
+
+
 /**
  * @class ValueLock
  * 
@@ -56,6 +166,9 @@ namespace Tools {
  * @tparam slotCount max number of OBJECTS binded to ValueT
  * that can potentially and simultaneously be handled by threads
  * (for an indefinite number of needed slots see @ref DynamicValueLock)
+ * @tparam RecursionPolicy NonRecursiveValueLockPolicy or RecursiveValueLockPolicy
+ * (re-entry of the holder is one value comparison per slot
+ * it holds, without inner mutex)
  *
  * For example:
  * Imagine you have std::map<ID, User> mapUsers,
@@ -71,7 +184,9 @@ namespace Tools {
  *     mapMutexes[id].unlock();
  * @endcode
  * But this is too heavy, especially when you need to lock
- * "all" IDs. So ValueLock helps in this situation:
+ * "all" IDs (benchmarks/ValueLockCompetitors.h has this and
+ * striped std::shared_mutex variants for comparison in
+ * BM_ValueLockWorkload benchmarks). So ValueLock helps in this situation:
  * @code{.cpp}
  *     // ValueLock<ID, slotCount> usersLock declared before
  *     // with lifetime is about the same as mapUsers
@@ -89,10 +204,12 @@ namespace Tools {
  *         mapUsers.at(id).doSomething();
  *     }
  * @endcode
+ * If the map is yours to choose, @ref ValueLockedMap keeps
+ * Users and their locks together.
  * More info in methods description.
  *
 */
-template<typename ValueT, size_t slotCount>
+template<typename ValueT, size_t slotCount, class RecursionPolicy = NonRecursiveValueLockPolicy>
 class ValueLock
 {
 public:
@@ -104,28 +221,41 @@ public:
 
     using ValueType = ValueT;
 
-    struct ValueMutex
+    using RecursionPolicyType = RecursionPolicy;
+
+    // Empty for non-recursive policy
+    struct ValueMutex : RecursionPolicy::SlotState
     {
         ValueMutex() = default;
         DECLARE_COPY_DELETE(ValueMutex);
         explicit ValueMutex(const ValueType& val) : Value(val) {}
         ValueMutex(ValueMutex&& rvalRef)
-            : Value(std::move(rvalRef.Value)),
-            RefCount(std::move(rvalRef.RefCount)) {}
+            : RecursionPolicy::SlotState(),
+            Value(std::move(rvalRef.Value)),
+            RefCount(std::move(rvalRef.RefCount)),
+            Tagged(rvalRef.Tagged) {}
 
         ValueMutex& operator=(ValueMutex&& rvalRef)
         {
             Value = std::move(rvalRef.Value);
             RefCount = std::move(rvalRef.RefCount);
+            Tagged = rvalRef.Tagged;
             return *this;
         }
 
         std::mutex Mutex;
         ValueType Value = ValueType();
         uint32_t RefCount = 0;
+        // Value is meaningful, at most one slot is tagged with each value
+        // (busy slot of the value is the tagged one), so one comparison
+        // validates a slot remembered in SlotHints
+        bool Tagged = false;
+        // Set by holder after Mutex is locked, 0 if not held
+        std::atomic<details::HeldClockRep> LockedSince{0};
     };
 
     using Container = std::array<ValueMutex, slotCount>;
+    using HeldValue = HeldValueInfo<ValueType>;
 
     /**
      * @class Unlocker
@@ -154,6 +284,7 @@ public:
          */
         inline void operator()(ValueLock* pValueLock) const
         {
+            #if NICKSV_EXCEPTIONS
             try { pValueLock->Unlock(m_Value); }
             catch(const std::exception& e)
             {
@@ -166,6 +297,9 @@ public:
                              "during stack unwinding, it won't be rethrown. std::exception::what(): "
                           << e.what() << std::endl;
             }
+            #else
+            pValueLock->Unlock(m_Value);
+            #endif
         }
     };
 
@@ -197,6 +331,7 @@ public:
          */
         inline void operator()(ValueLock* pValueLock) const
         {
+            #if NICKSV_EXCEPTIONS
             try 
             {
                 if(m_upKeepLockedValue) 
@@ -215,6 +350,12 @@ public:
                              "during stack unwinding, it won't be rethrown. std::exception::what(): "
                           << e.what() << std::endl;
             }
+            #else
+            if(m_upKeepLockedValue) 
+                pValueLock->UnlockAll(*m_upKeepLockedValue);
+            else 
+                pValueLock->UnlockAll();
+            #endif
         }
     };
 
@@ -225,19 +366,29 @@ public:
 
     ValueLock() = default;
 
+    /**
+     * @brief Locks given value.
+     * 
+     * @throws std::runtime_error with CONCURRENCY_ERROR_TEXT
+     *         if all slots are busy (std::abort() is called
+     *         in builds without exceptions, see LockNoThrow())
+     */
     void Lock(const ValueType& value) noexcept(false)
     {
-        std::unique_lock<std::mutex> uLock(m_mtx);
-        auto iterMutex = FindBusySlot(value);
-        if(iterMutex == m_aValueMutexes.end())
-        {
-            iterMutex = FindEmptySlot();
-            NICKSV_ASSERT(iterMutex != m_aValueMutexes.end(), CONCURRENCY_ERROR_TEXT);
-            iterMutex->Value = value;
-        }      
-        ++(iterMutex->RefCount);
-        uLock.unlock();
-        iterMutex->Mutex.lock();
+        if(LockImpl(value) == ValueLockStatus::SlotsExhausted)
+            NICKSV_THROW(std::runtime_error(CONCURRENCY_ERROR_TEXT));
+    }
+
+    /**
+     * @brief Same as Lock(value), but reports busy slots
+     *        instead of throwing.
+     * 
+     * @returns ValueLockStatus::Ok or ValueLockStatus::SlotsExhausted
+     *          (nothing is locked then)
+     */
+    ValueLockStatus LockNoThrow(const ValueType& value) noexcept
+    {
+        return LockImpl(value);
     }
 
     /**
@@ -268,11 +419,32 @@ public:
     */
     void Unlock(const ValueType& value)  noexcept(false)
     {
+        auto status = UnlockNoThrow(value);
+        NICKSV_ASSERT(status == ValueLockStatus::Ok, INVALID_VALUE_ERROR_TEXT);
+        static_cast<void>(status);
+    }
+
+    /**
+     * @brief Same as Unlock(value), but reports
+     *        a value that is not held instead of asserting.
+     * 
+     * @returns ValueLockStatus::Ok or ValueLockStatus::NotLocked
+     * 
+     * @note Without RecursiveValueLockPolicy the owner is not tracked,
+     *       so only values held by nobody are reported as NotLocked.
+     */
+    ValueLockStatus UnlockNoThrow(const ValueType& value) noexcept
+    {
+        if(TryLeave(value, IsRecursive()))
+            return ValueLockStatus::Ok;
         std::unique_lock<std::mutex> uLock(m_mtx);
         auto iterMutex = FindBusySlot(value);
-        NICKSV_ASSERT(iterMutex != m_aValueMutexes.end(), INVALID_VALUE_ERROR_TEXT);
+        if(iterMutex == m_aValueMutexes.end() || !IsHeldByCaller(*iterMutex, IsRecursive()))
+            return ValueLockStatus::NotLocked;
         --(iterMutex->RefCount);
+        OnUnlocking(*iterMutex, IsRecursive());
         iterMutex->Mutex.unlock();
+        return ValueLockStatus::Ok;
     }
 
     
@@ -296,8 +468,8 @@ public:
      * 
      * @param keepLockedValue value to keep locked
      * 
-     * @throws - Same as std::mutex::lock(): can be thrown 
-     * by inner std::mutex (rare case)
+     * @throws std::runtime_error with CONCURRENCY_ERROR_TEXT
+     * if all slots are busy, every value stays locked then
      * 
      * @warning ValueLock::LockAll() must be called 
      * by the current thread of execution, 
@@ -306,14 +478,12 @@ public:
     */
     void UnlockAll(const ValueType& keepLockedValue) noexcept(false)
     {
-        auto iterMutex = FindBusySlot(keepLockedValue);
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        auto iterMutex = TakeSlot(keepLockedValue);
         if(iterMutex == m_aValueMutexes.end())
-        {
-            iterMutex = FindEmptySlot();
-            NICKSV_ASSERT(iterMutex != m_aValueMutexes.end(), CONCURRENCY_ERROR_TEXT);
-            iterMutex->Value = keepLockedValue;
-        }
-        ++(iterMutex->RefCount); 
+            NICKSV_THROW(std::runtime_error(CONCURRENCY_ERROR_TEXT));
+        uLock.unlock();
+        OnLocked(*iterMutex, IsRecursive());
         for (auto& vMutex: m_aValueMutexes)
         {
             if(&vMutex != &(*iterMutex))
@@ -322,35 +492,291 @@ public:
     }
 
 
+    /**
+     * @throws std::runtime_error with CONCURRENCY_ERROR_TEXT
+     *         if all slots are busy (std::abort() is called
+     *         in builds without exceptions, see TryLockNoThrow())
+     */
     bool TryLock(const ValueType& value)  noexcept(false)
+    {
+        auto status = TryLockNoThrow(value);
+        if(status == ValueLockStatus::SlotsExhausted)
+            NICKSV_THROW(std::runtime_error(CONCURRENCY_ERROR_TEXT));
+        return status == ValueLockStatus::Ok;
+    }
+
+    /**
+     * @brief Same as TryLock(value), but reports busy slots
+     *        instead of throwing.
+     * 
+     * @returns ValueLockStatus::Ok, ValueLockStatus::WouldBlock
+     *          or ValueLockStatus::SlotsExhausted
+     */
+    ValueLockStatus TryLockNoThrow(const ValueType& value) noexcept
+    {
+        if(TryReenter(value, IsRecursive()))
+            return ValueLockStatus::Ok;
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        auto iterMutex = TakeSlot(value);
+        if(iterMutex == m_aValueMutexes.end())
+            return ValueLockStatus::SlotsExhausted;
+        auto isLocked = iterMutex->Mutex.try_lock();
+        if(!isLocked)
+        {
+            --(iterMutex->RefCount);
+            return ValueLockStatus::WouldBlock;
+        }
+        OnLocked(*iterMutex, IsRecursive());
+        return ValueLockStatus::Ok;
+    }
+
+    /**
+     * @brief Copies state of every held or waited for value.
+     *        Takes inner lock only for the time of copying,
+     *        so it can be called from a monitoring thread
+     *        without stopping traffic.
+     *
+     * @note Values locked by LockAll() are not listed.
+     */
+    std::vector<HeldValue> HeldValues() noexcept(false)
+    {
+        std::vector<HeldValue> vecHeld;
+        vecHeld.reserve(slotCount);
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        for (auto& vMutex: m_aValueMutexes)
+        {
+            if(vMutex.RefCount)
+                vecHeld.push_back(details::MakeHeldValueInfo(vMutex.Value, vMutex.RefCount, 0,
+                    vMutex.LockedSince.load(std::memory_order_relaxed)));
+        }
+        return vecHeld;
+    }
+
+    /**
+     * @returns true if some thread holds given value
+     *          (result may be outdated right after return)
+     */
+    bool IsLocked(const ValueType& value) noexcept(false)
     {
         std::unique_lock<std::mutex> uLock(m_mtx);
         auto iterMutex = FindBusySlot(value);
+        return iterMutex != m_aValueMutexes.end() &&
+            iterMutex->LockedSince.load(std::memory_order_relaxed) != 0;
+    }
+
+private:
+    using IsRecursive = std::integral_constant<bool, RecursionPolicy::IsRecursive>;
+
+    ValueLockStatus LockImpl(const ValueType& value) noexcept
+    {
+        if(TryReenter(value, IsRecursive()))
+            return ValueLockStatus::Ok;
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        auto iterMutex = TakeSlot(value);
+        if(iterMutex == m_aValueMutexes.end())
+            return ValueLockStatus::SlotsExhausted;
+        uLock.unlock();
+        iterMutex->Mutex.lock();
+        OnLocked(*iterMutex, IsRecursive());
+        return ValueLockStatus::Ok;
+    }
+
+    // Finds slot of value or empty one and joins it,
+    // returns end() if all slots are busy
+    inline auto TakeSlot(const ValueType& value) noexcept -> typename Container::iterator
+    {
+        auto iterMutex = FindTaggedSlot(value);
         if(iterMutex == m_aValueMutexes.end())
         {
             iterMutex = FindEmptySlot();
-            NICKSV_ASSERT(iterMutex != m_aValueMutexes.end(), CONCURRENCY_ERROR_TEXT);
+            if(iterMutex == m_aValueMutexes.end())
+                return iterMutex;
+            if(!iterMutex->Tagged)
+                ++m_nTaggedSlots;
             iterMutex->Value = value;
-        }      
+            iterMutex->Tagged = true;
+            RememberSlot(iterMutex);
+        }
         ++(iterMutex->RefCount);
-        auto isLocked = iterMutex->Mutex.try_lock();
-        if(!isLocked)
-            --(iterMutex->RefCount);
-        return isLocked;
+        return iterMutex;
     }
 
-private:
-    inline auto FindEmptySlot() -> typename Container::iterator
+    // Slots recently used by the current thread, shared by all
+    // ValueLock objects of this type and validated before use.
+    // Zero-initialized, so thread_local access needs no guard.
+    struct SlotHints
+    {
+        constexpr static size_t Size = 4;
+        const ValueLock* Locks[Size];
+        size_t Indices[Size];
+        size_t Next;
+    };
+
+    static SlotHints& ThreadHints() noexcept
+    {
+        static thread_local SlotHints hints;
+        return hints;
+    }
+
+    inline void RememberSlot(typename Container::iterator iter) noexcept
+    {
+        auto& hints = ThreadHints();
+        const auto index = static_cast<size_t>(iter - m_aValueMutexes.begin());
+        for (size_t i = 0; i < SlotHints::Size; ++i)
+        {
+            if(hints.Locks[i] == this && hints.Indices[i] == index)
+                return;
+        }
+        hints.Locks[hints.Next] = this;
+        hints.Indices[hints.Next] = index;
+        hints.Next = (hints.Next + 1) % SlotHints::Size;
+    }
+
+    // The only slot tagged with value (busy or not),
+    // remembered slots are checked before the full scan
+    inline auto FindTaggedSlot(const ValueType& value) noexcept -> typename Container::iterator
+    {
+        const auto& hints = ThreadHints();
+        for (size_t i = 0; i < SlotHints::Size; ++i)
+        {
+            if(hints.Locks[i] != this)
+                continue;
+            auto iter = m_aValueMutexes.begin() + static_cast<std::ptrdiff_t>(hints.Indices[i]);
+            if(iter->Tagged && value == iter->Value)
+                return iter;
+        }
+        auto iter = std::find_if(m_aValueMutexes.begin(), m_aValueMutexes.end(), 
+                [&value](const ValueMutex & mutex) noexcept { return mutex.Tagged && value == mutex.Value; });
+        if(iter != m_aValueMutexes.end())
+            RememberSlot(iter);
+        return iter;
+    }
+
+    inline bool TryReenter(const ValueType&, std::false_type) noexcept { return false; }
+    inline bool TryLeave(const ValueType&, std::false_type) noexcept { return false; }
+
+    inline void OnLocked(ValueMutex& vMutex, std::false_type) noexcept
+    {
+        vMutex.LockedSince.store(details::HeldNow(), std::memory_order_relaxed);
+    }
+    inline void OnUnlocking(ValueMutex& vMutex, std::false_type) noexcept
     {
+        vMutex.LockedSince.store(0, std::memory_order_relaxed);
+    }
+    // Holder is not tracked, so only a value held by nobody is detected
+    inline bool IsHeldByCaller(const ValueMutex& vMutex, std::false_type) noexcept
+    {
+        return vMutex.LockedSince.load(std::memory_order_relaxed) != 0;
+    }
+
+    // Slots held by the current thread (recursive policy only),
+    // written at first acquisition and erased at last release.
+    // Holds beyond Size are only counted, they are found by scan.
+    struct OwnedSlots
+    {
+        constexpr static size_t Size = 16;
+        const ValueLock* Locks[Size];
+        size_t Indices[Size];
+        size_t Count;
+        size_t Overflow;
+    };
+
+    static OwnedSlots& ThreadOwnedSlots() noexcept
+    {
+        static thread_local OwnedSlots owned;
+        return owned;
+    }
+
+    // Slot value is read only if current thread owns the slot,
+    // nobody else can change it then. Every held slot is known,
+    // so a value that is not held costs no scan.
+    inline auto FindOwnSlot(const ValueType& value) noexcept -> typename Container::iterator
+    {
+        const auto id = std::this_thread::get_id();
+        const auto& owned = ThreadOwnedSlots();
+        for (size_t i = 0; i < owned.Count; ++i)
+        {
+            if(owned.Locks[i] != this)
+                continue;
+            auto iter = m_aValueMutexes.begin() + static_cast<std::ptrdiff_t>(owned.Indices[i]);
+            if(value == iter->Value)
+                return iter;
+        }
+        if(!owned.Overflow)
+            return m_aValueMutexes.end();
+        return std::find_if(m_aValueMutexes.begin(), m_aValueMutexes.end(),
+                [&value, &id](const ValueMutex & mutex) noexcept
+                { return mutex.Owner.load(std::memory_order_relaxed) == id && value == mutex.Value; });
+    }
+    inline bool TryReenter(const ValueType& value, std::true_type) noexcept
+    {
+        auto iterMutex = FindOwnSlot(value);
+        if(iterMutex == m_aValueMutexes.end())
+            return false;
+        ++(iterMutex->Depth);
+        return true;
+    }
+    inline bool TryLeave(const ValueType& value, std::true_type) noexcept
+    {
+        auto iterMutex = FindOwnSlot(value);
+        if(iterMutex == m_aValueMutexes.end() || !iterMutex->Depth)
+            return false;
+        --(iterMutex->Depth);
+        return true;
+    }
+    inline void OnLocked(ValueMutex& vMutex, std::true_type) noexcept
+    {
+        vMutex.Owner.store(std::this_thread::get_id(), std::memory_order_relaxed);
+        auto& owned = ThreadOwnedSlots();
+        if(owned.Count < OwnedSlots::Size)
+        {
+            owned.Locks[owned.Count] = this;
+            owned.Indices[owned.Count] = static_cast<size_t>(&vMutex - m_aValueMutexes.data());
+            ++owned.Count;
+        }
+        else
+            ++owned.Overflow;
+        OnLocked(vMutex, std::false_type());
+    }
+    inline void OnUnlocking(ValueMutex& vMutex, std::true_type) noexcept
+    {
+        vMutex.Owner.store(std::thread::id(), std::memory_order_relaxed);
+        auto& owned = ThreadOwnedSlots();
+        const auto index = static_cast<size_t>(&vMutex - m_aValueMutexes.data());
+        size_t i = 0;
+        while (i < owned.Count && (owned.Locks[i] != this || owned.Indices[i] != index))
+            ++i;
+        if(i < owned.Count)
+        {
+            --owned.Count;
+            owned.Locks[i] = owned.Locks[owned.Count];
+            owned.Indices[i] = owned.Indices[owned.Count];
+        }
+        else
+            --owned.Overflow;
+        OnUnlocking(vMutex, std::false_type());
+    }
+    inline bool IsHeldByCaller(const ValueMutex& vMutex, std::true_type) noexcept
+    {
+        return vMutex.Owner.load(std::memory_order_relaxed) == std::this_thread::get_id();
+    }
+
+    // Slots are tagged in order, so never used ones are at the end
+    // and tags of recently used values are kept while they last
+    inline auto FindEmptySlot() noexcept -> typename Container::iterator
+    {
+        if(m_nTaggedSlots < slotCount)
+            return m_aValueMutexes.begin() + static_cast<std::ptrdiff_t>(m_nTaggedSlots);
         return std::find_if(m_aValueMutexes.begin(), m_aValueMutexes.end(), 
                 [](const ValueMutex & mutex) noexcept { return mutex.RefCount == 0; });
     }
-    inline auto FindBusySlot(const ValueType& value) -> typename Container::iterator
+    inline auto FindBusySlot(const ValueType& value) noexcept -> typename Container::iterator
     {
-        return std::find_if(m_aValueMutexes.begin(), m_aValueMutexes.end(), 
-                [&value](const ValueMutex & mutex) noexcept { return (value == mutex.Value) && (mutex.RefCount > 0); });
+        auto iter = FindTaggedSlot(value);
+        return (iter != m_aValueMutexes.end() && iter->RefCount > 0) ? iter : m_aValueMutexes.end();
     }
     Container m_aValueMutexes;
+    size_t m_nTaggedSlots = 0;
     std::mutex m_mtx;
 };
 
@@ -389,6 +815,7 @@ public:
          */
         inline void operator()(FakeValueLock* pValueLock) const
         {
+            #if NICKSV_EXCEPTIONS
             try { pValueLock->Unlock(ValueType{}); }
             catch(const std::exception& e)
             {
@@ -401,6 +828,9 @@ public:
                              "during stack unwinding, it won't be rethrown. std::exception::what(): "
                           << e.what() << std::endl;
             }
+            #else
+            pValueLock->Unlock(ValueType{});
+            #endif
         }
     };
 
@@ -427,6 +857,7 @@ public:
          */
         inline void operator()(FakeValueLock* pValueLock) const
         {
+            #if NICKSV_EXCEPTIONS
             try 
             {
                 if(haveKeepLockedValue) 
@@ -445,6 +876,12 @@ public:
                              "during stack unwinding, it won't be rethrown. std::exception::what(): "
                           << e.what() << std::endl;
             }
+            #else
+            if(haveKeepLockedValue) 
+                pValueLock->UnlockAll(ValueType{});
+            else 
+                pValueLock->UnlockAll();
+            #endif
         }
     };
     
@@ -463,6 +900,11 @@ public:
 
     bool TryLock(const ValueType& value)  noexcept(false) { return m_mtx.try_lock(); }
 
+    ValueLockStatus LockNoThrow(const ValueType&) noexcept { m_mtx.lock(); return ValueLockStatus::Ok; }
+    ValueLockStatus UnlockNoThrow(const ValueType&) noexcept { m_mtx.unlock(); return ValueLockStatus::Ok; }
+    ValueLockStatus TryLockNoThrow(const ValueType&) noexcept
+    { return m_mtx.try_lock() ? ValueLockStatus::Ok : ValueLockStatus::WouldBlock; }
+
 private:
     std::mutex m_mtx;
 };
@@ -497,11 +939,16 @@ public:
         }
 
         std::mutex Mutex;
+        std::condition_variable ValueCondition;
         ValueType Value;
         uint32_t RefCount = 0;
+        uint32_t ConditionWaiters = 0;
+        // Set by holder after Mutex is locked, 0 if not held
+        std::atomic<details::HeldClockRep> LockedSince{0};
     };
 
     using Container = std::list<ValueMutex>;
+    using HeldValue = HeldValueInfo<ValueType>;
 
 
     /**
@@ -531,6 +978,7 @@ public:
          */
         inline void operator()(DynamicValueLock* pValueLock) const
         {
+            #if NICKSV_EXCEPTIONS
             try { pValueLock->Unlock(m_Value); }
             catch(const std::exception& e)
             {
@@ -543,6 +991,9 @@ public:
                              "during stack unwinding, it won't be rethrown. std::exception::what(): "
                           << e.what() << std::endl;
             }
+            #else
+            pValueLock->Unlock(m_Value);
+            #endif
         }
     };
 
@@ -574,6 +1025,7 @@ public:
          */
         inline void operator()(DynamicValueLock* pValueLock) const
         {
+            #if NICKSV_EXCEPTIONS
             try 
             {
                 if(m_upKeepLockedValue) 
@@ -592,6 +1044,12 @@ public:
                              "during stack unwinding, it won't be rethrown. std::exception::what(): "
                           << e.what() << std::endl;
             }
+            #else
+            if(m_upKeepLockedValue) 
+                pValueLock->UnlockAll(*m_upKeepLockedValue);
+            else 
+                pValueLock->UnlockAll();
+            #endif
         }
     };
 
@@ -607,14 +1065,44 @@ public:
     void Lock(const ValueType& value) noexcept(false)
     {
         std::unique_lock<std::mutex> uLock(m_mtx);
-        m_cvLockAllWaiter.wait(uLock, [this]{ return !m_bIsLockingAll; });
+        m_cvLockAllWaiter.wait(uLock, [this, &value]{ return CanEnter(value); });
         auto iterMutex = FindSlot(value);
         if(iterMutex == m_listValueMutexes.end())
             iterMutex = TakeSlot(value);
         else
             ++(iterMutex->RefCount);
         uLock.unlock();
+        #if NICKSV_EXCEPTIONS
+        try { iterMutex->Mutex.lock(); }
+        catch(...)
+        {
+            uLock.lock();
+            if(LeaveSlot(iterMutex) && m_listValueMutexes.empty())
+                m_cvEmptyListWaiter.notify_one();
+            throw;
+        }
+        #else
         iterMutex->Mutex.lock();
+        #endif
+        iterMutex->LockedSince.store(details::HeldNow(), std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Same as Lock(value), but reports failed
+     *        allocation or inner mutex instead of throwing
+     *        (slots never run out here).
+     *
+     * @returns ValueLockStatus::Ok or ValueLockStatus::SystemError
+     */
+    ValueLockStatus LockNoThrow(const ValueType& value) noexcept
+    {
+        #if NICKSV_EXCEPTIONS
+        try { Lock(value); }
+        catch(...) { return ValueLockStatus::SystemError; }
+        #else
+        Lock(value);
+        #endif
+        return ValueLockStatus::Ok;
     }
     
     /**
@@ -644,12 +1132,35 @@ public:
     */
     void Unlock(const ValueType& value)  noexcept(false)
     {
-        std::unique_lock<std::mutex> uLock(m_mtx);
+        auto status = UnlockNoThrow(value);
+        NICKSV_ASSERT(status == ValueLockStatus::Ok, INVALID_VALUE_ERROR_TEXT);
+        static_cast<void>(status);
+    }
+
+    /**
+     * @brief Same as Unlock(value), but reports
+     *        a value that is held by nobody instead of asserting.
+     * 
+     * @returns ValueLockStatus::Ok, ValueLockStatus::NotLocked
+     *          or ValueLockStatus::SystemError if inner mutex failed
+     */
+    ValueLockStatus UnlockNoThrow(const ValueType& value) noexcept
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx, std::defer_lock);
+        #if NICKSV_EXCEPTIONS
+        try { uLock.lock(); }
+        catch(...) { return ValueLockStatus::SystemError; }
+        #else
+        uLock.lock();
+        #endif
         auto iterMutex = FindSlot(value);
-        NICKSV_ASSERT(iterMutex != m_listValueMutexes.end(), INVALID_VALUE_ERROR_TEXT);
+        if(iterMutex == m_listValueMutexes.end() ||
+           iterMutex->LockedSince.load(std::memory_order_relaxed) == 0)
+            return ValueLockStatus::NotLocked;
         LeaveSlotAndUnlock(iterMutex);
         if(m_listValueMutexes.empty())
             m_cvEmptyListWaiter.notify_one();
+        return ValueLockStatus::Ok;
     }
 
     /**
@@ -691,7 +1202,9 @@ public:
         NICKSV_ASSERT(m_bIsLockingAll, CONCURRENCY_ERROR_TEXT);
         NICKSV_ASSERT(m_listValueMutexes.empty(), 
             "m_listValueMutexes not empty at UnlockAll(value) call, probably DynamicValueLock implementation is broken");
-        TakeSlot(keepLockedValue)->Mutex.lock();
+        auto iterMutex = TakeSlot(keepLockedValue);
+        iterMutex->Mutex.lock();
+        iterMutex->LockedSince.store(details::HeldNow(), std::memory_order_relaxed);
         m_bIsLockingAll = false;
         m_cvLockAllWaiter.notify_all();
     }
@@ -699,7 +1212,174 @@ public:
     bool TryLock(const ValueType& value)  noexcept(false)
     {
         std::unique_lock<std::mutex> uLock(m_mtx);
-        m_cvLockAllWaiter.wait(uLock, [this]{ return !m_bIsLockingAll; });
+        m_cvLockAllWaiter.wait(uLock, [this, &value]{ return CanEnter(value); });
+        return TryLockEntered(value);
+    }
+
+    /**
+     * @brief Same as TryLock(value), but returns status
+     *        and doesn't wait for pending LockAll().
+     * 
+     * @returns ValueLockStatus::Ok, ValueLockStatus::WouldBlock
+     *          or ValueLockStatus::SystemError if allocation or inner mutex failed
+     */
+    ValueLockStatus TryLockNoThrow(const ValueType& value) noexcept
+    {
+        #if NICKSV_EXCEPTIONS
+        try
+        {
+            std::unique_lock<std::mutex> uLock(m_mtx);
+            if(!CanEnter(value))
+                return ValueLockStatus::WouldBlock;
+            return TryLockEntered(value) ? ValueLockStatus::Ok : ValueLockStatus::WouldBlock;
+        }
+        catch(...) { return ValueLockStatus::SystemError; }
+        #else
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        if(!CanEnter(value))
+            return ValueLockStatus::WouldBlock;
+        return TryLockEntered(value) ? ValueLockStatus::Ok : ValueLockStatus::WouldBlock;
+        #endif
+    }
+
+    /**
+     * @brief Atomically unlocks given value and blocks
+     *        until pred() returns true. Value is locked again
+     *        when pred() is checked and when this function returns.
+     * 
+     * @details
+     * Same as std::condition_variable::wait(lock, pred),
+     * but every value has its own condition, so only
+     * NotifyValue(value) wakes this thread up
+     * (waiters on other values are not disturbed).
+     * 
+     * @param value is locked value to wait on
+     * @param pred is predicate to wait for
+     * 
+     * @exception - Same as pred(), value stays locked
+     * 
+     * @warning DynamicValueLock::Lock(value) must
+     * be called  by the current thread of execution, 
+     * otherwise, the behavior is undefined.
+     * 
+    */
+    template<class Predicate>
+    void WaitFor(const ValueType& value, Predicate pred) noexcept(false)
+    {
+        auto iterMutex = EnterCondition(value);
+        std::unique_lock<std::mutex> uValueLock(iterMutex->Mutex, std::adopt_lock);
+        #if NICKSV_EXCEPTIONS
+        try { iterMutex->ValueCondition.wait(uValueLock, pred); }
+        catch(...)
+        {
+            uValueLock.release();
+            LeaveCondition(iterMutex);
+            throw;
+        }
+        #else
+        iterMutex->ValueCondition.wait(uValueLock, pred);
+        #endif
+        uValueLock.release();
+        LeaveCondition(iterMutex);
+    }
+
+    /**
+     * @brief Same as WaitFor(value, pred), but gives up
+     *        after relTime is elapsed.
+     * 
+     * @returns pred() result, value is locked anyway
+     * 
+     * @warning DynamicValueLock::Lock(value) must
+     * be called  by the current thread of execution, 
+     * otherwise, the behavior is undefined.
+     * 
+    */
+    template<class Rep, class Period, class Predicate>
+    bool WaitFor(const ValueType& value, 
+        const std::chrono::duration<Rep, Period>& relTime, Predicate pred) noexcept(false)
+    {
+        auto iterMutex = EnterCondition(value);
+        std::unique_lock<std::mutex> uValueLock(iterMutex->Mutex, std::adopt_lock);
+        #if NICKSV_EXCEPTIONS
+        bool result = false;
+        try { result = iterMutex->ValueCondition.wait_for(uValueLock, relTime, pred); }
+        catch(...)
+        {
+            uValueLock.release();
+            LeaveCondition(iterMutex);
+            throw;
+        }
+        #else
+        bool result = iterMutex->ValueCondition.wait_for(uValueLock, relTime, pred);
+        #endif
+        uValueLock.release();
+        LeaveCondition(iterMutex);
+        return result;
+    }
+
+    /**
+     * @brief Wakes up all threads waiting 
+     *        on given value in WaitFor(value, ...).
+     * 
+     * @note Current thread does not have to lock value,
+     *       but state checked by waiters' predicates
+     *       should be changed with value locked,
+     *       otherwise notification can be missed.
+    */
+    void NotifyValue(const ValueType& value) noexcept(false)
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        auto iterMutex = FindSlot(value);
+        if(iterMutex != m_listValueMutexes.end() && iterMutex->ConditionWaiters)
+            iterMutex->ValueCondition.notify_all();
+    }
+
+    /**
+     * @brief Copies state of every held or waited for value.
+     *        Takes inner lock only for the time of copying,
+     *        so it can be called from a monitoring thread
+     *        without stopping traffic.
+     *
+     * @note Threads in WaitFor(value, ...) are neither
+     *       holders nor waiters until they are notified.
+     */
+    std::vector<HeldValue> HeldValues() noexcept(false)
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        std::vector<HeldValue> vecHeld;
+        vecHeld.reserve(m_listValueMutexes.size());
+        for (auto& vMutex: m_listValueMutexes)
+            vecHeld.push_back(details::MakeHeldValueInfo(vMutex.Value, vMutex.RefCount, vMutex.ConditionWaiters,
+                vMutex.LockedSince.load(std::memory_order_relaxed)));
+        return vecHeld;
+    }
+
+    /**
+     * @returns true if some thread holds given value
+     *          (result may be outdated right after return)
+     */
+    bool IsLocked(const ValueType& value) noexcept(false)
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        auto iterMutex = FindSlot(value);
+        return iterMutex != m_listValueMutexes.end() &&
+            iterMutex->LockedSince.load(std::memory_order_relaxed) != 0;
+    }
+
+private:
+    // Threads notifying condition waiters have to lock their value
+    // even if LockAll() is pending, otherwise LockAll() waits for
+    // the waiters forever and the waiters wait for the notifiers.
+    inline bool CanEnter(const ValueType& value) noexcept
+    {
+        if(!m_bIsLockingAll)
+            return true;
+        auto iterMutex = FindSlot(value);
+        return iterMutex != m_listValueMutexes.end() && iterMutex->ConditionWaiters;
+    }
+    // Called under m_mtx when CanEnter(value)
+    bool TryLockEntered(const ValueType& value)
+    {
         auto iterMutex = FindSlot(value);
         if(iterMutex == m_listValueMutexes.end())
             iterMutex = TakeSlot(value);
@@ -708,10 +1388,27 @@ public:
         auto isLocked = iterMutex->Mutex.try_lock();
         if(!isLocked) 
             LeaveSlot(iterMutex);
+        else
+            iterMutex->LockedSince.store(details::HeldNow(), std::memory_order_relaxed);
         return isLocked;
     }
-
-private:
+    inline auto EnterCondition(const ValueType& value) -> typename Container::iterator
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        auto iterMutex = FindSlot(value);
+        NICKSV_ASSERT(iterMutex != m_listValueMutexes.end(), INVALID_VALUE_ERROR_TEXT);
+        ++(iterMutex->ConditionWaiters);
+        iterMutex->LockedSince.store(0, std::memory_order_relaxed);
+        if(m_bIsLockingAll)
+            m_cvLockAllWaiter.notify_all();
+        return iterMutex;
+    }
+    inline void LeaveCondition(typename Container::iterator iter)
+    {
+        std::unique_lock<std::mutex> uLock(m_mtx);
+        --(iter->ConditionWaiters);
+        iter->LockedSince.store(details::HeldNow(), std::memory_order_relaxed);
+    }
     inline auto FindSlot(const ValueType& value) noexcept -> typename Container::iterator
     {
         return std::find_if(m_listValueMutexes.begin(), m_listValueMutexes.end(), 
@@ -734,6 +1431,7 @@ private:
     }
     inline bool LeaveSlotAndUnlock(typename Container::iterator iter)
     {
+        iter->LockedSince.store(0, std::memory_order_relaxed);
         iter->Mutex.unlock();
         return LeaveSlot(iter);
     }
@@ -750,8 +1448,8 @@ struct is_value_lock;
 template<typename LockType>
 struct is_value_lock : std::false_type {};
 
-template<typename ValueT, size_t threadCount>
-struct is_value_lock<ValueLock<ValueT, threadCount>> : std::true_type {};
+template<typename ValueT, size_t threadCount, class RecursionPolicy>
+struct is_value_lock<ValueLock<ValueT, threadCount, RecursionPolicy>> : std::true_type {};
 
 template<typename ValueT, size_t threadCount>
 struct is_value_lock<FakeValueLock<ValueT, threadCount>> : std::true_type {};
@@ -780,10 +1478,27 @@ public:
     
     ValueLockGuard(LockType& lock, const ValueType& value) :
         m_rLock(lock), m_value(value) { m_rLock.Lock(m_value);}
-    ~ValueLockGuard() { typename LockType::Unlocker{m_value}(&m_rLock); }
+
+    /**
+     * @brief Tries to lock value with LockType::TryLockNoThrow(value),
+     *        check OwnsLock() or Status() before using the value.
+     *        Usable in builds without exceptions.
+     */
+    ValueLockGuard(LockType& lock, const ValueType& value, std::try_to_lock_t) noexcept :
+        m_rLock(lock), m_value(value), m_status(m_rLock.TryLockNoThrow(m_value)) {}
+
+    ~ValueLockGuard() 
+    { 
+        if(OwnsLock())
+            typename LockType::Unlocker{m_value}(&m_rLock);
+    }
+
+    ValueLockStatus Status() const noexcept { return m_status; }
+    bool OwnsLock() const noexcept { return m_status == ValueLockStatus::Ok; }
 private:
     LockType& m_rLock;
     const ValueType m_value;
+    ValueLockStatus m_status = ValueLockStatus::Ok;
 };
 
 
@@ -0,0 +1,145 @@
+
+#ifndef _NICKSV_VALUELOCK_MONITOR
+#define _NICKSV_VALUELOCK_MONITOR
+#pragma once
+
+
+#include "NickSV/Tools/ValueLock.h"
+
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+
+
+namespace NickSV {
+namespace Tools {
+
+
+
+/**
+ * @class StuckValueDetector
+ *
+ * @brief Periodically takes LockT::HeldValues() snapshot
+ *        and reports values held longer than threshold.
+ *
+ * @tparam LockT ValueLock/DynamicValueLock (anything with HeldValues())
+ *
+ * Every hold is reported once, even if it lasts
+ * for many check periods:
+ * @code{.cpp}
+ *     // DynamicValueLock<ID> usersLock declared before
+ *     StuckValueDetector<decltype(usersLock)> detector(usersLock, std::chrono::seconds(5),
+ *         [](const HeldValueInfo<ID>& held, std::chrono::steady_clock::duration heldFor)
+ *         { LOG_WARNING("User ", held.Value, " is locked for too long"); });
+ *     detector.Start(std::chrono::seconds(1));
+ * @endcode
+ *
+ * @warning Callback is called from detector's thread and must not
+ *          lock values of the monitored lock (it can deadlock Stop())
+ */
+template<class LockT>
+class StuckValueDetector
+{
+public:
+    using LockType = LockT;
+    using HeldValue = typename LockType::HeldValue;
+    using Clock = typename HeldValue::Clock;
+    using Callback = std::function<void(const HeldValue&, typename Clock::duration)>;
+
+    DECLARE_RULE_OF_5_DELETE(StuckValueDetector);
+
+    StuckValueDetector(LockType& lock, typename Clock::duration threshold, Callback callback)
+        : m_rLock(lock), m_threshold(threshold), m_callback(std::move(callback)) {}
+
+    ~StuckValueDetector() { Stop(); }
+
+    /**
+     * @brief Checks held values once in the current thread.
+     *
+     * @returns number of values held longer than threshold
+     *          (reported or not)
+     */
+    size_t CheckOnce() noexcept(false)
+    {
+        auto vecHeld = m_rLock.HeldValues();
+        auto now = Clock::now();
+        std::vector<HeldValue> vecStuck;
+        for (auto& held: vecHeld)
+        {
+            if(!held.Locked || now - held.LockedSince < m_threshold)
+                continue;
+            if(!WasReported(held))
+                m_callback(held, now - held.LockedSince);
+            vecStuck.push_back(std::move(held));
+        }
+        size_t stuckCount = vecStuck.size();
+        m_vecReported.swap(vecStuck);
+        return stuckCount;
+    }
+
+    /**
+     * @brief Starts background thread calling
+     *        CheckOnce() every period.
+     *
+     * @warning Must not be called if detector is already started.
+     */
+    void Start(typename Clock::duration period) noexcept(false)
+    {
+        NICKSV_ASSERT(!m_thread.joinable(), "StuckValueDetector is already started");
+        m_bStop = false;
+        m_thread = std::thread([this, period]
+        {
+            std::unique_lock<std::mutex> uLock(m_mtx);
+            while(!m_cvStop.wait_for(uLock, period, [this]{ return m_bStop; }))
+            {
+                uLock.unlock();
+                CheckOnce();
+                uLock.lock();
+            }
+        });
+    }
+
+    /**
+     * @brief Stops background thread, does
+     *        nothing if it is not started.
+     */
+    void Stop() noexcept
+    {
+        if(!m_thread.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> lockGuard(m_mtx);
+            m_bStop = true;
+        }
+        m_cvStop.notify_all();
+        m_thread.join();
+    }
+
+private:
+    bool WasReported(const HeldValue& held) const noexcept
+    {
+        return std::any_of(m_vecReported.begin(), m_vecReported.end(),
+            [&held](const HeldValue& reported)
+            { return reported.LockedSince == held.LockedSince && reported.Value == held.Value; });
+    }
+
+    LockType& m_rLock;
+    const typename Clock::duration m_threshold;
+    Callback m_callback;
+    std::vector<HeldValue> m_vecReported;
+    std::thread m_thread;
+    std::mutex m_mtx;
+    std::condition_variable m_cvStop;
+    bool m_bStop = false;
+};
+
+
+}}  /*END OF NAMESPACES*/
+
+
+#endif // _NICKSV_VALUELOCK_MONITOR
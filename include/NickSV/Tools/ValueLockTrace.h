@@ -0,0 +1,681 @@
+#ifndef _NICKSV_VALUELOCK_TRACE
+#define _NICKSV_VALUELOCK_TRACE
+#pragma once
+
+
+#include "NickSV/Tools/ValueLock.h"
+
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
+
+
+
+
+namespace NickSV {
+namespace Tools {
+
+
+
+enum class ValueLockTracePhase : uint32_t
+{
+    Request,   ///< thread started to lock value
+    Acquired,  ///< value is locked by thread
+    Released,  ///< value is unlocked by thread
+    Abandoned  ///< thread gave up locking value (timeout or exception)
+};
+
+/**
+ * @brief One recorded event, see ValueLockTracer::Events()
+ */
+struct ValueLockTraceEvent
+{
+    uint64_t TimestampNs = 0;  ///< since tracer creation
+    uint64_t ThreadIndex = 0;  ///< 1, 2 ... in order of first event of thread
+    uint64_t LockId = 0;       ///< address of traced lock
+    uint64_t ValueId = 0;      ///< value itself if integral, its std::hash otherwise
+    ValueLockTracePhase Phase = ValueLockTracePhase::Request;
+};
+
+namespace details
+{
+    template<typename ValueT>
+    inline auto TraceValueId(const ValueT& value) noexcept ->
+        std::enable_if_t<std::is_integral<ValueT>::value || std::is_enum<ValueT>::value, uint64_t>
+    {
+        return static_cast<uint64_t>(value);
+    }
+
+    template<typename ValueT>
+    inline auto TraceValueId(const ValueT& value) ->
+        std::enable_if_t<!std::is_integral<ValueT>::value && !std::is_enum<ValueT>::value, uint64_t>
+    {
+        return static_cast<uint64_t>(std::hash<ValueT>{}(value));
+    }
+} // namespace details
+
+
+
+/**
+ * @class ValueLockTracer
+ *
+ * @brief Collects ValueLockTraceEvent of TracedValueLock objects
+ *        into per-thread ring buffers and writes them
+ *        as Chrome trace-event JSON (opens in Perfetto or chrome://tracing).
+ *
+ * Every thread writes only its own buffer without locks,
+ * the oldest events are overwritten when buffer is full.
+ * Buffers outlive their threads, so events of finished
+ * threads are dumped too.
+ *
+ * @code{.cpp}
+ *     ValueLockTracer tracer;
+ *     TracedValueLock<DynamicValueLock<ID>> usersLock(tracer);
+ *     // ... contention incident ...
+ *     tracer.WriteChromeTrace("users_lock.json");
+ * @endcode
+ */
+class ValueLockTracer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    DECLARE_RULE_OF_5_DELETE(ValueLockTracer);
+
+    /**
+     * @param eventsPerThread ring buffer capacity of every thread
+     * @param enabled initial state, see Enable()
+     */
+    explicit ValueLockTracer(size_t eventsPerThread = 1 << 16, bool enabled = true)
+        : m_nCapacity(eventsPerThread ? eventsPerThread : 1),
+          m_nId(NextTracerId()), m_Start(Clock::now()), m_bEnabled(enabled) {}
+
+    /**
+     * @brief Turns recording on/off, disabled tracer
+     *        costs one relaxed load per traced call.
+     */
+    void Enable(bool enabled = true) noexcept { m_bEnabled.store(enabled, std::memory_order_relaxed); }
+    bool IsEnabled() const noexcept { return m_bEnabled.load(std::memory_order_relaxed); }
+
+    void Record(ValueLockTracePhase phase, const void* pLock, uint64_t valueId) noexcept(false)
+    {
+        if(!IsEnabled())
+            return;
+        auto timestamp = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_Start).count());
+        ThreadBuffer().Push(timestamp, reinterpret_cast<uintptr_t>(pLock), valueId, phase);
+    }
+
+    /**
+     * @brief Copies events of all threads sorted by time,
+     *        can be called while traced locks are in use
+     *        (events overwritten during the copy are skipped).
+     */
+    std::vector<ValueLockTraceEvent> Events() const noexcept(false)
+    {
+        std::vector<ValueLockTraceEvent> vecEvents;
+        std::lock_guard<std::mutex> lockGuard(m_mtx);
+        for (auto& upBuffer : m_vecBuffers)
+            upBuffer->CopyTo(vecEvents);
+        std::stable_sort(vecEvents.begin(), vecEvents.end(),
+            [](const ValueLockTraceEvent& lhs, const ValueLockTraceEvent& rhs) noexcept
+            { return lhs.TimestampNs < rhs.TimestampNs; });
+        return vecEvents;
+    }
+
+    /**
+     * @brief Writes Events() as Chrome trace-event JSON.
+     *
+     * Waiting (Request -> Acquired/Abandoned) and holding (Acquired -> Released)
+     * are async slices named "wait"/"hold" with lock and value in args,
+     * so overlapping holds of one thread are shown correctly.
+     */
+    void WriteChromeTrace(std::ostream& out) const noexcept(false)
+    {
+        auto vecEvents = Events();
+        out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        bool isFirst = true;
+        auto separator = [&out, &isFirst]() -> std::ostream&
+        {
+            out << (isFirst ? "\n" : ",\n");
+            isFirst = false;
+            return out;
+        };
+        size_t threadCount = 0;
+        {
+            std::lock_guard<std::mutex> lockGuard(m_mtx);
+            threadCount = m_vecBuffers.size();
+        }
+        for (size_t i = 1; i <= threadCount; ++i)
+            separator() << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << i
+                        << ",\"args\":{\"name\":\"thread " << i << "\"}}";
+        for (auto& event : vecEvents)
+        {
+            switch (event.Phase)
+            {
+            case ValueLockTracePhase::Request:
+                WriteSlice(separator(), event, "b", "wait");
+                break;
+            case ValueLockTracePhase::Acquired:
+                WriteSlice(separator(), event, "e", "wait");
+                WriteSlice(separator(), event, "b", "hold");
+                break;
+            case ValueLockTracePhase::Released:
+                WriteSlice(separator(), event, "e", "hold");
+                break;
+            case ValueLockTracePhase::Abandoned:
+                WriteSlice(separator(), event, "e", "wait");
+                break;
+            default:
+                break;
+            }
+        }
+        out << "\n]}\n";
+    }
+
+    /**
+     * @returns false if file can't be written
+     */
+    bool WriteChromeTrace(const std::string& path) const noexcept(false)
+    {
+        std::ofstream file(path, std::ios::out | std::ios::trunc);
+        if(!file)
+            return false;
+        WriteChromeTrace(file);
+        return static_cast<bool>(file);
+    }
+
+private:
+    // Single writer (owner thread), readers copy and drop events
+    // that could be overwritten meanwhile (seqlock-like: m_nWriting
+    // is published before slot stores, m_nHead after them)
+    class RingBuffer
+    {
+    public:
+        RingBuffer(size_t capacity, uint64_t threadIndex)
+            : m_vecSlots(capacity), m_nThreadIndex(threadIndex) {}
+
+        void Push(uint64_t timestamp, uint64_t lockId, uint64_t valueId, ValueLockTracePhase phase) noexcept
+        {
+            auto head = m_nHead.load(std::memory_order_relaxed);
+            m_nWriting.store(head + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            auto& slot = m_vecSlots[head % m_vecSlots.size()];
+            slot.Timestamp.store(timestamp, std::memory_order_relaxed);
+            slot.LockId.store(lockId, std::memory_order_relaxed);
+            slot.ValueId.store(valueId, std::memory_order_relaxed);
+            slot.Phase.store(static_cast<uint32_t>(phase), std::memory_order_relaxed);
+            m_nHead.store(head + 1, std::memory_order_release);
+        }
+
+        void CopyTo(std::vector<ValueLockTraceEvent>& vecEvents) const
+        {
+            const uint64_t capacity = m_vecSlots.size();
+            auto head = m_nHead.load(std::memory_order_acquire);
+            auto first = head > capacity ? head - capacity : 0;
+            std::vector<ValueLockTraceEvent> vecCopied;
+            vecCopied.reserve(static_cast<size_t>(head - first));
+            for (auto index = first; index < head; ++index)
+            {
+                auto& slot = m_vecSlots[index % capacity];
+                ValueLockTraceEvent event;
+                event.TimestampNs = slot.Timestamp.load(std::memory_order_relaxed);
+                event.ThreadIndex = m_nThreadIndex;
+                event.LockId = slot.LockId.load(std::memory_order_relaxed);
+                event.ValueId = slot.ValueId.load(std::memory_order_relaxed);
+                event.Phase = static_cast<ValueLockTracePhase>(slot.Phase.load(std::memory_order_relaxed));
+                vecCopied.push_back(event);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            auto writing = m_nWriting.load(std::memory_order_relaxed);
+            auto overwritten = writing > capacity ? writing - capacity : 0;
+            auto skip = static_cast<size_t>(std::min<uint64_t>(overwritten > first ? overwritten - first : 0, vecCopied.size()));
+            vecEvents.insert(vecEvents.end(), vecCopied.begin() + static_cast<std::ptrdiff_t>(skip), vecCopied.end());
+        }
+
+    private:
+        struct Slot
+        {
+            std::atomic<uint64_t> Timestamp{0};
+            std::atomic<uint64_t> LockId{0};
+            std::atomic<uint64_t> ValueId{0};
+            std::atomic<uint32_t> Phase{0};
+        };
+        std::vector<Slot> m_vecSlots;
+        std::atomic<uint64_t> m_nHead{0};
+        std::atomic<uint64_t> m_nWriting{0};
+        const uint64_t m_nThreadIndex;
+    };
+
+    // Last used tracer of the current thread,
+    // tracer ids are never reused
+    struct ThreadCache
+    {
+        uint64_t TracerId;
+        RingBuffer* pBuffer;
+    };
+
+    static uint64_t NextTracerId() noexcept
+    {
+        static std::atomic<uint64_t> nextId{1};
+        return nextId.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    RingBuffer& ThreadBuffer()
+    {
+        static thread_local ThreadCache cache;
+        if(cache.TracerId == m_nId)
+            return *cache.pBuffer;
+        std::lock_guard<std::mutex> lockGuard(m_mtx);
+        auto& pBuffer = m_mapThreadBuffers[std::this_thread::get_id()];
+        if(!pBuffer)
+        {
+            m_vecBuffers.emplace_back(new RingBuffer(m_nCapacity, m_vecBuffers.size() + 1));
+            pBuffer = m_vecBuffers.back().get();
+        }
+        cache.TracerId = m_nId;
+        cache.pBuffer = pBuffer;
+        return *pBuffer;
+    }
+
+    static void WriteSlice(std::ostream& out, const ValueLockTraceEvent& event, const char* ph, const char* name)
+    {
+        out << "{\"ph\":\"" << ph << "\",\"cat\":\"ValueLock\",\"name\":\"" << name
+            << "\",\"pid\":1,\"tid\":" << event.ThreadIndex
+            << ",\"ts\":" << event.TimestampNs / 1000 << '.'
+            << static_cast<char>('0' + event.TimestampNs / 100 % 10)
+            << static_cast<char>('0' + event.TimestampNs / 10 % 10)
+            << static_cast<char>('0' + event.TimestampNs % 10)
+            << ",\"id\":\"" << name << '-' << event.ThreadIndex << '-' << event.LockId << '-' << event.ValueId
+            << "\",\"args\":{\"lock\":" << event.LockId << ",\"value\":" << event.ValueId << "}}";
+    }
+
+    const size_t m_nCapacity;
+    const uint64_t m_nId;
+    const Clock::time_point m_Start;
+    std::atomic<bool> m_bEnabled;
+    mutable std::mutex m_mtx;
+    std::vector<std::unique_ptr<RingBuffer>> m_vecBuffers;
+    std::unordered_map<std::thread::id, RingBuffer*> m_mapThreadBuffers;
+};
+
+
+
+/**
+ * @class TracedValueLock
+ *
+ * @brief Wraps any value lock (ValueLock, DynamicValueLock, PriorityValueLock ...)
+ *        and records Request/Acquired/Released events
+ *        of its calls into ValueLockTracer.
+ *
+ * @tparam LockT wrapped lock, constructed in place
+ *         with arguments after the tracer
+ *
+ * Extra arguments of LockT calls (priority, mode ...) are forwarded.
+ * Calls of LockT that it doesn't have are not declared either:
+ * shared/upgradable modes of UpgradableValueLock, TryLockFor()
+ * of PriorityValueLock, ranges of IntervalValueLock (traced as
+ * their begin value), NoThrow calls, WaitFor()/NotifyValue()
+ * of DynamicValueLock. LockAll() is traced as value ValueType{}.
+ * Upgrade and downgrade end the hold of one mode and start another.
+ */
+template<class LockT>
+class TracedValueLock
+{
+public:
+    using LockType = LockT;
+    using ValueType = typename LockType::ValueType;
+
+    /**
+     * @class Unlocker
+     *
+     * @brief Unary functor that calls Unlock(value)
+     *        on given pointer to TracedValueLock
+     *        with value.
+     *
+     * @warning
+     * Invoking throws the same exception as TracedValueLock::Unlock(value) if there is no stack unwinding,
+     * otherwise printing error message to std::cerr and returns
+     *
+    */
+    class Unlocker
+    {
+        ValueType m_Value;
+    public:
+        Unlocker() = default;
+        DECLARE_RULE_OF_5_DEFAULT(Unlocker, NOTHING);
+        explicit Unlocker(const ValueType& value) : m_Value(value) {}
+
+        inline void operator()(TracedValueLock* pValueLock) const
+        {
+            #if NICKSV_EXCEPTIONS
+            try { pValueLock->Unlock(m_Value); }
+            catch(const std::exception& e)
+            {
+                #ifdef __cpp_lib_uncaught_exceptions
+                if(!std::uncaught_exceptions()) throw;
+                #else
+                if(!std::uncaught_exception()) throw;
+                #endif
+                std::cerr << "Unlocker::operator() caught std::exception in call of TracedValueLock::Unlock()"
+                             "during stack unwinding, it won't be rethrown. std::exception::what(): "
+                          << e.what() << std::endl;
+            }
+            #else
+            pValueLock->Unlock(m_Value);
+            #endif
+        }
+    };
+
+    /**
+     * @class UnlockerAll
+     *
+     * @brief Unary functor that calls UnlockAll([value])
+     *        on given pointer to TracedValueLock
+     *        with value.
+     *
+     * @warning
+     * Invoking throws the same exception as TracedValueLock::UnlockAll([value]) if there is no stack unwinding,
+     * otherwise printing error message to std::cerr and returns
+     *
+    */
+    class UnlockerAll
+    {
+        std::unique_ptr<ValueType> m_upKeepLockedValue;
+    public:
+        UnlockerAll() = default;
+        DECLARE_RULE_OF_5_DEFAULT(UnlockerAll, NOTHING);
+        explicit UnlockerAll(const ValueType& keepLockedValue)
+            : m_upKeepLockedValue(new ValueType(keepLockedValue)) {}
+
+        inline void operator()(TracedValueLock* pValueLock) const
+        {
+            #if NICKSV_EXCEPTIONS
+            try
+            {
+                if(m_upKeepLockedValue)
+                    pValueLock->UnlockAll(*m_upKeepLockedValue);
+                else
+                    pValueLock->UnlockAll();
+            }
+            catch(const std::exception& e)
+            {
+                #ifdef __cpp_lib_uncaught_exceptions
+                if(!std::uncaught_exceptions()) throw;
+                #else
+                if(!std::uncaught_exception()) throw;
+                #endif
+                std::cerr << "UnlockerAll::operator() caught std::exception in call of TracedValueLock::UnlockAll()"
+                             "during stack unwinding, it won't be rethrown. std::exception::what(): "
+                          << e.what() << std::endl;
+            }
+            #else
+            if(m_upKeepLockedValue)
+                pValueLock->UnlockAll(*m_upKeepLockedValue);
+            else
+                pValueLock->UnlockAll();
+            #endif
+        }
+    };
+
+    DECLARE_RULE_OF_5_DELETE(TracedValueLock);
+
+    template<typename... Args>
+    explicit TracedValueLock(ValueLockTracer& tracer, Args&&... args)
+        : m_rTracer(tracer), m_Lock(std::forward<Args>(args)...) {}
+
+    LockType& Inner() noexcept { return m_Lock; }
+    ValueLockTracer& Tracer() noexcept { return m_rTracer; }
+
+// Declares NAME(value, args...) forwarded to the same call of
+// the wrapped lock (if it has one) and traced by TRACE(value, call)
+#define NICKSV_TRACED_CALL(NAME, TRACE)                                             \
+    template<typename... Args, class InnerT = LockType>                             \
+    auto NAME(const ValueType& value, Args&&... args) ->                            \
+        decltype(std::declval<InnerT&>().NAME(value, std::forward<Args>(args)...))  \
+    {                                                                               \
+        return TRACE(value, [&]{ return m_Lock.NAME(value, std::forward<Args>(args)...); }); \
+    }
+
+    NICKSV_TRACED_CALL(Lock, TraceAcquire)
+    NICKSV_TRACED_CALL(TryLock, TraceTryAcquire)
+    NICKSV_TRACED_CALL(TryLockFor, TraceAcquire)
+    NICKSV_TRACED_CALL(Unlock, TraceRelease)
+
+    NICKSV_TRACED_CALL(LockShared, TraceAcquire)
+    NICKSV_TRACED_CALL(TryLockShared, TraceTryAcquire)
+    NICKSV_TRACED_CALL(UnlockShared, TraceRelease)
+    NICKSV_TRACED_CALL(LockUpgradable, TraceAcquire)
+    NICKSV_TRACED_CALL(TryLockUpgradable, TraceTryAcquire)
+    NICKSV_TRACED_CALL(UnlockUpgradable, TraceRelease)
+    NICKSV_TRACED_CALL(UpgradeToExclusive, TraceUpgrade)
+    NICKSV_TRACED_CALL(Downgrade, TraceDowngrade)
+
+    NICKSV_TRACED_CALL(LockRange, TraceAcquire)
+    NICKSV_TRACED_CALL(TryLockRange, TraceTryAcquire)
+    NICKSV_TRACED_CALL(UnlockRange, TraceRelease)
+
+    NICKSV_TRACED_CALL(WaitFor, TraceRelock)
+    NICKSV_TRACED_CALL(NotifyValue, Forward)
+
+#undef NICKSV_TRACED_CALL
+
+    /**
+     * @brief Same as LockType::LockNoThrow(value),
+     *        Acquired is recorded only for ValueLockStatus::Ok.
+     *        Events that tracer fails to record are dropped.
+     */
+    template<class InnerT = LockType>
+    auto LockNoThrow(const ValueType& value) noexcept -> decltype(std::declval<InnerT&>().LockNoThrow(value))
+    {
+        RecordNoThrow(ValueLockTracePhase::Request, value);
+        auto status = m_Lock.LockNoThrow(value);
+        RecordNoThrow(status == ValueLockStatus::Ok ?
+            ValueLockTracePhase::Acquired : ValueLockTracePhase::Abandoned, value);
+        return status;
+    }
+
+    template<class InnerT = LockType>
+    auto TryLockNoThrow(const ValueType& value) noexcept -> decltype(std::declval<InnerT&>().TryLockNoThrow(value))
+    {
+        auto status = m_Lock.TryLockNoThrow(value);
+        if(status == ValueLockStatus::Ok)
+        {
+            RecordNoThrow(ValueLockTracePhase::Request, value);
+            RecordNoThrow(ValueLockTracePhase::Acquired, value);
+        }
+        return status;
+    }
+
+    template<class InnerT = LockType>
+    auto UnlockNoThrow(const ValueType& value) noexcept -> decltype(std::declval<InnerT&>().UnlockNoThrow(value))
+    {
+        auto status = m_Lock.UnlockNoThrow(value);
+        if(status == ValueLockStatus::Ok)
+            RecordNoThrow(ValueLockTracePhase::Released, value);
+        return status;
+    }
+
+    void LockAll() noexcept(false)
+    {
+        TraceAcquire(ValueType{}, [this]{ m_Lock.LockAll(); });
+    }
+
+    void UnlockAll() noexcept(false)
+    {
+        m_Lock.UnlockAll();
+        Record(ValueLockTracePhase::Released, ValueType{});
+    }
+
+    void UnlockAll(const ValueType& keepLockedValue) noexcept(false)
+    {
+        m_Lock.UnlockAll(keepLockedValue);
+        Record(ValueLockTracePhase::Released, ValueType{});
+        Record(ValueLockTracePhase::Request, keepLockedValue);
+        Record(ValueLockTracePhase::Acquired, keepLockedValue);
+    }
+
+private:
+    inline void Record(ValueLockTracePhase phase, const ValueType& value)
+    {
+        if(m_rTracer.IsEnabled())
+            m_rTracer.Record(phase, &m_Lock, details::TraceValueId(value));
+    }
+
+    inline void RecordNoThrow(ValueLockTracePhase phase, const ValueType& value) noexcept
+    {
+        #if NICKSV_EXCEPTIONS
+        try { Record(phase, value); }
+        catch(...) {}
+        #else
+        Record(phase, value);
+        #endif
+    }
+
+    // Result of Lock() tells if value is locked only when it is bool (TryLockFor),
+    // otherwise it is a kind of success, e.g. InterprocessLockResult
+    static inline bool IsAcquired(bool isLocked) noexcept { return isLocked; }
+    template<typename ResultT>
+    static inline bool IsAcquired(const ResultT&) noexcept { return true; }
+
+    // Wait slice is always closed: by Acquired, or by Abandoned
+    // if call timed out or threw
+    template<typename Func>
+    auto TraceAcquire(const ValueType& value, Func&& func) -> decltype(func())
+    {
+        Record(ValueLockTracePhase::Request, value);
+        #if NICKSV_EXCEPTIONS
+        try { return AcquireImpl(std::is_void<decltype(func())>(), value, func); }
+        catch(...)
+        {
+            Record(ValueLockTracePhase::Abandoned, value);
+            throw;
+        }
+        #else
+        return AcquireImpl(std::is_void<decltype(func())>(), value, func);
+        #endif
+    }
+
+    template<typename Func>
+    inline void AcquireImpl(std::true_type, const ValueType& value, Func& func)
+    {
+        func();
+        Record(ValueLockTracePhase::Acquired, value);
+    }
+
+    template<typename Func>
+    inline auto AcquireImpl(std::false_type, const ValueType& value, Func& func) -> decltype(func())
+    {
+        auto result = func();
+        Record(IsAcquired(result) ? ValueLockTracePhase::Acquired : ValueLockTracePhase::Abandoned, value);
+        return result;
+    }
+
+    // Failed attempt didn't wait, so it is not recorded
+    template<typename Func>
+    auto TraceTryAcquire(const ValueType& value, Func&& func) -> decltype(func())
+    {
+        auto isLocked = func();
+        if(isLocked)
+        {
+            Record(ValueLockTracePhase::Request, value);
+            Record(ValueLockTracePhase::Acquired, value);
+        }
+        return isLocked;
+    }
+
+    // Recorded only if unlock succeeded
+    template<typename Func>
+    void TraceRelease(const ValueType& value, Func&& func)
+    {
+        func();
+        Record(ValueLockTracePhase::Released, value);
+    }
+
+    // Value is unlocked while waiting and locked again
+    // on return, even if the call threw
+    template<typename Func>
+    auto TraceRelock(const ValueType& value, Func&& func) -> decltype(func())
+    {
+        Record(ValueLockTracePhase::Released, value);
+        Record(ValueLockTracePhase::Request, value);
+        #if NICKSV_EXCEPTIONS
+        try { return RelockImpl(std::is_void<decltype(func())>(), value, func); }
+        catch(...)
+        {
+            Record(ValueLockTracePhase::Acquired, value);
+            throw;
+        }
+        #else
+        return RelockImpl(std::is_void<decltype(func())>(), value, func);
+        #endif
+    }
+
+    template<typename Func>
+    inline void RelockImpl(std::true_type, const ValueType& value, Func& func)
+    {
+        func();
+        Record(ValueLockTracePhase::Acquired, value);
+    }
+
+    // Timed wait result is predicate result, value is locked anyway
+    template<typename Func>
+    inline auto RelockImpl(std::false_type, const ValueType& value, Func& func) -> decltype(func())
+    {
+        auto result = func();
+        Record(ValueLockTracePhase::Acquired, value);
+        return result;
+    }
+
+    template<typename Func>
+    static inline auto Forward(const ValueType&, Func&& func) -> decltype(func())
+    {
+        return func();
+    }
+
+    // Upgradable hold ends when exclusive one starts
+    template<typename Func>
+    void TraceUpgrade(const ValueType& value, Func&& func)
+    {
+        TraceAcquire(value, [&]
+        {
+            func();
+            Record(ValueLockTracePhase::Released, value);
+        });
+    }
+
+    template<typename Func>
+    void TraceDowngrade(const ValueType& value, Func&& func)
+    {
+        func();
+        Record(ValueLockTracePhase::Released, value);
+        Record(ValueLockTracePhase::Request, value);
+        Record(ValueLockTracePhase::Acquired, value);
+    }
+
+    ValueLockTracer& m_rTracer;
+    LockType m_Lock;
+};
+
+
+template<class LockT>
+struct is_value_lock<TracedValueLock<LockT>> : std::true_type {};
+
+
+}}  /*END OF NAMESPACES*/
+
+
+
+
+#endif // _NICKSV_VALUELOCK_TRACE
@@ -0,0 +1,516 @@
+#ifndef _NICKSV_VALUELOCKED_MAP
+#define _NICKSV_VALUELOCKED_MAP
+#pragma once
+
+
+#include "NickSV/Tools/Definitions.h"
+#include "NickSV/Tools/TypeTraits.h"
+
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+
+
+
+namespace NickSV {
+namespace Tools {
+
+
+
+/**
+ * @class ValueLockedMap
+ *
+ * @brief Hash map where every key has its own mutex,
+ *        so storage and locking are the same thing.
+ *
+ * It is what the @ref ValueLock example (std::map<ID, User>
+ * plus ValueLock<ID>) does by hand, but with one lookup
+ * per access and without a chance to take the wrong lock:
+ * @code{.cpp}
+ *     // ValueLockedMap<ID, User> mapUsers declared before
+ *     mapUsers.Access(id)->doSomething();
+ *     // or, if user must not be created
+ *     if(auto user = mapUsers.Find(id))
+ *         user->doSomething();
+ * @endcode
+ * Accessor keeps the key locked until it is destroyed.
+ *
+ * @tparam KeyT key type, hashable by Hash and equality comparable
+ * @tparam MappedT mapped type, default constructible
+ * @tparam shardCount number of independent shards, keys are
+ *         spread over them by Hash
+ * @tparam Hash hash function object type
+ *
+ * Lookups don't lock anything: bucket chains are read with
+ * atomic loads and only writers (insert, erase, rehash) of
+ * the same shard take its mutex. Unlinked nodes, links and
+ * bucket tables are freed when no lookup runs in their shard,
+ * so nobody waits for memory reclamation. Waiting for a locked
+ * key is not a lookup: the found node is pinned instead,
+ * so long-lived accessors don't hold reclamation back.
+ *
+ * @warning
+ * ForEachExclusive() waits for every accessor, so calling it
+ * (or Access() of a new key while ForEachExclusive() is waiting)
+ * with an accessor held in the same thread deadlocks,
+ * same as ValueLock::LockAll().
+ */
+template<typename KeyT, typename MappedT, size_t shardCount = 64, class Hash = std::hash<KeyT>>
+class ValueLockedMap
+{
+    struct Node;
+public:
+
+    static_assert(shardCount > 0, "shardCount must be greater than 0");
+    static_assert(is_equality_comparable<KeyT>::value, "KeyT must has equality operator overloaded");
+    static_assert(std::is_default_constructible<MappedT>::value, "MappedT must be default constructible");
+
+    using KeyType = KeyT;
+    using MappedType = MappedT;
+
+    /**
+     * @class Accessor
+     *
+     * @brief Owns the lock of one key of ValueLockedMap,
+     *        gives access to its mapped value.
+     *
+     * Empty accessor (returned by Find() of absent key)
+     * converts to false.
+     */
+    class Accessor
+    {
+        friend class ValueLockedMap;
+        Node* m_pNode = nullptr;
+
+        explicit Accessor(Node* pNode) noexcept : m_pNode(pNode) {}
+    public:
+        Accessor() = default;
+        DECLARE_COPY_DELETE(Accessor);
+
+        Accessor(Accessor&& other) noexcept : m_pNode(other.m_pNode) { other.m_pNode = nullptr; }
+        Accessor& operator=(Accessor&& other) noexcept
+        {
+            if(this != &other)
+            {
+                Release();
+                m_pNode = other.m_pNode;
+                other.m_pNode = nullptr;
+            }
+            return *this;
+        }
+
+        ~Accessor() { Release(); }
+
+        inline explicit operator bool() const noexcept { return m_pNode != nullptr; }
+
+        inline const KeyType& Key() const noexcept
+        {
+            NICKSV_ASSERT(m_pNode, "Accessor is empty");
+            return m_pNode->Key;
+        }
+
+        inline MappedType& operator*() const noexcept
+        {
+            NICKSV_ASSERT(m_pNode, "Accessor is empty");
+            return m_pNode->Mapped;
+        }
+
+        inline MappedType* operator->() const noexcept
+        {
+            NICKSV_ASSERT(m_pNode, "Accessor is empty");
+            return &m_pNode->Mapped;
+        }
+
+        // Unlocks the key before destruction
+        inline void Release() noexcept
+        {
+            if(m_pNode)
+            {
+                m_pNode->Mutex.unlock();
+                m_pNode = nullptr;
+            }
+        }
+    };
+
+    DECLARE_RULE_OF_5_DELETE(ValueLockedMap);
+
+    /**
+     * @param bucketsPerShard initial bucket count of every shard
+     *        (rounded up to power of 2), shard doubles it when
+     *        it holds more keys than buckets
+     */
+    explicit ValueLockedMap(size_t bucketsPerShard = 8, const Hash& hash = Hash())
+        : m_Hash(hash), m_upShards(new Shard[shardCount])
+    {
+        size_t bucketCount = 1;
+        while (bucketCount < bucketsPerShard)
+            bucketCount *= 2;
+        for (size_t i = 0; i < shardCount; ++i)
+            m_upShards[i].pTable.store(new Table(bucketCount));
+    }
+
+    ~ValueLockedMap()
+    {
+        for (size_t i = 0; i < shardCount; ++i)
+        {
+            Shard& shard = m_upShards[i];
+            Table* pTable = shard.pTable.load();
+            for (size_t bucket = 0; bucket < pTable->BucketCount; ++bucket)
+                for (Link* pLink = pTable->upBuckets[bucket].load(); pLink; pLink = pLink->pNext.load())
+                    delete pLink->pNode;
+            FreeLinks(pTable);
+            delete pTable;
+            Reclaim(shard);
+        }
+    }
+
+    /**
+     * @brief Locks key, inserting default constructed
+     *        mapped value if there is no such key.
+     *
+     * @returns Accessor owning the lock of key
+     *
+     * @throws Whatever allocation or MappedType constructor throws
+     */
+    Accessor Access(const KeyType& key)
+    {
+        const size_t hash = m_Hash(key);
+        Shard& shard = GetShard(hash);
+        while (true)
+        {
+            Node* pNode = PinNode(shard, hash, key, true);
+            if(Node* pLocked = LockNode(shard, pNode))
+                return Accessor(pLocked);
+            // erased meanwhile, next round sees its replacement or inserts one
+        }
+    }
+
+    /**
+     * @brief Locks key if it is in the map.
+     *
+     * @returns Accessor owning the lock of key
+     *          or empty one if there is no such key
+     */
+    Accessor Find(const KeyType& key)
+    {
+        const size_t hash = m_Hash(key);
+        Shard& shard = GetShard(hash);
+        Node* pNode = PinNode(shard, hash, key, false);
+        return Accessor(pNode ? LockNode(shard, pNode) : nullptr);
+    }
+
+    // Doesn't lock anything, result may be outdated right after return
+    bool Contains(const KeyType& key) const
+    {
+        const size_t hash = m_Hash(key);
+        Shard& shard = GetShard(hash);
+        ReaderGuard readerGuard(shard);
+        return FindNode(shard, hash, key) != nullptr;
+    }
+
+    /**
+     * @brief Removes key, waiting for its accessor if there is one.
+     *
+     * @returns false if there is no such key
+     */
+    bool Erase(const KeyType& key)
+    {
+        const size_t hash = m_Hash(key);
+        Shard& shard = GetShard(hash);
+        Node* pNode = PinNode(shard, hash, key, false);
+        if(!pNode || !LockNode(shard, pNode))
+            return false;
+        // Node is unlinked and retired only by the thread that marked it
+        pNode->Erased.store(true);
+        pNode->Mutex.unlock();
+        std::lock_guard<std::mutex> lockGuard(shard.Mutex);
+        Table* pTable = shard.pTable.load();
+        auto* pPrevNext = &pTable->upBuckets[BucketIndex(*pTable, hash)];
+        for (Link* pLink = pPrevNext->load(); pLink; pLink = pPrevNext->load())
+        {
+            if(pLink->pNode == pNode)
+            {
+                pPrevNext->store(pLink->pNext.load());
+                shard.vecRetiredLinks.push_back(pLink);
+                break;
+            }
+            pPrevNext = &pLink->pNext;
+        }
+        shard.vecRetiredNodes.push_back(pNode);
+        shard.HasRetired.store(true);
+        --shard.Count;
+        m_nSize.fetch_sub(1, std::memory_order_relaxed);
+        TryReclaim(shard);
+        return true;
+    }
+
+    // Number of keys, may be outdated right after return
+    size_t Size() const noexcept { return m_nSize.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Locks every key and stops inserts and erases,
+     *        then calls func(const KeyType&, MappedType&)
+     *        for every key.
+     *
+     * Nothing else can access the map until func is called for
+     * all keys, so they are seen as one consistent snapshot.
+     * func must not access the map.
+     *
+     * @throws Whatever func throws, everything is unlocked then
+     */
+    template<typename Func>
+    void ForEachExclusive(Func&& func)
+    {
+        std::vector<std::unique_lock<std::mutex>> vecShardLocks;
+        // Declared after shard locks to be unlocked before them,
+        // otherwise erased node may be freed while still locked here
+        std::vector<std::unique_lock<std::mutex>> vecNodeLocks;
+        std::vector<Node*> vecNodes;
+        vecShardLocks.reserve(shardCount);
+        for (size_t i = 0; i < shardCount; ++i)
+            vecShardLocks.emplace_back(m_upShards[i].Mutex);
+        vecNodeLocks.reserve(m_nSize.load(std::memory_order_relaxed));
+        for (size_t i = 0; i < shardCount; ++i)
+        {
+            Table* pTable = m_upShards[i].pTable.load();
+            for (size_t bucket = 0; bucket < pTable->BucketCount; ++bucket)
+                for (Link* pLink = pTable->upBuckets[bucket].load(); pLink; pLink = pLink->pNext.load())
+                {
+                    vecNodeLocks.emplace_back(pLink->pNode->Mutex);
+                    // Marked, but its eraser waits for the shard mutex to unlink it
+                    if(!pLink->pNode->Erased.load())
+                        vecNodes.push_back(pLink->pNode);
+                }
+        }
+        for (Node* pNode : vecNodes)
+            func(pNode->Key, pNode->Mapped);
+        // Readers that left meanwhile couldn't reclaim
+        for (size_t i = 0; i < shardCount; ++i)
+            TryReclaim(m_upShards[i]);
+    }
+
+private:
+    struct Node
+    {
+        explicit Node(const KeyType& key) : Key(key) {}
+
+        const KeyType Key;
+        MappedType Mapped{};
+        std::mutex Mutex;
+        std::atomic<bool> Erased{false};
+        // Lookups that found the node and wait for its mutex,
+        // retired node is not freed until there are none
+        std::atomic<uint32_t> Pins{0};
+    };
+
+    // Chain cell, nodes are relinked into new cells by rehash
+    // so lookups walking old table are never broken
+    struct Link
+    {
+        Link(Node* pNodeArg, Link* pNextArg) : pNode(pNodeArg), pNext(pNextArg) {}
+
+        Node* const pNode;
+        std::atomic<Link*> pNext;
+    };
+
+    struct Table
+    {
+        explicit Table(size_t bucketCount)
+            : BucketCount(bucketCount), upBuckets(new std::atomic<Link*>[bucketCount])
+        {
+            for (size_t i = 0; i < BucketCount; ++i)
+                upBuckets[i].store(nullptr, std::memory_order_relaxed);
+        }
+
+        const size_t BucketCount;
+        std::unique_ptr<std::atomic<Link*>[]> upBuckets;
+    };
+
+    struct Shard
+    {
+        // Lookups in progress, memory retired by writers
+        // is freed only when there are none
+        std::atomic<uint32_t> Readers{0};
+        // Something is retired, so the last leaving reader frees it
+        std::atomic<bool> HasRetired{false};
+        std::atomic<Table*> pTable{nullptr};
+        // Guards everything below and all writes to the table
+        std::mutex Mutex;
+        size_t Count = 0;
+        std::vector<Node*> vecRetiredNodes;
+        std::vector<Link*> vecRetiredLinks;
+        std::vector<Table*> vecRetiredTables;
+        // Keeps hot atomics of neighbour shards on different cache lines
+        char Padding[NICKSV_CACHE_LINE_SIZE];
+    };
+
+    // Readers count is incremented before and all loads
+    // are sequentially consistent, so writer that unlinked
+    // something and then sees no readers can free it
+    class ReaderGuard
+    {
+        Shard& m_rShard;
+    public:
+        explicit ReaderGuard(Shard& shard) noexcept : m_rShard(shard) { m_rShard.Readers.fetch_add(1); }
+        ~ReaderGuard()
+        {
+            if(m_rShard.Readers.fetch_sub(1) == 1)
+                ReclaimIdle(m_rShard);
+        }
+        DECLARE_RULE_OF_5_DELETE(ReaderGuard);
+    };
+
+    inline Shard& GetShard(size_t hash) const noexcept
+    {
+        return m_upShards[hash % shardCount];
+    }
+
+    static inline size_t BucketIndex(const Table& table, size_t hash) noexcept
+    {
+        return (hash / shardCount) & (table.BucketCount - 1);
+    }
+
+    static Node* FindNode(Shard& shard, size_t hash, const KeyType& key) noexcept
+    {
+        Table* pTable = shard.pTable.load();
+        for (Link* pLink = pTable->upBuckets[BucketIndex(*pTable, hash)].load(); pLink; pLink = pLink->pNext.load())
+            if(pLink->pNode->Key == key && !pLink->pNode->Erased.load())
+                return pLink->pNode;
+        return nullptr;
+    }
+
+    // Pinned node stays alive after the reader guard is gone
+    Node* PinNode(Shard& shard, size_t hash, const KeyType& key, bool isInserting)
+    {
+        ReaderGuard readerGuard(shard);
+        Node* pNode = FindNode(shard, hash, key);
+        if(!pNode && isInserting)
+            pNode = InsertNode(shard, hash, key);
+        if(pNode)
+            pNode->Pins.fetch_add(1);
+        return pNode;
+    }
+
+    // Unpins node, returns it locked or nullptr if it was erased while waiting
+    static Node* LockNode(Shard& shard, Node* pNode) noexcept
+    {
+        pNode->Mutex.lock();
+        if(!pNode->Erased.load())
+        {
+            // Can't be erased while locked here
+            pNode->Pins.fetch_sub(1);
+            return pNode;
+        }
+        pNode->Mutex.unlock();
+        pNode->Pins.fetch_sub(1);
+        ReclaimIdle(shard);
+        return nullptr;
+    }
+
+    Node* InsertNode(Shard& shard, size_t hash, const KeyType& key)
+    {
+        std::lock_guard<std::mutex> lockGuard(shard.Mutex);
+        if(Node* pNode = FindNode(shard, hash, key))
+            return pNode;
+        if(shard.Count >= shard.pTable.load()->BucketCount)
+            Rehash(shard);
+        std::unique_ptr<Node> upNode(new Node(key));
+        Table* pTable = shard.pTable.load();
+        auto& bucket = pTable->upBuckets[BucketIndex(*pTable, hash)];
+        bucket.store(new Link(upNode.get(), bucket.load()));
+        ++shard.Count;
+        m_nSize.fetch_add(1, std::memory_order_relaxed);
+        return upNode.release();
+    }
+
+    // Called under shard mutex
+    void Rehash(Shard& shard)
+    {
+        Table* pOldTable = shard.pTable.load();
+        std::unique_ptr<Table> upNewTable(new Table(pOldTable->BucketCount * 2));
+        shard.vecRetiredTables.reserve(shard.vecRetiredTables.size() + 1);
+        for (size_t bucket = 0; bucket < pOldTable->BucketCount; ++bucket)
+            for (Link* pLink = pOldTable->upBuckets[bucket].load(); pLink; pLink = pLink->pNext.load())
+            {
+                auto& newBucket = upNewTable->upBuckets[BucketIndex(*upNewTable, m_Hash(pLink->pNode->Key))];
+                newBucket.store(new Link(pLink->pNode, newBucket.load()), std::memory_order_relaxed);
+            }
+        shard.pTable.store(upNewTable.release());
+        shard.vecRetiredTables.push_back(pOldTable);
+        shard.HasRetired.store(true);
+        TryReclaim(shard);
+    }
+
+    static void FreeLinks(Table* pTable) noexcept
+    {
+        for (size_t bucket = 0; bucket < pTable->BucketCount; ++bucket)
+        {
+            Link* pLink = pTable->upBuckets[bucket].load();
+            while (pLink)
+            {
+                Link* pNext = pLink->pNext.load();
+                delete pLink;
+                pLink = pNext;
+            }
+        }
+    }
+
+    // Called under shard mutex after something was unlinked
+    static void TryReclaim(Shard& shard) noexcept
+    {
+        if(shard.Readers.load() == 0)
+            Reclaim(shard);
+    }
+
+    // Frees what writers retired while lookups ran in the shard,
+    // if shard mutex is busy, its owner or the next leaving reader does it
+    static void ReclaimIdle(Shard& shard) noexcept
+    {
+        if(!shard.HasRetired.load())
+            return;
+        std::unique_lock<std::mutex> uLock(shard.Mutex, std::try_to_lock);
+        if(uLock.owns_lock())
+            TryReclaim(shard);
+    }
+
+    static void Reclaim(Shard& shard) noexcept
+    {
+        // Pinned nodes wait for the next round
+        size_t keptCount = 0;
+        for (Node* pNode : shard.vecRetiredNodes)
+        {
+            if(pNode->Pins.load())
+                shard.vecRetiredNodes[keptCount++] = pNode;
+            else
+                delete pNode;
+        }
+        shard.vecRetiredNodes.resize(keptCount);
+        for (Link* pLink : shard.vecRetiredLinks)
+            delete pLink;
+        for (Table* pTable : shard.vecRetiredTables)
+        {
+            FreeLinks(pTable);
+            delete pTable;
+        }
+        shard.vecRetiredLinks.clear();
+        shard.vecRetiredTables.clear();
+        shard.HasRetired.store(keptCount != 0);
+    }
+
+    Hash m_Hash;
+    std::unique_ptr<Shard[]> m_upShards;
+    std::atomic<size_t> m_nSize{0};
+};
+
+
+
+}}  /*END OF NAMESPACES*/
+
+
+
+
+#endif // _NICKSV_VALUELOCKED_MAP
@@ -0,0 +1,369 @@
+
+#ifndef _NICKSV_VALUESEQLOCK
+#define _NICKSV_VALUESEQLOCK
+#pragma once
+
+
+#include "NickSV/Tools/ValueLock.h"
+
+
+#include <atomic>
+#include <array>
+#include <functional>
+#include <thread>
+
+
+
+
+namespace NickSV {
+namespace Tools {
+
+
+
+/**
+ * @class ValueSeqLock
+ *
+ * @brief Seqlock keyed by value: writers lock the value
+ *        with inner value lock, readers don't lock anything,
+ *        they take per-value sequence snapshot, read and
+ *        validate that nothing was written meanwhile.
+ *
+ * @tparam ValueT type of value to lock
+ * @tparam stripeCount how many sequence counters there are,
+ *         values are spread over them by std::hash<ValueT>
+ *         (value sharing stripe with a written one makes
+ *         its readers retry, but never blocks writers)
+ * @tparam LockT inner value lock used by writers
+ *
+ * Readers never write shared memory, so hundreds of threads
+ * can read the same hot record without bouncing its cache line:
+ * @code{.cpp}
+ *     // ValueSeqLock<ID> usersLock declared before
+ *     // reader
+ *     auto name = usersLock.Read(id, [&]{ return mapUsers.at(id).name; });
+ *     // writer (same as ValueLock)
+ *     {
+ *         ValueLockGuard<decltype(usersLock)> lockGuard(usersLock, id);
+ *         mapUsers.at(id).name = newName;
+ *     }
+ * @endcode
+ *
+ * @warning
+ * Reader can see partially written OBJECT (it is
+ * detected and read is retried), so reading code
+ * must not follow pointers or throw depending on read data.
+ */
+template<typename ValueT, size_t stripeCount = 64, class LockT = DynamicValueLock<ValueT>>
+class ValueSeqLock
+{
+public:
+
+    static_assert(is_value_lock<LockT>::value, "LockT should be ValueLock/DynamicValueLock/FakeValueLock");
+    static_assert(std::is_same<typename LockT::ValueType, ValueT>::value, "LockT::ValueType must be ValueT");
+    static_assert(stripeCount > 0, "stripeCount must be greater than zero");
+
+    using ValueType = ValueT;
+    using LockType = LockT;
+
+    /**
+     * @brief Sequence snapshot taken by ReadBegin(value).
+     */
+    using SequenceType = uint64_t;
+
+    /**
+     * @class Unlocker
+     *
+     * @brief Unary functor that calls Unlock(value)
+     *        on given pointer to ValueSeqLock
+     *        with value.
+     *
+     * @warning
+     * Invoking throws the same exception as ValueSeqLock::Unlock(value) if there is no stack unwinding,
+     * otherwise printing error message to std::cerr and returns
+     *
+    */
+    class Unlocker
+    {
+        ValueType m_Value;
+    public:
+        Unlocker() = default;
+        DECLARE_RULE_OF_5_DEFAULT(Unlocker, NOTHING);
+        explicit Unlocker(const ValueType& value) : m_Value(value) {}
+
+        /**
+         * @throws
+         * Same exception as ValueSeqLock::Unlock(value) if there is no stack unwinding,
+         * otherwise printing error message to std::cerr and returns
+         */
+        inline void operator()(ValueSeqLock* pValueLock) const
+        {
+            #if NICKSV_EXCEPTIONS
+            try { pValueLock->Unlock(m_Value); }
+            catch(const std::exception& e)
+            {
+                #ifdef __cpp_lib_uncaught_exceptions
+                if(!std::uncaught_exceptions()) throw;
+                #else
+                if(!std::uncaught_exception()) throw;
+                #endif
+                std::cerr << "Unlocker::operator() caught std::exception in call of ValueSeqLock::Unlock()"
+                             "during stack unwinding, it won't be rethrown. std::exception::what(): "
+                          << e.what() << std::endl;
+            }
+            #else
+            pValueLock->Unlock(m_Value);
+            #endif
+        }
+    };
+
+    /**
+     * @class UnlockerAll
+     *
+     * @brief Unary functor that calls UnlockAll([value])
+     *        on given pointer to ValueSeqLock
+     *        with value.
+     *
+     * @warning
+     * Invoking throws the same exception as ValueSeqLock::UnlockAll([value]) if there is no stack unwinding,
+     * otherwise printing error message to std::cerr and returns
+     *
+    */
+    class UnlockerAll
+    {
+        std::unique_ptr<ValueType> m_upKeepLockedValue;
+    public:
+        UnlockerAll() = default;
+        DECLARE_RULE_OF_5_DEFAULT(UnlockerAll, NOTHING);
+        explicit UnlockerAll(const ValueType& keepLockedValue)
+            : m_upKeepLockedValue(new ValueType(keepLockedValue)) {}
+
+        /**
+         * @throws
+         * Same exception as ValueSeqLock::UnlockAll([value]) if there is no stack unwinding,
+         * otherwise printing error message to std::cerr and returns
+         */
+        inline void operator()(ValueSeqLock* pValueLock) const
+        {
+            #if NICKSV_EXCEPTIONS
+            try
+            {
+                if(m_upKeepLockedValue)
+                    pValueLock->UnlockAll(*m_upKeepLockedValue);
+                else
+                    pValueLock->UnlockAll();
+            }
+            catch(const std::exception& e)
+            {
+                #ifdef __cpp_lib_uncaught_exceptions
+                if(!std::uncaught_exceptions()) throw;
+                #else
+                if(!std::uncaught_exception()) throw;
+                #endif
+                std::cerr << "UnlockerAll::operator() caught std::exception in call of ValueSeqLock::UnlockAll()"
+                             "during stack unwinding, it won't be rethrown. std::exception::what(): "
+                          << e.what() << std::endl;
+            }
+            #else
+            if(m_upKeepLockedValue)
+                pValueLock->UnlockAll(*m_upKeepLockedValue);
+            else
+                pValueLock->UnlockAll();
+            #endif
+        }
+    };
+
+
+    // Non-copyable, non-movable
+    DECLARE_RULE_OF_5_DELETE(ValueSeqLock);
+
+    ValueSeqLock() = default;
+
+    /**
+     * @brief Takes sequence snapshot of the value
+     *        to validate read with ReadRetry(value, seq).
+     *        Waits while the value is being written.
+     */
+    SequenceType ReadBegin(const ValueType& value) const noexcept
+    {
+        const auto& sequence = GetStripe(value).Sequence;
+        SequenceType seq = sequence.load(std::memory_order_acquire);
+        while(seq & WritersMask)
+        {
+            std::this_thread::yield();
+            seq = sequence.load(std::memory_order_acquire);
+        }
+        return seq;
+    }
+
+    /**
+     * @brief Checks whether the value could be written
+     *        since ReadBegin(value) returned seq.
+     *
+     * @returns true if read data is not valid and read must be retried
+     */
+    bool ReadRetry(const ValueType& value, SequenceType seq) const noexcept
+    {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return GetStripe(value).Sequence.load(std::memory_order_relaxed) != seq;
+    }
+
+    /**
+     * @brief Calls readFunc() until it runs
+     *        without concurrent write of the value.
+     *
+     * @returns readFunc() result of the valid run
+     */
+    template<class Func>
+    auto Read(const ValueType& value, Func readFunc) const
+    -> std::enable_if_t<!std::is_void<decltype(readFunc())>::value, decltype(readFunc())>
+    {
+        while(true)
+        {
+            SequenceType seq = ReadBegin(value);
+            auto result = readFunc();
+            if(!ReadRetry(value, seq))
+                return result;
+        }
+    }
+
+    template<class Func>
+    auto Read(const ValueType& value, Func readFunc) const
+    -> std::enable_if_t<std::is_void<decltype(readFunc())>::value, void>
+    {
+        SequenceType seq;
+        do
+        {
+            seq = ReadBegin(value);
+            readFunc();
+        } while(ReadRetry(value, seq));
+    }
+
+    /**
+     * @brief Locks the value for writing.
+     *
+     * @throws Same as LockT::Lock(value)
+     */
+    void Lock(const ValueType& value) noexcept(false)
+    {
+        m_lock.Lock(value);
+        BeginWrite(GetStripe(value));
+    }
+
+    /**
+     * @brief Locks every value for writing.
+     *
+     * @throws Same as LockT::LockAll()
+     */
+    void LockAll() noexcept(false)
+    {
+        m_lock.LockAll();
+        for (auto& stripe : m_aStripes)
+            BeginWrite(stripe);
+    }
+
+    /**
+     * @brief Unlocks given value.
+     *
+     * @throws Same as LockT::Unlock(value)
+     *
+     * @warning ValueSeqLock::Lock(value) must be called
+     * by the current thread of execution,
+     * otherwise, the behavior is undefined.
+    */
+    void Unlock(const ValueType& value) noexcept(false)
+    {
+        EndWrite(GetStripe(value));
+        m_lock.Unlock(value);
+    }
+
+    /**
+     * @brief Unlocks all values.
+     *
+     * @warning ValueSeqLock::LockAll() must be called
+     * by the current thread of execution,
+     * otherwise, the behavior is undefined.
+    */
+    void UnlockAll() noexcept
+    {
+        for (auto& stripe : m_aStripes)
+            EndWrite(stripe);
+        m_lock.UnlockAll();
+    }
+
+    /**
+     * @brief Unlocks all values except given one.
+     *
+     * @throws Same as LockT::UnlockAll(keepLockedValue)
+     *
+     * @warning ValueSeqLock::LockAll() must be called
+     * by the current thread of execution,
+     * otherwise, the behavior is undefined.
+    */
+    void UnlockAll(const ValueType& keepLockedValue) noexcept(false)
+    {
+        const Stripe* pKeepStripe = &GetStripe(keepLockedValue);
+        for (auto& stripe : m_aStripes)
+        {
+            if(&stripe != pKeepStripe)
+                EndWrite(stripe);
+        }
+        m_lock.UnlockAll(keepLockedValue);
+    }
+
+    /**
+     * @throws Same as LockT::TryLock(value)
+     */
+    bool TryLock(const ValueType& value) noexcept(false)
+    {
+        if(!m_lock.TryLock(value))
+            return false;
+        BeginWrite(GetStripe(value));
+        return true;
+    }
+
+private:
+    // Low half of the sequence counts writers in progress,
+    // high half counts finished writes, so stripe shared by
+    // concurrent writers of different values stays consistent
+    static constexpr SequenceType WritersMask = 0xFFFFFFFFULL;
+    static constexpr SequenceType WriteDone   = WritersMask + 1;
+
+    struct alignas(NICKSV_CACHE_LINE_SIZE) Stripe
+    {
+        std::atomic<SequenceType> Sequence{0};
+    };
+
+    static inline void BeginWrite(Stripe& stripe) noexcept
+    {
+        stripe.Sequence.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    static inline void EndWrite(Stripe& stripe) noexcept
+    {
+        stripe.Sequence.fetch_add(WriteDone - 1, std::memory_order_release);
+    }
+
+    inline Stripe& GetStripe(const ValueType& value) noexcept
+    {
+        return m_aStripes[std::hash<ValueType>{}(value) % stripeCount];
+    }
+
+    inline const Stripe& GetStripe(const ValueType& value) const noexcept
+    {
+        return m_aStripes[std::hash<ValueType>{}(value) % stripeCount];
+    }
+
+    std::array<Stripe, stripeCount> m_aStripes;
+    LockT m_lock;
+};
+
+
+template<typename ValueT, size_t stripeCount, class LockT>
+struct is_value_lock<ValueSeqLock<ValueT, stripeCount, LockT>> : std::true_type {};
+
+
+}}  /*END OF NAMESPACES*/
+
+
+#endif // _NICKSV_VALUESEQLOCK
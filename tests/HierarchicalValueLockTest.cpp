@@ -0,0 +1,146 @@
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <chrono>
+
+
+#define TEST_IGNORE_PRINT_ON_SUCCESS
+
+#define TEST_SETW_VALUE 65
+
+#include "NickSV/Tools/HierarchicalValueLock.h"
+#include "NickSV/Tools/Testing.h"
+
+
+constexpr static size_t threadC = 8;
+
+using HVLock = NickSV::Tools::HierarchicalValueLock;
+using HMode = NickSV::Tools::HierarchicalLockMode;
+
+
+static int HVL_test_modes()
+{
+    HVLock vLock;
+    vLock.Lock("tenant/42/doc/1");
+    TEST_CHECK_STAGE(vLock.TryLock("tenant/42/doc/2"));
+    TEST_CHECK_STAGE(vLock.TryLock("tenant/7"));
+    TEST_CHECK_STAGE(!vLock.TryLock("tenant/42"));
+    TEST_CHECK_STAGE(!vLock.TryLock("tenant/42", HMode::Shared));
+    TEST_CHECK_STAGE(!vLock.TryLock("tenant/42/doc/1/page", HMode::Shared));
+    TEST_CHECK_STAGE(!vLock.TryLock("tenant"));
+    TEST_CHECK_STAGE(vLock.TryLock("tenant/42", HMode::IntentionShared));
+    vLock.Unlock("tenant/42", HMode::IntentionShared);
+    vLock.Unlock("tenant/42/doc/1");
+    vLock.Unlock("tenant/42/doc/2");
+
+    TEST_CHECK_STAGE(vLock.TryLock("tenant/42", HMode::Shared));
+    TEST_CHECK_STAGE(vLock.TryLock("tenant/42/doc/1", HMode::Shared));
+    TEST_CHECK_STAGE(!vLock.TryLock("tenant/42/doc/1"));
+    TEST_CHECK_STAGE(!vLock.TryLock(""));
+    vLock.Unlock("tenant/42/doc/1", HMode::Shared);
+    vLock.Unlock("tenant/42", HMode::Shared);
+    vLock.Unlock("tenant/7");
+
+    vLock.LockAll();
+    TEST_CHECK_STAGE(!vLock.TryLock("tenant", HMode::IntentionShared));
+    vLock.UnlockAll("tenant/1");
+    TEST_CHECK_STAGE(!vLock.TryLock("tenant/1/doc", HMode::Shared));
+    TEST_CHECK_STAGE(vLock.TryLock("tenant/2/doc"));
+    vLock.Unlock("tenant/1");
+    vLock.Unlock("tenant/2/doc");
+    TEST_CHECK_STAGE(vLock.TryLock(""));
+    vLock.UnlockAll();
+    return TEST_SUCCESS;
+}
+
+static int HVL_test_subtree_exclusion()
+{
+    using namespace NickSV::Tools;
+    HVLock vLock;
+    std::vector<uint32_t> vecDocs(threadC, 0);
+    std::atomic<bool> stop{false};
+    std::atomic<uint32_t> errors{0};
+    std::vector<std::thread> threads;
+    for (size_t th = 0; th < threadC; ++th)
+        threads.emplace_back([&, th]
+        {
+            const std::string path = "tenant/42/doc/" + std::to_string(th);
+            while(!stop)
+            {
+                ValueLockGuard<HVLock> lockGuard(vLock, path);
+                if(vecDocs[th] % 2) ++errors;
+                ++vecDocs[th];
+                ++vecDocs[th];
+            }
+        });
+    for (size_t i = 0; i < 200; ++i)
+    {
+        HierarchicalValueLockGuard<HVLock> lockGuard(vLock, "tenant/42", HMode::Shared);
+        for (auto doc: vecDocs)
+        {
+            if(doc % 2) ++errors;
+        }
+    }
+    stop = true;
+    for (auto& thread : threads)
+        thread.join();
+    TEST_CHECK_STAGE(errors == 0);
+    return TEST_SUCCESS;
+}
+
+static int HVL_test_no_starvation()
+{
+    using namespace NickSV::Tools;
+    using namespace std::chrono;
+    HVLock vLock;
+    std::atomic<uint32_t> order{0};
+    uint32_t writerOrder = 0;
+    // Readers of tenant documents are already there when the writer comes
+    for (size_t th = 0; th <= threadC; ++th)
+        vLock.Lock("tenant/42/doc/" + std::to_string(th), HMode::Shared);
+    std::thread writer([&]() noexcept
+    {
+        ValueLockGuard<HVLock> lockGuard(vLock, "tenant/42");
+        writerOrder = ++order;
+    });
+    std::this_thread::sleep_for(milliseconds(20));
+    // New readers keep arriving and being woken while old ones leave
+    std::vector<std::thread> threads;
+    for (size_t th = 1; th <= threadC; ++th)
+    {
+        threads.emplace_back([&, th]() noexcept
+        {
+            HierarchicalValueLockGuard<HVLock> lockGuard(vLock, "tenant/42/page/" + std::to_string(th), HMode::Shared);
+            ++order;
+        });
+        std::this_thread::sleep_for(milliseconds(20));
+        vLock.Unlock("tenant/42/doc/" + std::to_string(th), HMode::Shared);
+        std::this_thread::sleep_for(milliseconds(20));
+    }
+    const bool isWriterWaiting = order == 0;
+    vLock.Unlock("tenant/42/doc/0", HMode::Shared);
+    writer.join();
+    for (auto& thread : threads)
+        thread.join();
+    TEST_CHECK_STAGE(isWriterWaiting);
+    TEST_CHECK_STAGE(writerOrder == 1);
+    return TEST_SUCCESS;
+}
+
+
+int main()
+{
+    using namespace NickSV::Tools;
+
+    TEST_VERIFY(HVL_test_modes());
+    //
+    TEST_VERIFY(HVL_test_subtree_exclusion());
+    //
+    TEST_VERIFY(HVL_test_no_starvation());
+
+    std::cout << '\n' << Testing::TestsFailed << " subtests failed\n";
+
+    return Testing::TestsFailed;
+}
@@ -0,0 +1,119 @@
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+
+#define TEST_IGNORE_PRINT_ON_SUCCESS
+
+#define TEST_SETW_VALUE 65
+
+#include "NickSV/Tools/InterprocessValueLock.h"
+#include "NickSV/Tools/Testing.h"
+
+
+constexpr static size_t slotC = 4;
+
+using IPVLock = NickSV::Tools::InterprocessValueLock<uint32_t, slotC>;
+
+
+static std::string TestShmName()
+{
+    return "/NickSVToolsTest_" + std::to_string(getpid());
+}
+
+static int IPVL_test_attach()
+{
+    const std::string name = TestShmName();
+    IPVLock::Remove(name);
+    IPVLock creator = IPVLock::Create(name);
+    IPVLock attached = IPVLock::Attach(name);
+
+    TEST_CHECK_STAGE(creator.Lock(1) == NickSV::Tools::InterprocessLockResult::Locked);
+    TEST_CHECK_STAGE(!attached.TryLock(1));
+    TEST_CHECK_STAGE(attached.TryLock(2));
+    creator.Unlock(1);
+    TEST_CHECK_STAGE(attached.TryLock(1));
+    attached.Unlock(1);
+    attached.Unlock(2);
+    {
+        NickSV::Tools::ValueLockGuard<IPVLock> guard(attached, 3);
+        TEST_CHECK_STAGE(!creator.TryLock(3));
+    }
+    TEST_CHECK_STAGE(creator.TryLock(3));
+    creator.Unlock(3);
+
+    TEST_CHECK_STAGE(IPVLock::Remove(name));
+    TEST_CHECK_STAGE(!IPVLock::Remove(name));
+    return TEST_SUCCESS;
+}
+
+static int IPVL_test_owner_death()
+{
+    const std::string name = TestShmName();
+    IPVLock::Remove(name);
+    IPVLock lock = IPVLock::Create(name);
+
+    pid_t child = fork();
+    if(child == 0)
+    {
+        IPVLock childLock = IPVLock::Attach(name);
+        childLock.Lock(5);
+        _exit(0); // dies holding value 5
+    }
+    TEST_CHECK_STAGE(child > 0);
+    int status = 0;
+    TEST_CHECK_STAGE(waitpid(child, &status, 0) == child);
+
+    TEST_CHECK_STAGE(lock.Lock(5) == NickSV::Tools::InterprocessLockResult::OwnerDied);
+    TEST_CHECK_STAGE(lock.RecoveredCount() == 1);
+    lock.Unlock(5);
+
+    // dead owner's slot reference is given back, every slot is usable
+    for (uint32_t value = 10; value < 10 + slotC; ++value)
+    {
+        TEST_CHECK_STAGE(lock.TryLock(value));
+    }
+    for (uint32_t value = 10; value < 10 + slotC; ++value)
+        lock.Unlock(value);
+
+    TEST_CHECK_STAGE(lock.Lock(5) == NickSV::Tools::InterprocessLockResult::Locked);
+    lock.Unlock(5);
+
+    IPVLock::Remove(name);
+    return TEST_SUCCESS;
+}
+
+static int IPVL_test_placement()
+{
+    alignas(IPVLock::State) static unsigned char memory[IPVLock::StateSize()];
+    IPVLock::Initialize(memory);
+    IPVLock lock1(memory);
+    IPVLock lock2(memory);
+    lock1.LockAll();
+    TEST_CHECK_STAGE(!lock2.TryLock(1));
+    lock1.UnlockAll(1);
+    TEST_CHECK_STAGE(!lock2.TryLock(1));
+    TEST_CHECK_STAGE(lock2.TryLock(2));
+    lock1.Unlock(1);
+    lock2.Unlock(2);
+    return TEST_SUCCESS;
+}
+
+
+int main()
+{
+    using namespace NickSV::Tools;
+
+    TEST_VERIFY(IPVL_test_attach());
+    //
+    TEST_VERIFY(IPVL_test_owner_death());
+    //
+    TEST_VERIFY(IPVL_test_placement());
+
+    std::cout << '\n' << Testing::TestsFailed << " subtests failed\n";
+
+    return Testing::TestsFailed;
+}
@@ -0,0 +1,171 @@
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <random>
+
+
+#define TEST_IGNORE_PRINT_ON_SUCCESS
+
+#define TEST_SETW_VALUE 65
+
+#include "NickSV/Tools/IntervalValueLock.h"
+#include "NickSV/Tools/Testing.h"
+
+
+constexpr static size_t threadC = 8;
+constexpr static uint32_t valueC = 64;
+
+using IVLock = NickSV::Tools::IntervalValueLock<uint32_t>;
+
+
+static int IVL_test_overlap()
+{
+    IVLock vLock;
+    vLock.LockRange(10, 20);
+    TEST_CHECK_STAGE(!vLock.TryLock(10));
+    TEST_CHECK_STAGE(!vLock.TryLock(19));
+    TEST_CHECK_STAGE(vLock.TryLock(20));
+    TEST_CHECK_STAGE(vLock.TryLock(9));
+    TEST_CHECK_STAGE(!vLock.TryLockRange(0, 11));
+    TEST_CHECK_STAGE(!vLock.TryLockRange(15, 16));
+    TEST_CHECK_STAGE(!vLock.TryLockRange(0, 100));
+    TEST_CHECK_STAGE(vLock.TryLockRange(21, 30)); // disjoint
+    TEST_CHECK_STAGE(!vLock.TryLockRange(20, 21));
+    vLock.Unlock(20);
+    TEST_CHECK_STAGE(vLock.TryLockRange(20, 21));
+    vLock.UnlockRange(10, 20);
+    TEST_CHECK_STAGE(vLock.TryLockRange(10, 20));
+    vLock.UnlockRange(10, 20);
+    vLock.UnlockRange(20, 21);
+    vLock.UnlockRange(21, 30);
+    vLock.Unlock(9);
+
+    vLock.LockAll();
+    TEST_CHECK_STAGE(!vLock.TryLock(1));
+    TEST_CHECK_STAGE(!vLock.TryLockRange(0, 2));
+    vLock.UnlockAll(1);
+    TEST_CHECK_STAGE(!vLock.TryLockRange(0, 2));
+    TEST_CHECK_STAGE(vLock.TryLockRange(2, 4));
+    vLock.Unlock(1);
+    vLock.UnlockRange(2, 4);
+    TEST_CHECK_STAGE(vLock.TryLockRange(0, 100));
+    vLock.UnlockRange(0, 100);
+    return TEST_SUCCESS;
+}
+
+static int IVL_test_point_blocks_in_range()
+{
+    IVLock vLock;
+    std::atomic<bool> pointLocked{false};
+    vLock.LockRange(100, 200);
+    std::thread pointThread([&]
+    {
+        vLock.Lock(150);
+        pointLocked = true;
+        vLock.Unlock(150);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    TEST_CHECK_STAGE(!pointLocked);
+    TEST_CHECK_STAGE(!vLock.TryLockRange(140, 160));
+    vLock.UnlockRange(100, 200);
+    pointThread.join();
+    TEST_CHECK_STAGE(pointLocked);
+    TEST_CHECK_STAGE(vLock.TryLockRange(140, 160));
+    vLock.UnlockRange(140, 160);
+    return TEST_SUCCESS;
+}
+
+static int IVL_test_range_not_starved()
+{
+    IVLock vLock;
+    std::atomic<bool> rangeLocked{false};
+    vLock.Lock(5);
+    std::thread rangeThread([&]
+    {
+        vLock.LockRange(0, 10);
+        rangeLocked = true;
+        vLock.UnlockRange(0, 10);
+    });
+    while_limit(vLock.TryLock(7), 1000)
+    {
+        vLock.Unlock(7);
+        std::this_thread::yield();
+    }
+    // waiting range blocks later single values inside it
+    TEST_CHECK_STAGE(!vLock.TryLock(7));
+    TEST_CHECK_STAGE(vLock.TryLock(10));
+    vLock.Unlock(5);
+    rangeThread.join();
+    TEST_CHECK_STAGE(rangeLocked);
+    vLock.Unlock(10);
+    return TEST_SUCCESS;
+}
+
+static int IVL_test_random_ranges()
+{
+    IVLock vLock;
+    std::vector<uint32_t> vecOwners(valueC, 0);
+    std::atomic<uint32_t> errors{0};
+    std::vector<std::thread> threads;
+    for (uint32_t th = 1; th <= threadC; ++th)
+        threads.emplace_back([&, th]
+        {
+            std::mt19937 gen(th);
+            std::uniform_int_distribution<uint32_t> dist(0, valueC - 1);
+            for (size_t i = 0; i < 2000; ++i)
+            {
+                uint32_t begin = dist(gen);
+                uint32_t end = begin + 1 + dist(gen) % 8;
+                if(end > valueC)
+                    end = valueC;
+                bool isPoint = (i % 3 == 0);
+                if(isPoint)
+                {
+                    vLock.Lock(begin);
+                    end = begin + 1;
+                }
+                else
+                    vLock.LockRange(begin, end);
+                for (uint32_t v = begin; v < end; ++v)
+                {
+                    if(vecOwners[v]) ++errors;
+                    vecOwners[v] = th;
+                }
+                std::this_thread::yield();
+                for (uint32_t v = begin; v < end; ++v)
+                {
+                    if(vecOwners[v] != th) ++errors;
+                    vecOwners[v] = 0;
+                }
+                if(isPoint)
+                    vLock.Unlock(begin);
+                else
+                    vLock.UnlockRange(begin, end);
+            }
+        });
+    for (auto& thread : threads)
+        thread.join();
+    TEST_CHECK_STAGE(errors == 0);
+    TEST_CHECK_STAGE(vLock.TryLockRange(0, valueC));
+    vLock.UnlockRange(0, valueC);
+    return TEST_SUCCESS;
+}
+
+
+int main()
+{
+    using namespace NickSV::Tools;
+
+    TEST_VERIFY(IVL_test_overlap());
+    //
+    TEST_VERIFY(IVL_test_point_blocks_in_range());
+    //
+    TEST_VERIFY(IVL_test_range_not_starved());
+    //
+    TEST_VERIFY(IVL_test_random_ranges());
+
+    std::cout << '\n' << Testing::TestsFailed << " subtests failed\n";
+
+    return Testing::TestsFailed;
+}
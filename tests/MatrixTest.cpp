@@ -1,6 +1,11 @@
 
 
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+
 #include "NickSV/Tools/Matrix.h"
 #include "NickSV/Tools/Testing.h"
 
@@ -11,9 +16,519 @@ static int MatrixTest()
     return TEST_SUCCESS;
 }
 
+template<class ValT>
+static NT::MatrixT<ValT> RandomMatrix(NT::MatrixSizeType rows, NT::MatrixSizeType cols, unsigned seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int> dist(-8, 8);
+    NT::MatrixT<ValT> mat(rows, cols);
+    for(NT::MatrixSizeType y = 0; y < rows; ++y)
+        for(NT::MatrixSizeType x = 0; x < cols; ++x)
+            mat.AtUnsafe(y, x) = static_cast<ValT>(dist(gen));
+    return mat;
+}
+
+// Compares assigned expression with its own AtUnsafe(), which is never Gemm()
+template<class M, class ValT, class T, class ExValT>
+static bool EqualsElementwise(const NT::MatrixExpression<M, ValT>& mat, const NT::MatrixExpression<T, ExValT>& matEx)
+{
+    if(mat.Rows() != matEx.Rows() || mat.Cols() != matEx.Cols())
+        return false;
+    for(NT::MatrixSizeType y = 0; y < mat.Rows(); ++y)
+        for(NT::MatrixSizeType x = 0; x < mat.Cols(); ++x)
+            if(std::abs(static_cast<double>(mat.AtUnsafe(y, x)) - static_cast<double>(matEx.AtUnsafe(y, x))) > 1e-6)
+                return false;
+    return true;
+}
+
+template<class ValT>
+static int MT_test_product()
+{
+    // sizes around register tiles and cache blocks
+    const NT::MatrixSizeType sizes[][3] = {
+        {1, 1, 1}, {7, 13, 5}, {6, 8, 16}, {33, 300, 17}, {150, 70, 4100}, {200, 257, 31}};
+    for(auto& size : sizes)
+    {
+        auto matA = RandomMatrix<ValT>(size[0], size[1], 1);
+        auto matB = RandomMatrix<ValT>(size[1], size[2], 2);
+        NT::MatrixT<ValT> matC = matA * matB;
+        TEST_CHECK_STAGE(EqualsElementwise(matC, matA * matB));
+    }
+
+    auto matA = RandomMatrix<ValT>(40, 30, 3);
+    auto matB = RandomMatrix<ValT>(40, 20, 4);
+    NT::MatrixT<ValT> matC = NT::Transpose(matA) * (matB + matB);
+    TEST_CHECK_STAGE(EqualsElementwise(matC, NT::Transpose(matA) * (matB + matB)));
+
+    // product assigned to another value type and to its own operand
+    NT::MatrixT<double> matD = matA * NT::Transpose(matA);
+    TEST_CHECK_STAGE(EqualsElementwise(matD, matA * NT::Transpose(matA)));
+    NT::MatrixT<ValT> matE = matA;
+    matE = matE * NT::Transpose(matA);
+    TEST_CHECK_STAGE(EqualsElementwise(matE, matD));
+    return TEST_SUCCESS;
+}
+
+// Operands of different value types are multiplied as they are, not converted to destination type first
+static int MT_test_mixed_product()
+{
+    NT::MatrixT<float> matA = {{0.5f, 1.5f}, {2.5f, 0.5f}};
+    NT::MatrixT<int> matB = {{4, 2}, {2, 4}};
+    NT::MatrixT<int> matC = matA * matB;
+    TEST_CHECK_STAGE(EqualsElementwise(matC, NT::MatrixT<int>{{5, 7}, {11, 7}}));
+    TEST_CHECK_STAGE(EqualsElementwise(matC, matA * matB));
+    NT::MatrixT<double> matD = matA * matB;
+    TEST_CHECK_STAGE(EqualsElementwise(matD, NT::MatrixT<double>{{5, 7}, {11, 7}}));
+    matD = matB * matA;
+    TEST_CHECK_STAGE(EqualsElementwise(matD, NT::MatrixT<double>{{7, 7}, {11, 5}}));
+
+    // products of halves and even numbers are exact, so element-wise sums are the same
+    NT::MatrixT<float> matHalves = 0.5f * RandomMatrix<float>(70, 300, 8);
+    NT::MatrixT<int> matEven = 2 * RandomMatrix<int>(300, 40, 9);
+    NT::MatrixT<double> matMixed = matHalves * matEven;
+    TEST_CHECK_STAGE(EqualsElementwise(matMixed, matHalves * matEven));
+    NT::MatrixT<float> matFloat = matHalves * matEven;
+    TEST_CHECK_STAGE(EqualsElementwise(matFloat, matHalves * matEven));
+    NT::MatrixT<double> matInts = RandomMatrix<int>(70, 300, 10) * matEven;
+    TEST_CHECK_STAGE(EqualsElementwise(matInts, RandomMatrix<int>(70, 300, 10) * matEven));
+    return TEST_SUCCESS;
+}
+
 template<typename T>
 class ShowType;
 
+static int MT_test_nested_product()
+{
+    auto matA = RandomMatrix<double>(30, 40, 5);
+    auto matB = RandomMatrix<double>(40, 20, 6);
+    auto matC = RandomMatrix<double>(20, 30, 7);
+    NT::MatrixT<double> matAB = matA * matB;
+    NT::MatrixT<double> matABC = matAB * matC;
+
+    // product operands are evaluated once when enclosing operation is built
+    using NestedType = decltype((matA * matB) * matC);
+    static_assert(std::is_same<NestedType::OperationType::LeftType, NT::MatrixTemporary<double>>::value, "");
+    static_assert(std::is_same<NestedType::OperationType::RightType, NT::MatrixT<double>>::value, "");
+    TEST_CHECK_STAGE(EqualsElementwise(matABC, (matA * matB) * matC));
+    NT::MatrixT<double> matNested = (matA * matB) * matC;
+    TEST_CHECK_STAGE(EqualsElementwise(matNested, matABC));
+
+    NT::MatrixT<double> matSum = matA * matB + 2 * (matA * matB) - NT::Transpose(NT::Transpose(matB) * NT::Transpose(matA));
+    TEST_CHECK_STAGE(EqualsElementwise(matSum, 2 * matAB));
+
+    auto matEval = NT::Eval(matA + matA);
+    static_assert(std::is_same<decltype(matEval), NT::MatrixTemporary<double>>::value, "");
+    matA.SetAll(0);
+    TEST_CHECK_STAGE(!EqualsElementwise(matA, matEval));
+    NT::MatrixT<double> matEvalB = matEval * matB;
+    TEST_CHECK_STAGE(EqualsElementwise(matEvalB, 2 * matAB));
+    return TEST_SUCCESS;
+}
+
+static int MT_test_linear_assign()
+{
+    auto matA = RandomMatrix<double>(17, 23, 8);
+    auto matB = RandomMatrix<double>(17, 23, 9);
+    auto matC = RandomMatrix<double>(23, 17, 10);
+
+    static_assert(NT::is_matrix_linear<decltype(3 * matA + matB)>::value, "");
+    static_assert(NT::is_matrix_linear<decltype(-NT::MatrixStaticCast<int>(matA - matB))>::value, "");
+    static_assert(NT::is_matrix_linear<decltype(NT::Eval(matA) + matB)>::value, "");
+    static_assert(!NT::is_matrix_linear<decltype(NT::Transpose(matC) + matB)>::value, "");
+    static_assert(!NT::is_matrix_linear<decltype(matA * matC)>::value, "");
+    static_assert(!NT::is_matrix_linear<double>::value, "");
+
+    auto linearEx = 3 * matA + matB - (-matB);
+    for(NT::MatrixSizeType index = 0; index < matA.Rows() * matA.Cols(); ++index)
+    {
+        TEST_CHECK_STAGE(linearEx.AtLinear(index) == linearEx.AtUnsafe(index / matA.Cols(), index % matA.Cols()));
+    }
+    NT::MatrixT<double> matLinear = linearEx;
+    TEST_CHECK_STAGE(EqualsElementwise(matLinear, linearEx));
+    NT::MatrixT<int> matCast = NT::MatrixStaticCast<int>(2 * matA);
+    TEST_CHECK_STAGE(EqualsElementwise(matCast, 2 * matA));
+    NT::MatrixT<double> matMixed = NT::Transpose(matC) + 2 * matB;
+    TEST_CHECK_STAGE(EqualsElementwise(matMixed, NT::Transpose(matC) + 2 * matB));
+    return TEST_SUCCESS;
+}
+
+static int MT_test_fixed_size()
+{
+    using Mat3 = NT::MatrixT<double, 3, 3>;
+    using Vec3 = NT::MatrixT<double, 3, 1>;
+    static_assert(sizeof(Mat3) == 9 * sizeof(double), "");
+    static_assert(Mat3::Rows() == 3 && Vec3::Cols() == 1, "");
+    static_assert(std::is_same<NT::MatrixT<double>, NT::MatrixT<double, NT::MatrixDynamicSize, NT::MatrixDynamicSize>>::value, "");
+
+    Mat3 matRotation = {{0, -1, 0}, {1, 0, 0}, {0, 0, 1}};
+    Vec3 vecPoint = {{1}, {2}, {3}};
+    Mat3 matZero;
+    TEST_CHECK_STAGE(matZero.AtUnsafe(2, 2) == 0);
+
+    static_assert(NT::is_matrix_static<decltype(matRotation * matRotation * vecPoint + vecPoint)>::value, "");
+    static_assert(NT::matrix_static_rows<decltype(NT::Transpose(vecPoint))>::value == 1, "");
+    static_assert(NT::matrix_static_cols<decltype(NT::Transpose(vecPoint))>::value == 3, "");
+    static_assert(std::is_same<decltype(NT::Eval(matRotation)), NT::MatrixTemporary<double, 3, 3>>::value, "");
+    static_assert(std::is_same<NT::matrix_operand_t<decltype(matRotation * matRotation)>, NT::MatrixTemporary<double, 3, 3>>::value, "");
+
+    Vec3 vecRotated = matRotation * matRotation * vecPoint + vecPoint;
+    TEST_CHECK_STAGE(EqualsElementwise(vecRotated, NT::MatrixT<double>{{0}, {0}, {6}}));
+    NT::MatrixT<double, 1, 1> matDot = NT::Transpose(vecPoint) * vecPoint;
+    TEST_CHECK_STAGE(matDot.AtUnsafe(0, 0) == 14);
+
+    // same results as dynamic matrices
+    auto matDynA = RandomMatrix<double>(4, 4, 14);
+    auto matDynB = RandomMatrix<double>(4, 4, 15);
+    NT::MatrixT<double, 4, 4> matA = matDynA;
+    NT::MatrixT<double, 4, 4> matB = matDynB;
+    NT::MatrixT<double, 4, 4> matC = matA * NT::Transpose(matB) - 2 * matA;
+    TEST_CHECK_STAGE(EqualsElementwise(matC, matDynA * NT::Transpose(matDynB) - 2 * matDynA));
+    // mixed with dynamic ones, shape is checked at runtime
+    NT::MatrixT<double> matMixed = matA + matDynB;
+    TEST_CHECK_STAGE(EqualsElementwise(matMixed, matDynA + matDynB));
+    matA = matA * matB;
+    TEST_CHECK_STAGE(EqualsElementwise(matA, matDynA * matDynB));
+
+    // beyond unrolling limit
+    auto matDynBig = RandomMatrix<double>(12, 12, 16);
+    NT::MatrixT<double, 12, 12> matBig = matDynBig;
+    NT::MatrixT<double, 12, 12> matBigT = NT::Transpose(matBig) + matBig;
+    TEST_CHECK_STAGE(EqualsElementwise(matBigT, NT::Transpose(matDynBig) + matDynBig));
+
+    bool isThrown = false;
+    try { NT::MatrixT<double, 3, 3> matWrong = matDynA; (void)matWrong; }
+    catch(const std::invalid_argument&) { isThrown = true; }
+    TEST_CHECK_STAGE(isThrown);
+    return TEST_SUCCESS;
+}
+
+static int MT_test_aligned_layout()
+{
+    using AlignedMatrix = NT::MatrixT<double, NT::MatrixDynamicSize, NT::MatrixDynamicSize, NT::MatrixAlignedLayout<>>;
+    static_assert(!NT::is_matrix_linear<AlignedMatrix>::value, "");
+    static_assert(AlignedMatrix::Alignment() == NICKSV_CACHE_LINE_SIZE, "");
+    TEST_CHECK_STAGE(AlignedMatrix(3, 5).Stride() == 8);
+    TEST_CHECK_STAGE(AlignedMatrix(3, 9).Stride() == 16);
+    // 64 columns take 8 cache lines, one more spreads rows over cache sets
+    TEST_CHECK_STAGE(AlignedMatrix(3, 64).Stride() == 72);
+    TEST_CHECK_STAGE(NT::MatrixT<double>(3, 64).Stride() == 64);
+
+    auto matA = RandomMatrix<double>(37, 29, 17);
+    auto matB = RandomMatrix<double>(29, 41, 18);
+    AlignedMatrix matAlignedA = matA;
+    AlignedMatrix matAlignedB = matB;
+    for(NT::MatrixSizeType row = 0; row < matAlignedA.Rows(); ++row)
+    {
+        TEST_CHECK_STAGE(reinterpret_cast<uintptr_t>(&matAlignedA.AtUnsafe(row, 0)) % AlignedMatrix::Alignment() == 0);
+    }
+    TEST_CHECK_STAGE(matAlignedA.Data() + matAlignedA.Stride() == &matAlignedA.AtUnsafe(1, 0));
+    for(NT::MatrixSizeType index = 0; index < matA.Rows() * matA.Cols(); ++index)
+    {
+        TEST_CHECK_STAGE(matAlignedA.AtLinear(index) == matA.AtLinear(index));
+    }
+
+    AlignedMatrix matProduct = matAlignedA * matAlignedB;
+    TEST_CHECK_STAGE(EqualsElementwise(matProduct, matA * matB));
+    AlignedMatrix matParallel(matAlignedA * matAlignedB, NT::MatrixParallelism(0, 1));
+    TEST_CHECK_STAGE(EqualsElementwise(matParallel, matA * matB));
+    NT::MatrixT<double> matDense = 2 * matAlignedA - matA;
+    TEST_CHECK_STAGE(EqualsElementwise(matDense, matA));
+    AlignedMatrix matMixed = NT::Transpose(matAlignedB) * NT::Transpose(matA) + NT::Transpose(matProduct);
+    TEST_CHECK_STAGE(EqualsElementwise(matMixed, 2 * NT::Transpose(matA * matB)));
+    NT::MatrixT<int, NT::MatrixDynamicSize, NT::MatrixDynamicSize, NT::MatrixAlignedLayout<32>> matInts = {{1, 2}, {3, 4}};
+    TEST_CHECK_STAGE(matInts.Stride() == 8 && matInts.AtUnsafe(1, 0) == 3 && matInts.AtLinear(3) == 4);
+    return TEST_SUCCESS;
+}
+
+static int MT_test_views()
+{
+    NT::MatrixT<double> mat = {{1, 2, 3, 4}, {5, 6, 7, 8}, {9, 10, 11, 12}};
+    const NT::MatrixT<double> matConst = mat;
+
+    auto block = mat.Block(1, 1, 2, 3);
+    TEST_CHECK_STAGE(block.Rows() == 2 && block.Cols() == 3);
+    TEST_CHECK_STAGE(EqualsElementwise(block, NT::MatrixT<double>{{6, 7, 8}, {10, 11, 12}}));
+    TEST_CHECK_STAGE(EqualsElementwise(mat.RowView(2), NT::MatrixT<double>{{9, 10, 11, 12}}));
+    TEST_CHECK_STAGE(EqualsElementwise(mat.ColView(3), NT::MatrixT<double>{{4}, {8}, {12}}));
+    TEST_CHECK_STAGE(EqualsElementwise(mat.Diagonal(), NT::MatrixT<double>{{1}, {6}, {11}}));
+    TEST_CHECK_STAGE(EqualsElementwise(block.Block(1, 1, 1, 2).Diagonal(), NT::MatrixT<double>{{11}}));
+    static_assert(std::is_same<decltype(matConst.Block(0, 0, 1, 1)), NT::MatrixView<const double>>::value, "");
+    NT::MatrixView<const double> constView = block;
+    TEST_CHECK_STAGE(&constView.AtUnsafe(0, 0) == &mat.AtUnsafe(1, 1));
+
+    // written through to the matrix, copies reference the same elements
+    auto blockCopy = block;
+    blockCopy.AtUnsafe(0, 0) = 60;
+    TEST_CHECK_STAGE(mat.AtUnsafe(1, 1) == 60);
+    mat.Diagonal().SetAll(0);
+    TEST_CHECK_STAGE(mat.AtUnsafe(0, 0) == 0 && mat.AtUnsafe(1, 1) == 0 && mat.AtUnsafe(2, 2) == 0);
+    mat.RowView(0) = matConst.RowView(2);
+    TEST_CHECK_STAGE(EqualsElementwise(mat.RowView(0), matConst.RowView(2)));
+    // overlapping source is read before written
+    mat.Block(0, 0, 3, 3) = NT::Transpose(mat.Block(0, 0, 3, 3));
+    TEST_CHECK_STAGE(EqualsElementwise(mat, NT::MatrixT<double>{{9, 5, 9, 12}, {10, 0, 10, 8}, {11, 7, 0, 12}}));
+    mat.ColView(0) = mat.ColView(3);
+    TEST_CHECK_STAGE(EqualsElementwise(mat.ColView(0), NT::MatrixT<double>{{12}, {8}, {12}}));
+
+    // views in expressions, products go through Gemm()
+    auto matA = RandomMatrix<double>(20, 30, 19);
+    auto matB = RandomMatrix<double>(30, 20, 20);
+    NT::MatrixT<double> matProduct = matA.Block(2, 3, 10, 15) * matB.Block(5, 1, 15, 12);
+    NT::MatrixT<double> matBlockA = matA.Block(2, 3, 10, 15);
+    NT::MatrixT<double> matBlockB = matB.Block(5, 1, 15, 12);
+    TEST_CHECK_STAGE(EqualsElementwise(matProduct, matBlockA * matBlockB));
+    matA.Block(0, 0, 10, 12) = matProduct - matA.Block(10, 0, 10, 12);
+    TEST_CHECK_STAGE(EqualsElementwise(matA.Block(0, 0, 10, 12), matProduct - matA.Block(10, 0, 10, 12)));
+    NT::MatrixT<float> matHalves = 0.5f * RandomMatrix<float>(10, 15, 21);
+    NT::MatrixT<int> matInts = RandomMatrix<int>(15, 12, 22);
+    NT::NoAlias(matA.Block(0, 0, 10, 12)) = matHalves * matInts;
+    TEST_CHECK_STAGE(EqualsElementwise(matA.Block(0, 0, 10, 12), matHalves * matInts));
+    NT::MatrixT<int> matIntsC = RandomMatrix<int>(20, 30, 23);
+    NT::NoAlias(matIntsC.Block(0, 0, 10, 12)) = matHalves * (2 * matInts);
+    TEST_CHECK_STAGE(EqualsElementwise(matIntsC.Block(0, 0, 10, 12), matHalves * (2 * matInts)));
+
+    // padded and fixed-size storage
+    NT::MatrixT<double, NT::MatrixDynamicSize, NT::MatrixDynamicSize, NT::MatrixAlignedLayout<>> matAligned = matB;
+    TEST_CHECK_STAGE(matAligned.View().RowStride() == matAligned.Stride());
+    TEST_CHECK_STAGE(EqualsElementwise(matAligned.Block(3, 4, 5, 6), matB.Block(3, 4, 5, 6)));
+    NT::MatrixT<double, 4, 4> matFixed = matB.Block(0, 0, 4, 4);
+    matFixed.Block(2, 2, 2, 2) = matFixed.Block(0, 0, 2, 2);
+    TEST_CHECK_STAGE(EqualsElementwise(matFixed.Block(2, 2, 2, 2), matB.Block(0, 0, 2, 2)));
+    TEST_CHECK_STAGE(EqualsElementwise(matFixed.Diagonal(), NT::MatrixT<double>{{matB.AtUnsafe(0, 0)}, {matB.AtUnsafe(1, 1)}, 
+        {matB.AtUnsafe(0, 0)}, {matB.AtUnsafe(1, 1)}}));
+
+    bool isThrown = false;
+    try { mat.Block(2, 2, 2, 1); }
+    catch(const std::invalid_argument&) { isThrown = true; }
+    TEST_CHECK_STAGE(isThrown);
+    isThrown = false;
+    try { mat.Block(0, 0, 2, 2) = matConst; }
+    catch(const std::invalid_argument&) { isThrown = true; }
+    TEST_CHECK_STAGE(isThrown);
+    return TEST_SUCCESS;
+}
+
+template<class ValT>
+static bool Equals(const NT::MatrixT<ValT>& matA, const NT::MatrixT<ValT>& matB)
+{
+    if(matA.Rows() != matB.Rows() || matA.Cols() != matB.Cols())
+        return false;
+    for(NT::MatrixSizeType y = 0; y < matA.Rows(); ++y)
+        for(NT::MatrixSizeType x = 0; x < matA.Cols(); ++x)
+            if(matA.AtUnsafe(y, x) != matB.AtUnsafe(y, x))
+                return false;
+    return true;
+}
+
+static int MT_test_parallel_assign()
+{
+    NT::ThreadPool pool(3);
+    const NT::MatrixParallelism serial;
+    const NT::MatrixParallelism parallel(0, 1, &pool);
+    const NT::MatrixParallelism twoThreads(2, 1, &pool);
+
+    // not integers, so different summation order would show up
+    NT::MatrixT<double> matA = 0.37 * RandomMatrix<double>(61, 45, 11);
+    NT::MatrixT<double> matB = 0.29 * RandomMatrix<double>(45, 53, 12);
+    NT::MatrixT<double> matC = 0.53 * RandomMatrix<double>(61, 45, 13);
+
+    // results don't depend on parts, so they are equal exactly
+    NT::MatrixT<double> matProduct(matA * matB, serial);
+    TEST_CHECK_STAGE(Equals(NT::MatrixT<double>(matA * matB, parallel), matProduct));
+    TEST_CHECK_STAGE(Equals(NT::MatrixT<double>(matA * matB, twoThreads), matProduct));
+    TEST_CHECK_STAGE(EqualsElementwise(matProduct, matA * matB));
+    auto productF = NT::MatrixStaticCast<float>(matA) * NT::MatrixStaticCast<float>(matB);
+    TEST_CHECK_STAGE(Equals(NT::MatrixT<float>(productF, parallel), NT::MatrixT<float>(productF, serial)));
+    NT::MatrixT<double> matLinear(3 * matA - matC, serial);
+    TEST_CHECK_STAGE(Equals(NT::MatrixT<double>(3 * matA - matC, parallel), matLinear));
+    auto mixedEx = NT::Transpose(matC) * matA + matB * NT::Transpose(matB);
+    NT::MatrixT<double> matMixed(mixedEx, serial);
+    NT::MatrixT<double> matParallel;
+    matParallel.Assign(mixedEx, parallel);
+    TEST_CHECK_STAGE(Equals(matParallel, matMixed));
+
+    // below threshold runs serial
+    TEST_CHECK_STAGE(Equals(NT::MatrixT<double>(matA * matB, NT::MatrixParallelism(0, size_t(1) << 30, &pool)), matProduct));
+
+    const NT::MatrixParallelism global = NT::MatrixParallelism::Global();
+    NT::MatrixParallelism::SetGlobal(parallel);
+    TEST_CHECK_STAGE(NT::MatrixParallelism::Global().Threads() == 0);
+    TEST_CHECK_STAGE(&NT::MatrixParallelism::Global().Pool() == &pool);
+    NT::MatrixT<double> matGlobal = matA * matB;
+    NT::MatrixParallelism::SetGlobal(global);
+    TEST_CHECK_STAGE(Equals(matGlobal, matProduct));
+    return TEST_SUCCESS;
+}
+
+static int MT_test_compound_assign()
+{
+    auto matA = RandomMatrix<double>(37, 45, 21);
+    auto matB = RandomMatrix<double>(45, 29, 22);
+    auto matC = RandomMatrix<double>(37, 29, 23);
+    const NT::MatrixT<double> matExpected = matC;
+
+    // element-wise ones in place, others through buffer
+    NT::MatrixT<double> mat = matC;
+    mat += matC;
+    TEST_CHECK_STAGE(EqualsElementwise(mat, 2 * matExpected));
+    mat -= 3 * matC;
+    TEST_CHECK_STAGE(EqualsElementwise(mat, -matExpected));
+    mat *= -2;
+    TEST_CHECK_STAGE(EqualsElementwise(mat, 2 * matExpected));
+    NT::MatrixT<double> matSquare = RandomMatrix<double>(20, 20, 24);
+    const NT::MatrixT<double> matSquareCopy = matSquare;
+    matSquare += NT::Transpose(matSquare);
+    TEST_CHECK_STAGE(EqualsElementwise(matSquare, matSquareCopy + NT::Transpose(matSquareCopy)));
+    matSquare -= matSquare * matSquareCopy;
+    TEST_CHECK_STAGE(EqualsElementwise(matSquare, 
+        (matSquareCopy + NT::Transpose(matSquareCopy)) - (matSquareCopy + NT::Transpose(matSquareCopy)) * matSquareCopy));
+
+    // products written and accumulated by Gemm()
+    mat = matC;
+    NT::NoAlias(mat) += matA * matB;
+    TEST_CHECK_STAGE(EqualsElementwise(mat, matC + matA * matB));
+    NT::NoAlias(mat) -= matA * matB;
+    TEST_CHECK_STAGE(EqualsElementwise(mat, matC));
+    const double* pData = mat.Data();
+    NT::NoAlias(mat) = matA * matB;
+    TEST_CHECK_STAGE(mat.Data() == pData);
+    TEST_CHECK_STAGE(EqualsElementwise(mat, matA * matB));
+    NT::MatrixT<int> matInt = RandomMatrix<int>(37, 29, 25);
+    NT::NoAlias(matInt) += RandomMatrix<int>(37, 45, 21) * RandomMatrix<int>(45, 29, 22);
+    TEST_CHECK_STAGE(EqualsElementwise(matInt, RandomMatrix<int>(37, 29, 25) + matA * matB));
+    NT::MatrixT<float> matHalves = 0.5f * RandomMatrix<float>(37, 45, 26);
+    NT::MatrixT<int> matEven = 2 * RandomMatrix<int>(45, 29, 27);
+    NT::NoAlias(matInt) -= matHalves * matEven;
+    NT::NoAlias(matInt.Block(0, 0, 37, 20)) += matHalves * matEven.Block(0, 0, 45, 20);
+    TEST_CHECK_STAGE(EqualsElementwise(matInt.Block(0, 20, 37, 9), 
+        RandomMatrix<int>(37, 29, 25).Block(0, 20, 37, 9) + matA * matB.Block(0, 20, 45, 9) - matHalves * matEven.Block(0, 20, 45, 9)));
+    TEST_CHECK_STAGE(EqualsElementwise(matInt.Block(0, 0, 37, 20), RandomMatrix<int>(37, 29, 25).Block(0, 0, 37, 20) + 
+        matA * matB.Block(0, 0, 45, 20)));
+
+    // padded, fixed-size and views
+    NT::MatrixT<double, NT::MatrixDynamicSize, NT::MatrixDynamicSize, NT::MatrixAlignedLayout<>> matAligned = matC;
+    NT::NoAlias(matAligned) += matA * matB;
+    matAligned += matC;
+    TEST_CHECK_STAGE(EqualsElementwise(matAligned, 2 * matC + matA * matB));
+    NT::MatrixT<double, 4, 4> matFixed = matC.Block(0, 0, 4, 4);
+    matFixed *= 3;
+    matFixed -= NT::Transpose(matFixed);
+    NT::NoAlias(matFixed) += matFixed;
+    NT::MatrixT<double> matBlock = matC.Block(0, 0, 4, 4);
+    TEST_CHECK_STAGE(EqualsElementwise(matFixed, 6 * matBlock - 6 * NT::Transpose(matBlock)));
+    mat = matC;
+    NT::NoAlias(mat.Block(2, 3, 30, 20)) += matA.Block(0, 0, 30, 40) * matB.Block(0, 0, 40, 20);
+    mat.ColView(0) *= 2;
+    mat.Block(0, 0, 2, 2) += mat.Block(1, 1, 2, 2);
+    matBlock = matC.Block(0, 0, 3, 3);
+    TEST_CHECK_STAGE(EqualsElementwise(mat.Block(2, 3, 30, 20), 
+        matC.Block(2, 3, 30, 20) + matA.Block(0, 0, 30, 40) * matB.Block(0, 0, 40, 20)));
+    TEST_CHECK_STAGE(mat.AtUnsafe(5, 0) == 2 * matC.AtUnsafe(5, 0));
+    TEST_CHECK_STAGE(mat.AtUnsafe(0, 0) == 2 * matBlock.AtUnsafe(0, 0) + matBlock.AtUnsafe(1, 1));
+    TEST_CHECK_STAGE(mat.AtUnsafe(1, 1) == matBlock.AtUnsafe(1, 1) + matBlock.AtUnsafe(2, 2));
+    mat = matC;
+    NT::NoAlias(mat.ColView(1)) -= matA * matB.ColView(2);
+    TEST_CHECK_STAGE(EqualsElementwise(mat.ColView(1), matC.ColView(1) - matA * matB.ColView(2)));
+
+    NT::MatrixT<double> matEmpty;
+    matEmpty += NT::MatrixT<double>();
+    NT::NoAlias(matEmpty) -= NT::MatrixT<double>();
+    TEST_CHECK_STAGE(matEmpty.IsEmpty());
+    bool isThrown = false;
+    try { mat += matA; }
+    catch(const std::invalid_argument&) { isThrown = true; }
+    TEST_CHECK_STAGE(isThrown);
+    isThrown = false;
+    try { NT::NoAlias(mat) = matA * matA.Block(0, 0, 45, 37); }
+    catch(const std::invalid_argument&) { isThrown = true; }
+    TEST_CHECK_STAGE(isThrown);
+    return TEST_SUCCESS;
+}
+
+
+static int MT_test_storage_order()
+{
+    using ColMajor = NT::MatrixT<double, NT::MatrixDynamicSize, NT::MatrixDynamicSize, NT::MatrixColMajorLayout>;
+    ColMajor matSmall = {{1, 2, 3}, {4, 5, 6}};
+    const NT::MatrixT<double> matRowSmall = matSmall;
+    TEST_CHECK_STAGE(matSmall.Stride() == 2);
+    TEST_CHECK_STAGE(matSmall.Data()[1] == 4 && matSmall.Data()[2] == 2 && matSmall.At(1, 2) == 6);
+    TEST_CHECK_STAGE(matSmall.View().RowStride() == 1 && matSmall.View().ColStride() == 2);
+    TEST_CHECK_STAGE(matSmall.ColView(1).IsColMajor() && matSmall.IsColMajor() && !matRowSmall.IsColMajor());
+    TEST_CHECK_STAGE(EqualsElementwise(matSmall.RowView(1), NT::MatrixT<double>{{4, 5, 6}}));
+
+    // transposed row-major is a flat copy, other orders are converted element by element
+    auto matRow = RandomMatrix<double>(37, 23, 31);
+    static_assert(NT::is_matrix_linear_together<decltype(NT::Transpose(matRow)), ColMajor>::value, "");
+    static_assert(!NT::is_matrix_linear_together<decltype(matRow + matRow), ColMajor>::value, "");
+    ColMajor matCol = NT::Transpose(matRow);
+    TEST_CHECK_STAGE(EqualsElementwise(matCol, NT::Transpose(matRow)));
+    TEST_CHECK_STAGE(std::equal(matRow.Data(), matRow.Data() + 37 * 23, matCol.Data()));
+    ColMajor matColCopy = matRow;
+    TEST_CHECK_STAGE(EqualsElementwise(matColCopy, matRow));
+    NT::MatrixT<double> matBack = NT::Transpose(matCol) + 2 * matColCopy;
+    TEST_CHECK_STAGE(EqualsElementwise(matBack, 3 * matRow));
+
+    // products of every order combination into both orders
+    auto matA = RandomMatrix<double>(45, 60, 32);
+    auto matB = RandomMatrix<double>(60, 35, 33);
+    ColMajor matColA = matA;
+    ColMajor matColB = matB;
+    NT::MatrixT<double> matExpected = matA * matB;
+    TEST_CHECK_STAGE(EqualsElementwise(matExpected, matA * matB));
+    ColMajor matProduct = matColA * matColB;
+    TEST_CHECK_STAGE(EqualsElementwise(matProduct, matExpected));
+    matProduct = matA * matColB;
+    TEST_CHECK_STAGE(EqualsElementwise(matProduct, matExpected));
+    matBack = matColA * matB;
+    TEST_CHECK_STAGE(EqualsElementwise(matBack, matExpected));
+    matBack = NT::Transpose(matColB) * NT::Transpose(matA);
+    TEST_CHECK_STAGE(EqualsElementwise(matBack, NT::Transpose(matExpected)));
+    NT::ThreadPool pool(2);
+    ColMajor matParallel;
+    matParallel.Assign(matColA * matB, NT::MatrixParallelism(0, 1, &pool));
+    TEST_CHECK_STAGE(std::equal(matParallel.Data(), matParallel.Data() + 45 * 35, matProduct.Data()));
+    NT::MatrixT<int, NT::MatrixDynamicSize, NT::MatrixDynamicSize, NT::MatrixColMajorLayout> matInt = 
+        RandomMatrix<int>(45, 60, 32) * RandomMatrix<int>(60, 35, 33);
+    TEST_CHECK_STAGE(EqualsElementwise(matInt, matExpected));
+
+    // padded and fixed-size column-major storage
+    NT::MatrixT<double, NT::MatrixDynamicSize, NT::MatrixDynamicSize, 
+        NT::MatrixAlignedLayout<64, NT::MatrixStorageOrder::ColMajor>> matAligned = matColA * matB;
+    TEST_CHECK_STAGE(matAligned.Stride() == 48);
+    TEST_CHECK_STAGE(reinterpret_cast<uintptr_t>(&matAligned.AtUnsafe(0, 1)) % 64 == 0);
+    TEST_CHECK_STAGE(EqualsElementwise(matAligned, matExpected));
+    matAligned = NT::Transpose(matBack);
+    TEST_CHECK_STAGE(EqualsElementwise(matAligned, matExpected));
+    NT::MatrixT<double, 3, 2, NT::MatrixColMajorLayout> matFixed = {{1, 2}, {3, 4}, {5, 6}};
+    TEST_CHECK_STAGE(matFixed.Data()[1] == 3 && matFixed.Data()[3] == 2 && matFixed.Stride() == 3);
+    NT::MatrixT<double, 2, 3> matFixedRow = NT::Transpose(matFixed);
+    TEST_CHECK_STAGE(std::equal(matFixed.Data(), matFixed.Data() + 6, matFixedRow.Data()));
+    matFixed = matFixed * (matFixedRow * matFixed);
+    TEST_CHECK_STAGE(EqualsElementwise(matFixed, 
+        NT::MatrixT<double>{{1, 2}, {3, 4}, {5, 6}} * NT::MatrixT<double>{{35, 44}, {44, 56}}));
+
+    // views, compound and NoAlias assignments
+    ColMajor matCopy = matColA;
+    matColA.Block(5, 7, 30, 35) = matA.Block(0, 0, 30, 60) * matB;
+    TEST_CHECK_STAGE(EqualsElementwise(matColA.Block(5, 7, 30, 35), matExpected.Block(0, 0, 30, 35)));
+    TEST_CHECK_STAGE(EqualsElementwise(matColA.Block(0, 0, 5, 60), matCopy.Block(0, 0, 5, 60)));
+    matColA = matCopy;
+    NT::NoAlias(matColA.ColView(3)) += matCopy.Block(0, 0, 45, 60) * matB.ColView(0);
+    TEST_CHECK_STAGE(EqualsElementwise(matColA.ColView(3), matCopy.ColView(3) + matCopy * matB.ColView(0)));
+    matColA = matCopy;
+    NT::NoAlias(matColA.Block(0, 0, 45, 35)) -= matA * matColB;
+    TEST_CHECK_STAGE(EqualsElementwise(matColA.Block(0, 0, 45, 35), matCopy.Block(0, 0, 45, 35) - matExpected));
+    ColMajor matSquare = RandomMatrix<double>(30, 30, 34);
+    const NT::MatrixT<double> matSquareRow = matSquare;
+    matSquare += NT::Transpose(matSquare);
+    TEST_CHECK_STAGE(EqualsElementwise(matSquare, matSquareRow + NT::Transpose(matSquareRow)));
+    matSquare -= NT::Transpose(matSquareRow) + matSquareRow;
+    TEST_CHECK_STAGE(EqualsElementwise(matSquare, NT::MatrixT<double>(30, 30)));
+    return TEST_SUCCESS;
+}
+
+
 int main()
 {
     static_assert(NT::is_multiplicable<double, float>::value, "");
@@ -36,6 +551,18 @@ int main()
 
 
 	TEST_VERIFY(MatrixTest());
+    TEST_VERIFY(MT_test_product<double>());
+    TEST_VERIFY(MT_test_product<float>());
+    TEST_VERIFY(MT_test_product<int>());
+    TEST_VERIFY(MT_test_mixed_product());
+    TEST_VERIFY(MT_test_nested_product());
+    TEST_VERIFY(MT_test_linear_assign());
+    TEST_VERIFY(MT_test_parallel_assign());
+    TEST_VERIFY(MT_test_fixed_size());
+    TEST_VERIFY(MT_test_aligned_layout());
+    TEST_VERIFY(MT_test_views());
+    TEST_VERIFY(MT_test_compound_assign());
+    TEST_VERIFY(MT_test_storage_order());
 
     std::cout << '\n' << NickSV::Tools::Testing::TestsFailed << " subtests failed\n";
 
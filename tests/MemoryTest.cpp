@@ -13,6 +13,7 @@
 
 #include <memory>
 #include <sstream>
+#include <vector>
 
 
 #include "NickSV/Tools/Definitions.h"
@@ -345,6 +346,24 @@ static E adv(char, void*, E&)
 }
 
 
+template<size_t alignment>
+static int AlignedAllocator_test()
+{
+	for (size_t size : {1, 3, 100, 4097})
+	{
+		std::vector<double, NT::AlignedAllocator<double, alignment>> vecData(size, 1.5);
+		TEST_CHECK_STAGE(reinterpret_cast<uintptr_t>(vecData.data()) % alignment == 0);
+		vecData.push_back(2.5);
+		TEST_CHECK_STAGE(reinterpret_cast<uintptr_t>(vecData.data()) % alignment == 0);
+		TEST_CHECK_STAGE(vecData.front() == 1.5 && vecData.back() == 2.5);
+	}
+	using CharAllocator = typename std::allocator_traits<NT::AlignedAllocator<double, alignment>>::template rebind_alloc<char>;
+	static_assert(std::is_same<CharAllocator, NT::AlignedAllocator<char, alignment>>::value, "");
+	TEST_CHECK_STAGE((CharAllocator() == NT::AlignedAllocator<double, alignment>()));
+	return TEST_SUCCESS;
+}
+
+
 int main()
 {
 	TEST_VERIFY(NotNull_unspec_type_test());
@@ -363,6 +382,9 @@ int main()
 	TEST_VERIFY((NotNull_smart_moveonly_test<std::unique_ptr<int>, 1337>()))
 	TEST_VERIFY((NotNullHash_smart_test<std::unique_ptr<int>, 1337>()))
 
+	TEST_VERIFY(AlignedAllocator_test<64>());
+	TEST_VERIFY(AlignedAllocator_test<4096>());
+
     std::cout << '\n' << NickSV::Tools::Testing::TestsFailed << " subtests failed\n";
 
     return NT::Testing::TestsFailed;
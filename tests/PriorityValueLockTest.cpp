@@ -0,0 +1,120 @@
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <mutex>
+
+
+#define TEST_IGNORE_PRINT_ON_SUCCESS
+
+#define TEST_SETW_VALUE 65
+
+#include "NickSV/Tools/PriorityValueLock.h"
+#include "NickSV/Tools/Testing.h"
+
+
+using PVLock = NickSV::Tools::PriorityValueLock<uint32_t>;
+
+
+// Starts thread that locks value with priority and
+// records its order, returns when the thread is queued
+static std::thread StartWaiter(PVLock& vLock, int32_t priority,
+    std::mutex& orderMutex, std::vector<int32_t>& order)
+{
+    std::thread waiter([&vLock, priority, &orderMutex, &order]
+    {
+        vLock.Lock(1, priority);
+        {
+            std::lock_guard<std::mutex> lockGuard(orderMutex);
+            order.push_back(priority);
+        }
+        vLock.Unlock(1);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    return waiter;
+}
+
+static int PVL_test_priority_order()
+{
+    PVLock vLock(std::chrono::hours(1));
+    std::mutex orderMutex;
+    std::vector<int32_t> order;
+    vLock.Lock(1);
+    std::vector<std::thread> waiters;
+    for (int32_t priority: {0, 5, 1, 5, 10})
+        waiters.push_back(StartWaiter(vLock, priority, orderMutex, order));
+    vLock.Unlock(1);
+    for (auto& waiter : waiters)
+        waiter.join();
+    TEST_CHECK_STAGE((order == std::vector<int32_t>{10, 5, 5, 1, 0}));
+    return TEST_SUCCESS;
+}
+
+static int PVL_test_aging()
+{
+    PVLock vLock(std::chrono::milliseconds(10));
+    std::mutex orderMutex;
+    std::vector<int32_t> order;
+    vLock.Lock(1);
+    std::thread oldWaiter = StartWaiter(vLock, 0, orderMutex, order);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    // old waiter is aged by ~10 levels
+    std::thread newWaiter = StartWaiter(vLock, 3, orderMutex, order);
+    vLock.Unlock(1);
+    oldWaiter.join();
+    newWaiter.join();
+    TEST_CHECK_STAGE((order == std::vector<int32_t>{0, 3}));
+    return TEST_SUCCESS;
+}
+
+static int PVL_test_try_lock_for()
+{
+    PVLock vLock;
+    vLock.Lock(1);
+    TEST_CHECK_STAGE(!vLock.TryLock(1));
+    TEST_CHECK_STAGE(vLock.TryLock(2));
+    std::atomic<bool> isLocked{true};
+    std::thread waiter([&]{ isLocked = vLock.TryLockFor(1, std::chrono::milliseconds(20)); });
+    waiter.join();
+    TEST_CHECK_STAGE(!isLocked);
+    waiter = std::thread([&]
+    {
+        isLocked = vLock.TryLockFor(1, std::chrono::seconds(10), 3);
+        if(isLocked)
+            vLock.Unlock(1);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    vLock.Unlock(1);
+    waiter.join();
+    TEST_CHECK_STAGE(isLocked);
+    vLock.Unlock(2);
+
+    vLock.LockAll();
+    TEST_CHECK_STAGE(!vLock.TryLockFor(3, std::chrono::milliseconds(10)));
+    vLock.UnlockAll(3);
+    TEST_CHECK_STAGE(!vLock.TryLock(3));
+    {
+        NickSV::Tools::ValueLockGuard<PVLock> lockGuard(vLock, 4);
+        TEST_CHECK_STAGE(!vLock.TryLock(4));
+    }
+    vLock.Unlock(3);
+    TEST_CHECK_STAGE(vLock.TryLock(3));
+    vLock.Unlock(3);
+    return TEST_SUCCESS;
+}
+
+
+int main()
+{
+    using namespace NickSV::Tools;
+
+    TEST_VERIFY(PVL_test_priority_order());
+    //
+    TEST_VERIFY(PVL_test_aging());
+    //
+    TEST_VERIFY(PVL_test_try_lock_for());
+
+    std::cout << '\n' << Testing::TestsFailed << " subtests failed\n";
+
+    return Testing::TestsFailed;
+}
@@ -0,0 +1,106 @@
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <random>
+
+
+#define TEST_IGNORE_PRINT_ON_SUCCESS
+
+#define TEST_SETW_VALUE 65
+
+#include "NickSV/Tools/ResizableValueLock.h"
+#include "NickSV/Tools/Testing.h"
+
+
+constexpr static size_t threadC = 16;
+constexpr static uint32_t valueC = 32;
+
+using RVLock = NickSV::Tools::ResizableValueLock<uint32_t>;
+
+
+static int RVL_test_grow_shrink()
+{
+    RVLock vLock(2);
+    TEST_CHECK_STAGE(vLock.SlotCapacity() == 2);
+    for (uint32_t value = 0; value < 7; ++value)
+        vLock.Lock(value);
+    TEST_CHECK_STAGE(vLock.SlotCapacity() == 8);
+    TEST_CHECK_STAGE(vLock.SlotsInUse() == 7);
+    TEST_CHECK_STAGE(vLock.SlotHighWater() == 7);
+    // tables of 2 and 4 slots still hold values
+    TEST_CHECK_STAGE(vLock.RetiredTables() == 2);
+    TEST_CHECK_STAGE(!vLock.TryLock(0));
+    TEST_CHECK_STAGE(!vLock.TryLock(3));
+
+    for (uint32_t value = 0; value < 7; ++value)
+        vLock.Unlock(value);
+    TEST_CHECK_STAGE(vLock.SlotsInUse() == 0);
+    TEST_CHECK_STAGE(vLock.RetiredTables() == 0);
+    // Unlock() doesn't allocate a smaller table
+    TEST_CHECK_STAGE(vLock.SlotCapacity() == 8);
+    vLock.ShrinkToFit();
+    TEST_CHECK_STAGE(vLock.SlotCapacity() == 2);
+    TEST_CHECK_STAGE(vLock.SlotHighWater() == 7);
+
+    vLock.Reserve(64);
+    TEST_CHECK_STAGE(vLock.SlotCapacity() == 64);
+    TEST_CHECK_STAGE(vLock.TryLock(0));
+    // idle table shrinks on the next lock
+    TEST_CHECK_STAGE(vLock.SlotCapacity() == 32);
+    vLock.Unlock(0);
+
+    vLock.LockAll();
+    TEST_CHECK_STAGE(!vLock.TryLock(1));
+    vLock.UnlockAll(1);
+    TEST_CHECK_STAGE(!vLock.TryLock(1));
+    TEST_CHECK_STAGE(vLock.TryLock(2));
+    vLock.Unlock(1);
+    vLock.Unlock(2);
+    return TEST_SUCCESS;
+}
+
+static int RVL_test_resize_under_load()
+{
+    RVLock vLock(1);
+    std::vector<uint32_t> vecOwners(valueC, 0);
+    std::atomic<uint32_t> errors{0};
+    std::vector<std::thread> threads;
+    for (uint32_t th = 1; th <= threadC; ++th)
+        threads.emplace_back([&, th]
+        {
+            std::mt19937 gen(th);
+            std::uniform_int_distribution<uint32_t> dist(0, valueC - 1);
+            for (size_t i = 0; i < 5000; ++i)
+            {
+                uint32_t value = dist(gen);
+                NickSV::Tools::ValueLockGuard<RVLock> lockGuard(vLock, value);
+                if(vecOwners[value]) ++errors;
+                vecOwners[value] = th;
+                std::this_thread::yield();
+                if(vecOwners[value] != th) ++errors;
+                vecOwners[value] = 0;
+            }
+        });
+    for (auto& thread : threads)
+        thread.join();
+    TEST_CHECK_STAGE(errors == 0);
+    TEST_CHECK_STAGE(vLock.SlotsInUse() == 0);
+    TEST_CHECK_STAGE(vLock.RetiredTables() == 0);
+    TEST_CHECK_STAGE(vLock.SlotHighWater() > 1 && vLock.SlotHighWater() <= threadC);
+    return TEST_SUCCESS;
+}
+
+
+int main()
+{
+    using namespace NickSV::Tools;
+
+    TEST_VERIFY(RVL_test_grow_shrink());
+    //
+    TEST_VERIFY(RVL_test_resize_under_load());
+
+    std::cout << '\n' << Testing::TestsFailed << " subtests failed\n";
+
+    return Testing::TestsFailed;
+}
@@ -0,0 +1,115 @@
+#include <iostream>
+#include <atomic>
+#include <vector>
+#include <stdexcept>
+#include <set>
+#include <mutex>
+#include <thread>
+#include <chrono>
+
+
+#define TEST_IGNORE_PRINT_ON_SUCCESS
+
+#define TEST_SETW_VALUE 65
+
+#include "NickSV/Tools/ThreadPool.h"
+#include "NickSV/Tools/Testing.h"
+
+
+constexpr static size_t taskC = 1000;
+
+
+static int TP_test_parallel_for()
+{
+    NickSV::Tools::ThreadPool pool(3);
+    TEST_CHECK_STAGE(pool.Size() == 3);
+
+    // pool is reused, every index is called exactly once each time
+    for (size_t run = 0; run < 50; ++run)
+    {
+        std::vector<std::atomic<uint32_t>> vecCalls(taskC);
+        for (auto& calls : vecCalls)
+            calls = 0;
+        pool.ParallelFor(taskC, [&](size_t index) noexcept { ++vecCalls[index]; });
+        bool isEachOnce = true;
+        for (auto& calls : vecCalls)
+            isEachOnce = isEachOnce && calls == 1;
+        TEST_CHECK_STAGE(isEachOnce);
+    }
+
+    NickSV::Tools::ThreadPool emptyPool(0);
+    size_t count = 0;
+    emptyPool.ParallelFor(taskC, [&](size_t) noexcept { ++count; });
+    TEST_CHECK_STAGE(count == taskC);
+    return TEST_SUCCESS;
+}
+
+static int TP_test_nested()
+{
+    NickSV::Tools::ThreadPool pool(2);
+    std::atomic<size_t> count{0};
+    pool.ParallelFor(8, [&](size_t)
+    {
+        // pool is busy, runs in this thread
+        pool.ParallelFor(8, [&](size_t) noexcept { ++count; });
+    });
+    TEST_CHECK_STAGE(count == 64);
+
+    // pool is released after nested calls, workers take tasks again
+    std::mutex mtx;
+    std::set<std::thread::id> setThreads;
+    pool.ParallelFor(8, [&](size_t)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        std::lock_guard<std::mutex> lockGuard(mtx);
+        setThreads.insert(std::this_thread::get_id());
+    });
+    TEST_CHECK_STAGE(setThreads.size() > 1);
+    return TEST_SUCCESS;
+}
+
+static int TP_test_exception()
+{
+#if NICKSV_EXCEPTIONS
+    NickSV::Tools::ThreadPool pool(3);
+    std::atomic<size_t> count{0};
+    bool isThrown = false;
+    try
+    {
+        pool.ParallelFor(taskC, [&](size_t index)
+        {
+            ++count;
+            if(index % 100 == 7)
+                throw std::runtime_error("task");
+        });
+    }
+    catch(const std::runtime_error&)
+    {
+        isThrown = true;
+    }
+    TEST_CHECK_STAGE(isThrown);
+    TEST_CHECK_STAGE(count == taskC);
+
+    // pool still works after exception
+    count = 0;
+    pool.ParallelFor(taskC, [&](size_t) noexcept { ++count; });
+    TEST_CHECK_STAGE(count == taskC);
+#endif
+    return TEST_SUCCESS;
+}
+
+
+int main()
+{
+    using namespace NickSV::Tools;
+
+    TEST_VERIFY(TP_test_parallel_for());
+    //
+    TEST_VERIFY(TP_test_nested());
+    //
+    TEST_VERIFY(TP_test_exception());
+
+    std::cout << '\n' << Testing::TestsFailed << " subtests failed\n";
+
+    return Testing::TestsFailed;
+}
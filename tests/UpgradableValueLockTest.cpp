@@ -0,0 +1,130 @@
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <vector>
+
+
+#define TEST_IGNORE_PRINT_ON_SUCCESS
+
+#define TEST_SETW_VALUE 65
+
+#include "NickSV/Tools/UpgradableValueLock.h"
+#include "NickSV/Tools/Testing.h"
+
+
+constexpr static size_t threadC = 8;
+
+using UVLock = NickSV::Tools::UpgradableValueLock<uint32_t>;
+
+
+static int UVL_test_modes()
+{
+    UVLock vLock;
+    vLock.LockShared(1);
+    TEST_CHECK_STAGE(vLock.TryLockShared(1));
+    TEST_CHECK_STAGE(vLock.TryLockUpgradable(1));
+    TEST_CHECK_STAGE(!vLock.TryLockUpgradable(1)); // one upgrader per value
+    TEST_CHECK_STAGE(!vLock.TryLock(1));
+    TEST_CHECK_STAGE(vLock.TryLock(2));
+    vLock.UnlockShared(1);
+    vLock.UnlockShared(1);
+
+    vLock.UpgradeToExclusive(1); // no readers left
+    TEST_CHECK_STAGE(!vLock.TryLockShared(1));
+    vLock.Downgrade(1);
+    TEST_CHECK_STAGE(vLock.TryLockShared(1));
+    TEST_CHECK_STAGE(!vLock.TryLockUpgradable(1));
+    vLock.UnlockShared(1);
+    vLock.UnlockUpgradable(1);
+    vLock.Unlock(2);
+
+    vLock.LockAll();
+    TEST_CHECK_STAGE(!vLock.TryLockShared(3));
+    vLock.UnlockAll(3);
+    TEST_CHECK_STAGE(!vLock.TryLockShared(3));
+    TEST_CHECK_STAGE(vLock.TryLockShared(4));
+    vLock.Unlock(3);
+    vLock.UnlockShared(4);
+    TEST_CHECK_STAGE(vLock.TryLock(3));
+    vLock.Unlock(3);
+    return TEST_SUCCESS;
+}
+
+static int UVL_test_upgrade_waits_readers()
+{
+    UVLock vLock;
+    std::atomic<bool> readerDone{false};
+    vLock.LockShared(1);
+    vLock.LockUpgradable(1);
+    std::thread reader([&]
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        readerDone = true;
+        vLock.UnlockShared(1);
+    });
+    vLock.UpgradeToExclusive(1);
+    TEST_CHECK_STAGE(readerDone);
+    reader.join();
+    // pending upgrade is over, value is exclusive now
+    TEST_CHECK_STAGE(!vLock.TryLockShared(1));
+    vLock.Unlock(1);
+    return TEST_SUCCESS;
+}
+
+static int UVL_test_read_decide_write()
+{
+    using namespace NickSV::Tools;
+    UVLock vLock;
+    uint32_t counter = 0;
+    std::atomic<uint32_t> upgrades{0};
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < threadC; ++i)
+        threads.emplace_back([&]
+        {
+            for (size_t j = 0; j < 1000; ++j)
+            {
+                if(j % 2)
+                {
+                    SharedValueLockGuard<UVLock> lockGuard(vLock, 1);
+                    (void)counter;
+                    continue;
+                }
+                UpgradableValueLockGuard<UVLock> lockGuard(vLock, 1);
+                if(counter % 2 == 0)
+                {
+                    lockGuard.Upgrade();
+                    ++counter;
+                    lockGuard.Downgrade();
+                    ++upgrades;
+                }
+                else
+                {
+                    lockGuard.Upgrade();
+                    ++counter;
+                }
+            }
+        });
+    for (auto& th : threads)
+        th.join();
+    TEST_CHECK_STAGE(counter == threadC * 500);
+    TEST_CHECK_STAGE(upgrades == threadC * 250);
+    TEST_CHECK_STAGE(vLock.TryLock(1));
+    vLock.Unlock(1);
+    return TEST_SUCCESS;
+}
+
+
+int main()
+{
+    using namespace NickSV::Tools;
+
+    TEST_VERIFY(UVL_test_modes());
+    //
+    TEST_VERIFY(UVL_test_upgrade_waits_readers());
+    //
+    TEST_VERIFY(UVL_test_read_decide_write());
+
+    std::cout << '\n' << Testing::TestsFailed << " subtests failed\n";
+
+    return Testing::TestsFailed;
+}
@@ -0,0 +1,106 @@
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <vector>
+
+
+#define TEST_IGNORE_PRINT_ON_SUCCESS
+
+#define TEST_SETW_VALUE 65
+
+#include "NickSV/Tools/ValueLockMonitor.h"
+#include "NickSV/Tools/Testing.h"
+
+
+constexpr static size_t slotC = 4;
+
+
+template<class LockT>
+int VLM_test_held_values()
+{
+    LockT vLock;
+    TEST_CHECK_STAGE(vLock.HeldValues().empty());
+    TEST_CHECK_STAGE(!vLock.IsLocked(1));
+
+    vLock.Lock(1);
+    std::thread waiter([&vLock]{ vLock.Lock(1); vLock.Unlock(1); });
+    while(vLock.HeldValues().at(0).Waiters == 0)
+        std::this_thread::yield();
+
+    auto vecHeld = vLock.HeldValues();
+    TEST_CHECK_STAGE(vecHeld.size() == 1);
+    TEST_CHECK_STAGE(vecHeld[0].Value == 1);
+    TEST_CHECK_STAGE(vecHeld[0].RefCount == 2);
+    TEST_CHECK_STAGE(vecHeld[0].Locked);
+    TEST_CHECK_STAGE(vecHeld[0].LockedSince <= std::chrono::steady_clock::now());
+    TEST_CHECK_STAGE(vLock.IsLocked(1));
+    TEST_CHECK_STAGE(!vLock.IsLocked(2));
+
+    vLock.Unlock(1);
+    waiter.join();
+    TEST_CHECK_STAGE(vLock.HeldValues().empty());
+    TEST_CHECK_STAGE(!vLock.IsLocked(1));
+
+    TEST_CHECK_STAGE(vLock.TryLock(3));
+    TEST_CHECK_STAGE(vLock.IsLocked(3));
+    vLock.Unlock(3);
+    return TEST_SUCCESS;
+}
+
+template<class LockT>
+int VLM_test_stuck_detector()
+{
+    using namespace NickSV::Tools;
+    LockT vLock;
+    std::atomic<uint32_t> reported{0};
+    std::atomic<uint32_t> reportedValue{0};
+    StuckValueDetector<LockT> detector(vLock, std::chrono::milliseconds(20),
+        [&](const typename LockT::HeldValue& held, std::chrono::steady_clock::duration heldFor)
+        {
+            reportedValue = held.Value;
+            if(heldFor >= std::chrono::milliseconds(20))
+                ++reported;
+        });
+
+    vLock.Lock(7);
+    vLock.Lock(8);
+    TEST_CHECK_STAGE(detector.CheckOnce() == 0);
+    vLock.Unlock(8);
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    TEST_CHECK_STAGE(detector.CheckOnce() == 1);
+    TEST_CHECK_STAGE(reported == 1 && reportedValue == 7);
+    // Same hold is not reported twice
+    TEST_CHECK_STAGE(detector.CheckOnce() == 1);
+    TEST_CHECK_STAGE(reported == 1);
+    vLock.Unlock(7);
+    TEST_CHECK_STAGE(detector.CheckOnce() == 0);
+
+    vLock.Lock(9);
+    detector.Start(std::chrono::milliseconds(5));
+    while_limit(reported != 2, 1000)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    detector.Stop();
+    TEST_CHECK_STAGE(reported == 2 && reportedValue == 9);
+    vLock.Unlock(9);
+    return TEST_SUCCESS;
+}
+
+
+int main()
+{
+    using namespace NickSV::Tools;
+
+    typedef ValueLock<uint32_t, slotC> Value_Lock;
+
+    TEST_VERIFY(VLM_test_held_values<Value_Lock>());
+    //
+    TEST_VERIFY(VLM_test_held_values<DynamicValueLock<uint32_t>>());
+    //
+    TEST_VERIFY(VLM_test_stuck_detector<Value_Lock>());
+    //
+    TEST_VERIFY(VLM_test_stuck_detector<DynamicValueLock<uint32_t>>());
+
+    std::cout << '\n' << Testing::TestsFailed << " subtests failed\n";
+
+    return Testing::TestsFailed;
+}
@@ -4,6 +4,8 @@
 #include <thread>
 #include <utility>
 #include <unordered_set>
+#include <atomic>
+#include <chrono>
 
 
 #define TEST_IGNORE_PRINT_ON_SUCCESS
@@ -282,6 +284,238 @@ int VL_test_all2()
 }
 
 
+static int DVL_test_wait_for()
+{
+	using namespace std::chrono;
+    NickSV::Tools::DynamicValueLock<uint32_t> vLock;
+    const uint32_t value = 1, otherValue = 2;
+    bool ready = false, otherReady = false;
+    std::atomic<int> woken{0};
+    std::thread waiter([&]()
+    {
+        NickSV::Tools::ValueLockGuard<decltype(vLock)> vLockGuard(vLock, value);
+        vLock.WaitFor(value, [&ready]{ return ready; });
+        ++woken;
+    });
+    std::thread otherWaiter([&]()
+    {
+        NickSV::Tools::ValueLockGuard<decltype(vLock)> vLockGuard(vLock, otherValue);
+        vLock.WaitFor(otherValue, [&otherReady]{ return otherReady; });
+        ++woken;
+    });
+    std::this_thread::sleep_for(milliseconds(50));
+    {
+        // waiter released value while waiting
+        TEST_CHECK_STAGE(vLock.TryLock(value));
+        ready = true;
+        vLock.NotifyValue(value);
+        vLock.Unlock(value);
+    }
+    waiter.join();
+    std::this_thread::sleep_for(milliseconds(20));
+    TEST_CHECK_STAGE(woken == 1);
+    {
+        NickSV::Tools::ValueLockGuard<decltype(vLock)> vLockGuard(vLock, otherValue);
+        otherReady = true;
+        vLock.NotifyValue(otherValue);
+    }
+    otherWaiter.join();
+    TEST_CHECK_STAGE(woken == 2);
+
+    vLock.Lock(value);
+    TEST_CHECK_STAGE(!vLock.WaitFor(value, milliseconds(10), []{ return false; }));
+    vLock.Unlock(value);
+    return TEST_SUCCESS;
+}
+
+static int VL_test_recursive()
+{
+    using RecursiveLock = NickSV::Tools::ValueLock<uint32_t, threadC, NickSV::Tools::RecursiveValueLockPolicy>;
+    RecursiveLock vLock;
+    vLock.Lock(1);
+    vLock.Lock(1);
+    TEST_CHECK_STAGE(vLock.TryLock(1));
+    std::atomic<bool> otherLocked{false};
+    std::thread other([&]
+    {
+        otherLocked = vLock.TryLock(1);
+        if(otherLocked)
+            vLock.Unlock(1);
+    });
+    other.join();
+    TEST_CHECK_STAGE(!otherLocked);
+    vLock.Unlock(1);
+    vLock.Unlock(1);
+    TEST_CHECK_STAGE(vLock.IsLocked(1));
+    vLock.Unlock(1);
+    TEST_CHECK_STAGE(!vLock.IsLocked(1));
+    other = std::thread([&]
+    {
+        otherLocked = vLock.TryLock(1);
+        if(otherLocked)
+            vLock.Unlock(1);
+    });
+    other.join();
+    TEST_CHECK_STAGE(otherLocked);
+
+    vLock.LockAll();
+    vLock.UnlockAll(2);
+    vLock.Lock(2);
+    vLock.Unlock(2);
+    TEST_CHECK_STAGE(vLock.IsLocked(2));
+    vLock.Unlock(2);
+    TEST_CHECK_STAGE(!vLock.IsLocked(2));
+
+    // More held values than the thread keeps track of
+    NickSV::Tools::ValueLock<uint32_t, 20, NickSV::Tools::RecursiveValueLockPolicy> wideLock;
+    for (uint32_t value = 0; value < 20; ++value)
+        wideLock.Lock(value);
+    bool isReentered = true;
+    for (uint32_t value = 0; value < 20; ++value)
+        isReentered = wideLock.TryLock(value) && isReentered;
+    TEST_CHECK_STAGE(isReentered);
+    for (uint32_t value = 0; value < 20; ++value)
+    {
+        wideLock.Unlock(value);
+        wideLock.Unlock(value);
+    }
+    for (uint32_t value = 0; value < 20; ++value)
+        isReentered = !wideLock.IsLocked(value) && isReentered;
+    TEST_CHECK_STAGE(isReentered);
+    wideLock.Lock(5);
+    TEST_CHECK_STAGE(wideLock.TryLock(5));
+    wideLock.Unlock(5);
+    wideLock.Unlock(5);
+    TEST_CHECK_STAGE(!wideLock.IsLocked(5));
+    return TEST_SUCCESS;
+}
+
+
+static int VL_test_no_throw()
+{
+    using namespace NickSV::Tools;
+    using SmallLock = ValueLock<uint32_t, 2>;
+    using RecursiveLock = ValueLock<uint32_t, 2, RecursiveValueLockPolicy>;
+    SmallLock vLock;
+    TEST_CHECK_STAGE(vLock.LockNoThrow(1) == ValueLockStatus::Ok);
+    TEST_CHECK_STAGE(vLock.TryLockNoThrow(2) == ValueLockStatus::Ok);
+    std::vector<ValueLockStatus> otherStatus;
+    bool isThrown = false;
+    std::thread other([&]
+    {
+        otherStatus.push_back(vLock.TryLockNoThrow(1));
+        otherStatus.push_back(vLock.TryLockNoThrow(3));
+        otherStatus.push_back(vLock.LockNoThrow(3));
+        otherStatus.push_back(vLock.UnlockNoThrow(3));
+        ValueLockGuard<SmallLock> lockGuard(vLock, 2, std::try_to_lock);
+        otherStatus.push_back(lockGuard.Status());
+        try { vLock.Lock(3); }
+        catch(const std::runtime_error&) { isThrown = true; }
+    });
+    other.join();
+    TEST_CHECK_STAGE((otherStatus == std::vector<ValueLockStatus>{ValueLockStatus::WouldBlock,
+        ValueLockStatus::SlotsExhausted, ValueLockStatus::SlotsExhausted,
+        ValueLockStatus::NotLocked, ValueLockStatus::WouldBlock}));
+    TEST_CHECK_STAGE(isThrown);
+    TEST_CHECK_STAGE(vLock.UnlockNoThrow(1) == ValueLockStatus::Ok);
+    TEST_CHECK_STAGE(vLock.UnlockNoThrow(1) == ValueLockStatus::NotLocked);
+    {
+        ValueLockGuard<SmallLock> lockGuard(vLock, 3, std::try_to_lock);
+        TEST_CHECK_STAGE(lockGuard.OwnsLock());
+        TEST_CHECK_STAGE(vLock.IsLocked(3));
+    }
+    TEST_CHECK_STAGE(!vLock.IsLocked(3));
+    TEST_CHECK_STAGE(vLock.UnlockNoThrow(2) == ValueLockStatus::Ok);
+
+    RecursiveLock recursiveLock;
+    TEST_CHECK_STAGE(recursiveLock.LockNoThrow(1) == ValueLockStatus::Ok);
+    TEST_CHECK_STAGE(recursiveLock.TryLockNoThrow(1) == ValueLockStatus::Ok);
+    ValueLockStatus otherCallStatus = ValueLockStatus::Ok;
+    other = std::thread([&]() noexcept { otherCallStatus = recursiveLock.UnlockNoThrow(1); });
+    other.join();
+    TEST_CHECK_STAGE(otherCallStatus == ValueLockStatus::NotLocked);
+    TEST_CHECK_STAGE(recursiveLock.UnlockNoThrow(1) == ValueLockStatus::Ok);
+    TEST_CHECK_STAGE(recursiveLock.UnlockNoThrow(1) == ValueLockStatus::Ok);
+    TEST_CHECK_STAGE(recursiveLock.UnlockNoThrow(1) == ValueLockStatus::NotLocked);
+
+    DynamicValueLock<uint32_t> dynamicLock;
+    TEST_CHECK_STAGE(dynamicLock.LockNoThrow(1) == ValueLockStatus::Ok);
+    other = std::thread([&]() noexcept { otherCallStatus = dynamicLock.TryLockNoThrow(1); });
+    other.join();
+    TEST_CHECK_STAGE(otherCallStatus == ValueLockStatus::WouldBlock);
+    TEST_CHECK_STAGE(dynamicLock.UnlockNoThrow(1) == ValueLockStatus::Ok);
+    TEST_CHECK_STAGE(dynamicLock.UnlockNoThrow(1) == ValueLockStatus::NotLocked);
+
+    // Pending LockAll() makes TryLockNoThrow() fail, not wait
+    dynamicLock.Lock(1);
+    std::thread lockerAll([&]() noexcept
+    {
+        dynamicLock.LockAll();
+        dynamicLock.UnlockAll();
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    std::atomic<bool> isTried{false};
+    other = std::thread([&]() noexcept
+    {
+        otherCallStatus = dynamicLock.TryLockNoThrow(2);
+        isTried = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    const bool isTriedDuringLockAll = isTried;
+    dynamicLock.Unlock(1);
+    lockerAll.join();
+    other.join();
+    if(otherCallStatus == ValueLockStatus::Ok)
+        dynamicLock.Unlock(2);
+    TEST_CHECK_STAGE(isTriedDuringLockAll);
+    TEST_CHECK_STAGE(otherCallStatus == ValueLockStatus::WouldBlock);
+    return TEST_SUCCESS;
+}
+
+
+// Slots remembered by a thread must be revalidated
+// after other values and other threads reuse them
+static int VL_test_slot_hints()
+{
+    using SmallLock = NickSV::Tools::ValueLock<uint32_t, 2>;
+    SmallLock vLock, otherLock;
+    for (uint32_t value = 1; value <= 3; ++value)
+    {
+        vLock.Lock(value);
+        otherLock.Lock(value + 10);
+        otherLock.Unlock(value + 10);
+        vLock.Unlock(value);
+    }
+    vLock.Lock(1);
+    std::atomic<bool> isLocked{true};
+    std::thread other([&]
+    {
+        isLocked = vLock.TryLock(1);
+        if(!vLock.TryLock(2))
+            return;
+        vLock.Unlock(2);
+        vLock.Lock(3);
+        vLock.Unlock(3);
+    });
+    other.join();
+    TEST_CHECK_STAGE(!isLocked);
+    TEST_CHECK_STAGE(vLock.IsLocked(1));
+    TEST_CHECK_STAGE(!vLock.IsLocked(2));
+    TEST_CHECK_STAGE(!vLock.IsLocked(3));
+    TEST_CHECK_STAGE(!otherLock.IsLocked(11));
+    vLock.Unlock(1);
+    TEST_CHECK_STAGE(!vLock.IsLocked(1));
+    for (uint32_t value = 1; value <= 2; ++value)
+    {
+        TEST_CHECK_STAGE(vLock.TryLock(value));
+    }
+    TEST_CHECK_STAGE(vLock.TryLockNoThrow(3) == NickSV::Tools::ValueLockStatus::SlotsExhausted);
+    vLock.Unlock(1);
+    vLock.Unlock(2);
+    return TEST_SUCCESS;
+}
+
+
 int main()
 {
     using namespace NickSV::Tools;
@@ -296,6 +530,7 @@ int main()
     TEST_VERIFY(CheckTracingTest(testTracer));
 
     typedef ValueLock<uint32_t, threadC> Value_Lock;
+    typedef ValueLock<uint32_t, threadC, RecursiveValueLockPolicy> Recursive_Value_Lock;
 
     TEST_VERIFY(VL_test_same_v<Value_Lock>());
     //
@@ -318,6 +553,16 @@ int main()
     TEST_VERIFY(VL_test_all2<Value_Lock>());
     //
     TEST_VERIFY(VL_test_all2<DynamicValueLock<uint32_t>>());
+    //
+    TEST_VERIFY(DVL_test_wait_for());
+    //
+    TEST_VERIFY(VL_test_rand_v<Recursive_Value_Lock>());
+    //
+    TEST_VERIFY(VL_test_recursive());
+    //
+    TEST_VERIFY(VL_test_no_throw());
+    //
+    TEST_VERIFY(VL_test_slot_hints());
     
     std::cout << '\n' << Testing::TestsFailed << " subtests failed\n";
     
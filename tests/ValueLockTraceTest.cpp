@@ -0,0 +1,271 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+#define TEST_IGNORE_PRINT_ON_SUCCESS
+
+#define TEST_SETW_VALUE 65
+
+#include "NickSV/Tools/ValueLockTrace.h"
+#include "NickSV/Tools/PriorityValueLock.h"
+#include "NickSV/Tools/HierarchicalValueLock.h"
+#include "NickSV/Tools/UpgradableValueLock.h"
+#include "NickSV/Tools/IntervalValueLock.h"
+#include "NickSV/Tools/Testing.h"
+
+
+using namespace NickSV::Tools;
+
+
+static size_t CountOf(const std::string& text, const std::string& pattern)
+{
+    size_t count = 0;
+    for (auto pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1))
+        ++count;
+    return count;
+}
+
+static int VLT_test_events()
+{
+    ValueLockTracer tracer;
+    TracedValueLock<ValueLock<uint32_t, 4>> vLock(tracer);
+    vLock.Lock(7);
+    std::thread waiter([&vLock]
+    {
+        ValueLockGuard<decltype(vLock)> lockGuard(vLock, 7);
+    });
+    while(vLock.Inner().HeldValues().at(0).RefCount < 2)
+        std::this_thread::yield();
+    vLock.Unlock(7);
+    waiter.join();
+    TEST_CHECK_STAGE(vLock.TryLock(8));
+    vLock.Unlock(8);
+
+    auto vecEvents = tracer.Events();
+    TEST_CHECK_STAGE(vecEvents.size() == 9);
+    TEST_CHECK_STAGE(std::is_sorted(vecEvents.begin(), vecEvents.end(),
+        [](const ValueLockTraceEvent& lhs, const ValueLockTraceEvent& rhs)
+        { return lhs.TimestampNs < rhs.TimestampNs; }));
+    // waiter acquires only after main thread acquired, Released is
+    // recorded after unlock, so it may come after waiter's Acquired
+    uint64_t mainAcquired = 0, mainReleased = 0, waiterAcquired = 0;
+    for (auto& event : vecEvents)
+    {
+        TEST_CHECK_STAGE(event.LockId == reinterpret_cast<uintptr_t>(&vLock.Inner()));
+        if(event.ValueId != 7)
+            continue;
+        if(event.ThreadIndex == 1 && event.Phase == ValueLockTracePhase::Acquired)
+            mainAcquired = event.TimestampNs;
+        if(event.ThreadIndex == 1 && event.Phase == ValueLockTracePhase::Released)
+            mainReleased = event.TimestampNs;
+        if(event.ThreadIndex == 2 && event.Phase == ValueLockTracePhase::Acquired)
+            waiterAcquired = event.TimestampNs;
+    }
+    TEST_CHECK_STAGE(mainAcquired && mainReleased && waiterAcquired && mainAcquired <= waiterAcquired);
+
+    std::ostringstream out;
+    tracer.WriteChromeTrace(out);
+    auto json = out.str();
+    TEST_CHECK_STAGE(json.find("\"traceEvents\":[") != std::string::npos);
+    TEST_CHECK_STAGE(CountOf(json, "\"thread_name\"") == 2);
+    TEST_CHECK_STAGE(CountOf(json, "\"name\":\"wait\"") == 6);
+    TEST_CHECK_STAGE(CountOf(json, "\"name\":\"hold\"") == 6);
+    TEST_CHECK_STAGE(json.substr(json.size() - 4) == "\n]}\n");
+    return TEST_SUCCESS;
+}
+
+static int VLT_test_ring_buffer()
+{
+    ValueLockTracer tracer(4, false);
+    TracedValueLock<DynamicValueLock<uint32_t>> vLock(tracer);
+    vLock.Lock(1);
+    vLock.Unlock(1);
+    TEST_CHECK_STAGE(tracer.Events().empty());
+    tracer.Enable();
+    for (uint32_t value = 1; value <= 5; ++value)
+    {
+        vLock.Lock(value);
+        vLock.Unlock(value);
+    }
+    auto vecEvents = tracer.Events();
+    TEST_CHECK_STAGE(vecEvents.size() == 4);
+    TEST_CHECK_STAGE(vecEvents.front().ValueId == 4 && vecEvents.front().Phase == ValueLockTracePhase::Released);
+    TEST_CHECK_STAGE(vecEvents.back().ValueId == 5 && vecEvents.back().Phase == ValueLockTracePhase::Released);
+
+    vLock.LockAll();
+    vLock.UnlockAll(9);
+    vLock.Unlock(9);
+    vecEvents = tracer.Events();
+    TEST_CHECK_STAGE(vecEvents.back().ValueId == 9 && vecEvents.back().Phase == ValueLockTracePhase::Released);
+    return TEST_SUCCESS;
+}
+
+static int VLT_test_variants()
+{
+    ValueLockTracer tracer;
+    TracedValueLock<PriorityValueLock<uint32_t>> priorityLock(tracer);
+    priorityLock.Lock(1, 10);
+    TEST_CHECK_STAGE(priorityLock.TryLock(2));
+    priorityLock.Unlock(2);
+    priorityLock.Unlock(1);
+
+    TracedValueLock<HierarchicalValueLock> pathLock(tracer);
+    pathLock.Lock("a/b", HierarchicalLockMode::Shared);
+    pathLock.Unlock("a/b", HierarchicalLockMode::Shared);
+
+    auto vecEvents = tracer.Events();
+    TEST_CHECK_STAGE(vecEvents.size() == 9);
+    TEST_CHECK_STAGE(vecEvents.back().ValueId == details::TraceValueId(std::string("a/b")));
+    TEST_CHECK_STAGE(vecEvents.back().LockId == reinterpret_cast<uintptr_t>(&pathLock.Inner()));
+    return TEST_SUCCESS;
+}
+
+// Thread index 0 means any thread
+static std::vector<ValueLockTracePhase> PhasesOf(const ValueLockTracer& tracer, const void* pLock, uint64_t threadIndex = 0)
+{
+    std::vector<ValueLockTracePhase> vecPhases;
+    for (auto& event : tracer.Events())
+    {
+        if(event.LockId == reinterpret_cast<uintptr_t>(pLock) && (!threadIndex || event.ThreadIndex == threadIndex))
+            vecPhases.push_back(event.Phase);
+    }
+    return vecPhases;
+}
+
+static int VLT_test_modes()
+{
+    using Phase = ValueLockTracePhase;
+    ValueLockTracer tracer;
+
+    TracedValueLock<UpgradableValueLock<uint32_t>> upgradableLock(tracer);
+    upgradableLock.LockShared(1);
+    TEST_CHECK_STAGE(upgradableLock.TryLockShared(1));
+    upgradableLock.UnlockShared(1);
+    upgradableLock.UnlockShared(1);
+    upgradableLock.LockUpgradable(2);
+    upgradableLock.UpgradeToExclusive(2);
+    upgradableLock.Downgrade(2);
+    upgradableLock.UnlockUpgradable(2);
+    TEST_CHECK_STAGE((PhasesOf(tracer, &upgradableLock.Inner()) == std::vector<Phase>{
+        Phase::Request, Phase::Acquired, Phase::Request, Phase::Acquired, Phase::Released, Phase::Released,
+        Phase::Request, Phase::Acquired, Phase::Request, Phase::Released, Phase::Acquired,
+        Phase::Released, Phase::Request, Phase::Acquired, Phase::Released}));
+
+    TracedValueLock<IntervalValueLock<uint32_t>> intervalLock(tracer);
+    intervalLock.LockRange(10, 20);
+    TEST_CHECK_STAGE(!intervalLock.TryLockRange(15, 25));
+    TEST_CHECK_STAGE(intervalLock.TryLockRange(20, 30));
+    intervalLock.UnlockRange(10, 20);
+    intervalLock.UnlockRange(20, 30);
+    TEST_CHECK_STAGE((PhasesOf(tracer, &intervalLock.Inner()) == std::vector<Phase>{
+        Phase::Request, Phase::Acquired, Phase::Request, Phase::Acquired, Phase::Released, Phase::Released}));
+
+    // Timed out wait is closed
+    TracedValueLock<PriorityValueLock<uint32_t>> priorityLock(tracer);
+    priorityLock.Lock(1);
+    std::thread waiter([&priorityLock]() noexcept
+    {
+        if(priorityLock.TryLockFor(1, std::chrono::milliseconds(10), 5))
+            priorityLock.Unlock(1);
+    });
+    waiter.join();
+    priorityLock.Unlock(1);
+    TEST_CHECK_STAGE((PhasesOf(tracer, &priorityLock.Inner()) == std::vector<Phase>{
+        Phase::Request, Phase::Acquired, Phase::Request, Phase::Abandoned, Phase::Released}));
+
+    // So is the wait that threw
+    TracedValueLock<ValueLock<uint32_t, 1>> slotLock(tracer);
+    slotLock.Lock(1);
+    bool isThrown = false;
+    try { slotLock.Lock(2); }
+    catch(const std::runtime_error&) { isThrown = true; }
+    slotLock.Unlock(1);
+    TEST_CHECK_STAGE(isThrown);
+    TEST_CHECK_STAGE((PhasesOf(tracer, &slotLock.Inner()) == std::vector<Phase>{
+        Phase::Request, Phase::Acquired, Phase::Request, Phase::Abandoned, Phase::Released}));
+
+    std::ostringstream out;
+    tracer.WriteChromeTrace(out);
+    auto json = out.str();
+    TEST_CHECK_STAGE(CountOf(json, "\"ph\":\"b\"") == CountOf(json, "\"ph\":\"e\""));
+    return TEST_SUCCESS;
+}
+
+static int VLT_test_no_throw()
+{
+    using Phase = ValueLockTracePhase;
+    ValueLockTracer tracer;
+
+    using TracedLock = TracedValueLock<ValueLock<int, 4>>;
+    TracedLock vLock(tracer);
+    {
+        ValueLockGuard<TracedLock> lockGuard(vLock, 1, std::try_to_lock);
+        TEST_CHECK_STAGE(lockGuard.OwnsLock());
+    }
+    TEST_CHECK_STAGE((PhasesOf(tracer, &vLock.Inner()) == std::vector<Phase>{
+        Phase::Request, Phase::Acquired, Phase::Released}));
+
+    TracedValueLock<ValueLock<uint32_t, 1>> slotLock(tracer);
+    TEST_CHECK_STAGE(slotLock.LockNoThrow(1) == ValueLockStatus::Ok);
+    ValueLockStatus otherStatus = ValueLockStatus::Ok;
+    std::thread other([&]() noexcept { otherStatus = slotLock.LockNoThrow(2); });
+    other.join();
+    TEST_CHECK_STAGE(otherStatus == ValueLockStatus::SlotsExhausted);
+    TEST_CHECK_STAGE(slotLock.TryLockNoThrow(2) == ValueLockStatus::SlotsExhausted);
+    TEST_CHECK_STAGE(slotLock.UnlockNoThrow(3) == ValueLockStatus::NotLocked);
+    TEST_CHECK_STAGE(slotLock.UnlockNoThrow(1) == ValueLockStatus::Ok);
+    TEST_CHECK_STAGE((PhasesOf(tracer, &slotLock.Inner()) == std::vector<Phase>{
+        Phase::Request, Phase::Acquired, Phase::Request, Phase::Abandoned, Phase::Released}));
+
+    // Waiting on value unlocks it until notified
+    TracedValueLock<DynamicValueLock<uint32_t>> dynamicLock(tracer);
+    bool isReady = false;
+    dynamicLock.Lock(1);
+    std::thread waiter([&]() noexcept
+    {
+        dynamicLock.Lock(1);
+        dynamicLock.WaitFor(1, [&isReady]{ return isReady; });
+        dynamicLock.Unlock(1);
+    });
+    dynamicLock.Unlock(1);
+    while(dynamicLock.Inner().HeldValues().empty() || dynamicLock.Inner().HeldValues().at(0).Locked)
+        std::this_thread::yield();
+    dynamicLock.Lock(1);
+    isReady = true;
+    dynamicLock.Unlock(1);
+    dynamicLock.NotifyValue(1);
+    waiter.join();
+    // main thread is the first one
+    uint64_t waiterIndex = 0;
+    for (auto& event : tracer.Events())
+    {
+        if(event.LockId == reinterpret_cast<uintptr_t>(&dynamicLock.Inner()) && event.ThreadIndex != 1)
+            waiterIndex = event.ThreadIndex;
+    }
+    TEST_CHECK_STAGE((PhasesOf(tracer, &dynamicLock.Inner(), 1) == std::vector<Phase>{
+        Phase::Request, Phase::Acquired, Phase::Released, Phase::Request, Phase::Acquired, Phase::Released}));
+    TEST_CHECK_STAGE(waiterIndex && (PhasesOf(tracer, &dynamicLock.Inner(), waiterIndex) == std::vector<Phase>{
+        Phase::Request, Phase::Acquired, Phase::Released, Phase::Request, Phase::Acquired, Phase::Released}));
+    return TEST_SUCCESS;
+}
+
+
+int main()
+{
+    TEST_VERIFY(VLT_test_events());
+    //
+    TEST_VERIFY(VLT_test_ring_buffer());
+    //
+    TEST_VERIFY(VLT_test_variants());
+    //
+    TEST_VERIFY(VLT_test_modes());
+    //
+    TEST_VERIFY(VLT_test_no_throw());
+
+    std::cout << '\n' << Testing::TestsFailed << " subtests failed\n";
+
+    return Testing::TestsFailed;
+}
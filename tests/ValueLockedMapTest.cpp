@@ -0,0 +1,183 @@
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <random>
+
+
+#define TEST_IGNORE_PRINT_ON_SUCCESS
+
+#define TEST_SETW_VALUE 65
+
+#include "NickSV/Tools/ValueLockedMap.h"
+#include "NickSV/Tools/Testing.h"
+
+
+constexpr static size_t threadC = 16;
+constexpr static uint32_t keyC = 200;
+
+struct Account
+{
+    uint32_t Owner = 0;
+    uint64_t Balance = 0;
+};
+
+using AccountMap = NickSV::Tools::ValueLockedMap<uint32_t, Account, 4>;
+
+// Counts mapped values alive, erased ones included until they are freed
+struct Tracked
+{
+    static std::atomic<int> Alive;
+    Tracked() { ++Alive; }
+    ~Tracked() { --Alive; }
+};
+std::atomic<int> Tracked::Alive{0};
+
+
+static int VLM_test_access()
+{
+    NickSV::Tools::ValueLockedMap<std::string, int> mapCounters(1);
+    TEST_CHECK_STAGE(mapCounters.Size() == 0);
+    TEST_CHECK_STAGE(!mapCounters.Find("a"));
+    TEST_CHECK_STAGE(!mapCounters.Contains("a"));
+
+    *mapCounters.Access("a") += 2;
+    ++*mapCounters.Access("a");
+    {
+        auto accessor = mapCounters.Access("b");
+        TEST_CHECK_STAGE(accessor.Key() == "b");
+        TEST_CHECK_STAGE(*accessor == 0);
+        *accessor = 7;
+    }
+    TEST_CHECK_STAGE(mapCounters.Size() == 2);
+    TEST_CHECK_STAGE(mapCounters.Contains("a"));
+    TEST_CHECK_STAGE(*mapCounters.Find("a") == 3);
+    TEST_CHECK_STAGE(*mapCounters.Find("b") == 7);
+
+    // rehash from single bucket keeps everything
+    for (int i = 0; i < 100; ++i)
+        *mapCounters.Access(std::to_string(i)) = i;
+    TEST_CHECK_STAGE(mapCounters.Size() == 102);
+    for (int i = 0; i < 100; ++i)
+    {
+        auto accessor = mapCounters.Find(std::to_string(i));
+        TEST_CHECK_STAGE(accessor && *accessor == i);
+    }
+
+    TEST_CHECK_STAGE(mapCounters.Erase("a"));
+    TEST_CHECK_STAGE(!mapCounters.Erase("a"));
+    TEST_CHECK_STAGE(!mapCounters.Find("a"));
+    TEST_CHECK_STAGE(mapCounters.Size() == 101);
+    TEST_CHECK_STAGE(*mapCounters.Access("a") == 0);
+
+    // key stays locked while accessor lives
+    auto accessor = mapCounters.Access("b");
+    std::atomic<bool> isErased{false};
+    std::thread eraser([&]() noexcept { isErased = mapCounters.Erase("b"); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    TEST_CHECK_STAGE(!isErased);
+    accessor.Release();
+    eraser.join();
+    TEST_CHECK_STAGE(isErased);
+    TEST_CHECK_STAGE(!mapCounters.Contains("b"));
+
+    int sum = 0;
+    size_t count = 0;
+    mapCounters.ForEachExclusive([&](const std::string&, int& value) { sum += value; ++count; });
+    TEST_CHECK_STAGE(count == mapCounters.Size());
+    TEST_CHECK_STAGE(sum == 99 * 100 / 2);
+    return TEST_SUCCESS;
+}
+
+static int VLM_test_concurrent()
+{
+    AccountMap mapAccounts(2);
+    std::atomic<uint32_t> errors{0};
+    std::atomic<bool> isRunning{true};
+    std::vector<std::thread> threads;
+    for (uint32_t th = 1; th <= threadC; ++th)
+        threads.emplace_back([&, th]() noexcept
+        {
+            std::mt19937 gen(th);
+            std::uniform_int_distribution<uint32_t> dist(0, keyC - 1);
+            for (size_t i = 0; i < 5000; ++i)
+            {
+                uint32_t key = dist(gen);
+                if(i % 16 == 0)
+                {
+                    mapAccounts.Erase(key);
+                    continue;
+                }
+                auto accessor = mapAccounts.Access(key);
+                if(accessor->Owner) ++errors;
+                accessor->Owner = th;
+                ++accessor->Balance;
+                std::this_thread::yield();
+                if(accessor->Owner != th) ++errors;
+                accessor->Owner = 0;
+            }
+        });
+    std::thread iterator([&]() noexcept
+    {
+        while (isRunning)
+        {
+            size_t count = 0;
+            mapAccounts.ForEachExclusive([&](const uint32_t& key, Account& account)
+            {
+                if(key >= keyC || account.Owner) ++errors;
+                ++count;
+            });
+            if(count > keyC) ++errors;
+            std::this_thread::yield();
+        }
+    });
+    for (auto& thread : threads)
+        thread.join();
+    isRunning = false;
+    iterator.join();
+    TEST_CHECK_STAGE(errors == 0);
+    TEST_CHECK_STAGE(mapAccounts.Size() <= keyC);
+
+    size_t count = 0;
+    mapAccounts.ForEachExclusive([&](const uint32_t&, Account&) { ++count; });
+    TEST_CHECK_STAGE(count == mapAccounts.Size());
+    return TEST_SUCCESS;
+}
+
+static int VLM_test_reclaim()
+{
+    NickSV::Tools::ValueLockedMap<uint32_t, Tracked, 1> mapTracked;
+    // Held accessor with a waiter on the same shard
+    auto accessor = mapTracked.Access(0);
+    std::thread waiter([&]() noexcept { mapTracked.Find(0); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    for (uint32_t key = 1; key <= 1000; ++key)
+    {
+        mapTracked.Access(key);
+        mapTracked.Erase(key);
+    }
+    const int aliveCount = Tracked::Alive;
+    accessor.Release();
+    waiter.join();
+    TEST_CHECK_STAGE(aliveCount < 10);
+    TEST_CHECK_STAGE(mapTracked.Erase(0));
+    TEST_CHECK_STAGE(Tracked::Alive == 0);
+    return TEST_SUCCESS;
+}
+
+
+int main()
+{
+    using namespace NickSV::Tools;
+
+    TEST_VERIFY(VLM_test_access());
+    //
+    TEST_VERIFY(VLM_test_concurrent());
+    //
+    TEST_VERIFY(VLM_test_reclaim());
+
+    std::cout << '\n' << Testing::TestsFailed << " subtests failed\n";
+
+    return Testing::TestsFailed;
+}
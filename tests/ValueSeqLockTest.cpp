@@ -0,0 +1,117 @@
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <vector>
+
+
+#define TEST_IGNORE_PRINT_ON_SUCCESS
+
+#define TEST_SETW_VALUE 65
+
+#include "NickSV/Tools/ValueSeqLock.h"
+#include "NickSV/Tools/Testing.h"
+
+
+constexpr static size_t threadC = 8;
+
+// Relaxed atomics keep torn reads defined behaviour
+struct Record
+{
+    std::atomic<uint64_t> first{0};
+    std::atomic<uint64_t> second{0};
+};
+
+template<class LockT>
+int VSL_test_consistent_reads()
+{
+    LockT vLock;
+    Record records[2];
+    std::atomic<bool> stop{false};
+    std::atomic<uint32_t> inconsistent{0};
+    std::atomic<uint64_t> reads{0};
+
+    std::thread writers[2];
+    for (uint32_t value = 0; value < 2; ++value)
+    {
+        writers[value] = std::thread([&, value]()
+        {
+            for (uint64_t i = 1; i <= 20000; ++i)
+            {
+                NickSV::Tools::ValueLockGuard<LockT> vLockGuard(vLock, value);
+                records[value].first.store(i, std::memory_order_relaxed);
+                records[value].second.store(i, std::memory_order_relaxed);
+            }
+        });
+    }
+    std::vector<std::thread> readers;
+    for (uint32_t i = 0; i < threadC; ++i)
+    {
+        readers.emplace_back([&, i]()
+        {
+            uint32_t value = i % 2;
+            while(!stop.load())
+            {
+                bool ok = vLock.Read(value, [&]
+                {
+                    return records[value].first.load(std::memory_order_relaxed) ==
+                           records[value].second.load(std::memory_order_relaxed);
+                });
+                if(!ok)
+                    ++inconsistent;
+                ++reads;
+            }
+        });
+    }
+    for (auto& writer : writers)
+        writer.join();
+    stop = true;
+    for (auto& reader : readers)
+        reader.join();
+    TEST_CHECK_STAGE(inconsistent == 0);
+    TEST_CHECK_STAGE(reads > 0);
+    TEST_CHECK_STAGE(records[0].first == 20000 && records[1].second == 20000);
+    return TEST_SUCCESS;
+}
+
+static int VSL_test_validation()
+{
+    NickSV::Tools::ValueSeqLock<uint32_t> vLock;
+
+    auto seq = vLock.ReadBegin(1);
+    TEST_CHECK_STAGE(!vLock.ReadRetry(1, seq));
+    TEST_CHECK_STAGE(vLock.TryLock(1));
+    TEST_CHECK_STAGE(vLock.ReadRetry(1, seq));
+    vLock.Unlock(1);
+    TEST_CHECK_STAGE(vLock.ReadRetry(1, seq));
+    seq = vLock.ReadBegin(1);
+    TEST_CHECK_STAGE(!vLock.ReadRetry(1, seq));
+
+    vLock.LockAll();
+    vLock.UnlockAll(2);
+    seq = vLock.ReadBegin(1);
+    TEST_CHECK_STAGE(!vLock.ReadRetry(1, seq));
+    vLock.Unlock(2);
+    seq = vLock.ReadBegin(2);
+    TEST_CHECK_STAGE(!vLock.ReadRetry(2, seq));
+
+    int calls = 0;
+    vLock.Read(1, [&calls]{ ++calls; });
+    TEST_CHECK_STAGE(calls == 1);
+    return TEST_SUCCESS;
+}
+
+
+int main()
+{
+    using namespace NickSV::Tools;
+
+    TEST_VERIFY(VSL_test_validation());
+    //
+    TEST_VERIFY(VSL_test_consistent_reads<ValueSeqLock<uint32_t>>());
+    //
+    TEST_VERIFY((VSL_test_consistent_reads<ValueSeqLock<uint32_t, 1, ValueLock<uint32_t, threadC>>>()));
+
+    std::cout << '\n' << Testing::TestsFailed << " subtests failed\n";
+
+    return Testing::TestsFailed;
+}